@@ -28,6 +28,8 @@
 #include <stdio.h>
 #include <iostream>
 #include <fstream>
+#include <list>
+#include <vector>
 
 using namespace std;
 
@@ -40,11 +42,81 @@ using namespace std;
 #include "compiler/compile_common.h"
 
 #include "backend/ideprint.h"
+#include "compiler/reshandlers/rectpack.h"
+#include "settings.h"
 
 inline void writei(int x, FILE *f) {
   fwrite(&x,4,1,f);
 }
 
+using namespace rect_packer;
+
+static void free_plane(rectpnode *node) {
+  if (!node) return;
+  free_plane(node->child[0]);
+  free_plane(node->child[1]);
+  delete node;
+}
+
+static int pow2_at_least(int x) {
+  int r = 1;
+  while (r < x) r <<= 1;
+  return r;
+}
+
+// Packs the subimages of every sprite into shared atlas pages, so that drawing different sprites does not
+// switch textures. Each subimage gets a box; placed is its page, or -1 if it keeps a texture of its own,
+// and x, y are where it goes inside the padding left around it. Subimages more than half a page across
+// on either side would leave little room to share, so they are left alone.
+static void plan_sprite_atlas(EnigmaStruct *es, vector<pvrect> &boxes, vector<int> &pagew, vector<int> &pageh)
+{
+  const int page = setting::atlas_page_size, pad = setting::atlas_padding > 0 ? setting::atlas_padding : 0;
+
+  typedef pair<int, unsigned> sizepair; // Gives subimage no by area of its box (<area, subimage>)
+  list<sizepair> box_order;
+  for (int i = 0; i < es->spriteCount; i++)
+    for (int ii = 0; ii < es->sprites[i].subImageCount; ii++)
+    {
+      const Image &image = es->sprites[i].subImages[ii].image;
+      const pvrect box(0, 0, image.width + 2*pad, image.height + 2*pad, -1);
+      if (page and box.w <= page/2 and box.h <= page/2)
+        box_order.push_back(sizepair(box.w * box.h, boxes.size()));
+      boxes.push_back(box);
+    }
+  if (box_order.empty()) return;
+  box_order.sort();
+
+  // First fit, largest to smallest, opening a new page when none of the others has room
+  vector<rectpnode*> planes;
+  for (list<sizepair>::reverse_iterator ii = box_order.rbegin(); ii != box_order.rend(); ii++)
+  {
+    rectpnode *nn = NULL;
+    size_t p;
+    for (p = 0; p < planes.size() and !nn; p++)
+      nn = rninsert(planes[p], ii->second, &boxes[0]);
+    if (!nn) {
+      planes.push_back(new rectpnode(0, 0, page, page));
+      nn = rninsert(planes.back(), ii->second, &boxes[0]);
+      p = planes.size();
+    }
+    boxes[ii->second].x = nn->x + pad;
+    boxes[ii->second].y = nn->y + pad;
+    boxes[ii->second].placed = p - 1;
+  }
+
+  // Trim each page down to the power of two that holds what was placed on it
+  pagew.assign(planes.size(), 1);
+  pageh.assign(planes.size(), 1);
+  for (size_t i = 0; i < boxes.size(); i++)
+    if (boxes[i].placed != -1) {
+      const int p = boxes[i].placed;
+      pagew[p] = max(pagew[p], pow2_at_least(boxes[i].x + boxes[i].w - pad));
+      pageh[p] = max(pageh[p], pow2_at_least(boxes[i].y + boxes[i].h - pad));
+    }
+  for (size_t p = 0; p < planes.size(); p++)
+    free_plane(planes[p]);
+}
+
 #include "languages/lang_CPP.h"
 int lang_CPP::module_write_sprites(EnigmaStruct *es, FILE *gameModule)
 {
@@ -64,6 +136,31 @@ int lang_CPP::module_write_sprites(EnigmaStruct *es, FILE *gameModule)
       sprite_maxid = es->sprites[i].id;
   fwrite(&sprite_maxid,4,1,gameModule);
   
+  vector<pvrect> boxes;
+  vector<int> pagew, pageh;
+  plan_sprite_atlas(es, boxes, pagew, pageh);
+  
+  long long atlas_area = 0, packed_area = 0;
+  size_t packed = 0;
+  for (size_t p = 0; p < pagew.size(); p++)
+    atlas_area += (long long)pagew[p] * pageh[p];
+  for (size_t b = 0; b < boxes.size(); b++)
+    if (boxes[b].placed != -1)
+      packed++, packed_area += (long long)(boxes[b].w - 2*setting::atlas_padding) * (boxes[b].h - 2*setting::atlas_padding);
+  if (packed)
+    user << "Packed " << (int)packed << " of " << (int)boxes.size() << " sprite subimages into " << (int)pagew.size()
+         << " atlas pages, " << (int)(100 * packed_area / atlas_area) << "% filled." << flushl;
+  for (size_t p = 0; p < pagew.size(); p++)
+    edbg << "Atlas page " << (int)p << ": " << pagew[p] << "x" << pageh[p] << flushl;
+  
+  // Atlas pages: how many, how subimages are padded in them, and their sizes
+  writei(pagew.size(), gameModule);
+  writei(setting::atlas_padding > 0 ? setting::atlas_padding : 0, gameModule);
+  writei(setting::atlas_extrude, gameModule);
+  for (size_t p = 0; p < pagew.size(); p++)
+    writei(pagew[p], gameModule), writei(pageh[p], gameModule);
+  
+  size_t box = 0;
   for (int i = 0; i < sprite_count; i++)
   {
     writei(es->sprites[i].id,gameModule); //id
@@ -103,6 +200,10 @@ int lang_CPP::module_write_sprites(EnigmaStruct *es, FILE *gameModule)
     for (int ii = 0;ii < subCount; ii++)
     {
       //strans = es->sprites[i].subImages[ii].transColor, fwrite(&idttrans,4,1,exe); //Transparent color
+      writei(boxes[box].placed,gameModule); //atlas page, or -1
+      writei(boxes[box].x,gameModule);
+      writei(boxes[box].y,gameModule);
+      box++;
       writei(swidth * sheight * 4,gameModule); //size when unpacked
       writei(es->sprites[i].subImages[ii].image.dataSize,gameModule); //size when unpacked
       fwrite(es->sprites[i].subImages[ii].image.data, 1, es->sprites[i].subImages[ii].image.dataSize, gameModule); //sprite data
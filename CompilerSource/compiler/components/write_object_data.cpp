@@ -92,7 +92,6 @@ static inline void declare_extension_casts(std::ostream &wto) {
 }
 
 static inline void declare_object_locals_class(std::ostream &wto) {
-  wto << "  extern std::map<int,object_basic*> instance_deactivated_list;\n";
   wto << "  extern objectstruct** objectdata;\n\n";
 
   wto << "  struct object_locals: event_parent";
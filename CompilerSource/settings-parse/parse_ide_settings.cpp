@@ -150,6 +150,11 @@ void parse_ide_settings(const char* eyaml)
   setting::automatic_semicolons   = settree.get("automatic-semicolons").toBool();
   setting::keyword_blacklist = settree.get("keyword-blacklist").toString();
 
+  const int atlas_size = settree.get("texture-atlas-size").toInt(); // None, 512, 1024, 2048, 4096
+  setting::atlas_page_size = atlas_size > 0 ? 256 << atlas_size : 0;
+  setting::atlas_padding   = settree.get("texture-atlas-padding").toInt();
+  setting::atlas_extrude   = settree.get("texture-atlas-extrude").toBool();
+
   // Use a platform-specific make directory.
   std::string make_directory = "./ENIGMA/";
 #if CURRENT_PLATFORM_ID == OS_WINDOWS
@@ -47,4 +47,9 @@ namespace setting
   bool automatic_semicolons = 0; // Determines whether semicolons should automatically be added or if the user wants strict syntax
   COMPLIANCE_LVL compliance_mode = COMPL_STANDARD;
   string keyword_blacklist = "";
+
+  //Resource options
+  int atlas_page_size = 0;
+  int atlas_padding = 0;
+  bool atlas_extrude = 0;
 }
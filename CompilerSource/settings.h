@@ -71,6 +71,11 @@ namespace setting
   extern bool automatic_semicolons; // Determines whether semicolons should automatically be added or if the user wants strict syntax
   extern COMPLIANCE_LVL compliance_mode; // How to resolve differences between GM versions.
   extern string keyword_blacklist; //Words to blacklist from user scripts, separated by commas.
+
+  //Resource options
+  extern int atlas_page_size;   // Largest side of the atlas pages sprites are packed into; 0 gives every subimage its own texture
+  extern int atlas_padding;     // Pixels left around each subimage in an atlas page
+  extern bool atlas_extrude;    // Whether that padding repeats the subimage's edge pixels rather than staying transparent
 }
 
 #endif
@@ -0,0 +1,289 @@
+/** Copyright (C) 2026 The ENIGMA Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "Universal_System/instance_system.h"
+#include "Universal_System/callbacks_events.h"
+
+#include "BBOXgrid.h"
+
+namespace enigma
+{
+  extern int maxid;
+  extern size_t object_idmax;
+
+  struct grid_record {
+    object_collisions *inst;
+    int id;          // Checked against the instance list before inst is touched
+    unsigned stamp;  // The last query to visit this record
+    unsigned synced; // The last grid_sync() to find the instance
+    int cx1, cy1, cx2, cy2; // The cells it is filed in; cx1 > cx2 when on the side list
+  };
+
+  // Instances spanning more cells than this on either axis are kept on a side list.
+  static const int grid_max_span = 64;
+  // With fewer instances than this to search, walking the instance list is cheaper.
+  static const size_t grid_min_instances = 32;
+
+  static int grid_cell_size = 0; // Zero while the broadphase is disabled
+  static bool grid_stale = true;
+  static size_t grid_filed_count = 0; // Active instances at the last grid_sync()
+  static int grid_filed_maxid = 0;     // Every instance with a lower ID existed at the last grid_sync()
+  static bool grid_callbacks_registered = false;
+  static std::unordered_map<long long, std::vector<unsigned> > grid_cells;
+  static std::vector<grid_record> grid_records;
+  static std::vector<unsigned> grid_free_records;
+  static std::unordered_map<int, unsigned> grid_record_of; // Instance ID to its record
+  static std::vector<unsigned> grid_unbinned; // Oversized instances, and those without a mask
+  static unsigned grid_query_stamp = 0;
+  static unsigned grid_sync_stamp = 0;
+
+  // Candidate lists, one per nesting level, since events fired mid-query can query again.
+  static std::vector<std::vector<object_collisions*>*> grid_results;
+  static size_t grid_result_depth = 0;
+
+  static inline int grid_cell(int v) {
+    return v >= 0 ? v / grid_cell_size : -((-v - 1) / grid_cell_size) - 1;
+  }
+  static inline long long grid_key(int cx, int cy) {
+    return (long long)((unsigned long long)(unsigned)cx << 32 | (unsigned)cy);
+  }
+
+  static void grid_remove_index(std::vector<unsigned> &list, unsigned index) {
+    std::vector<unsigned>::iterator it = std::find(list.begin(), list.end(), index);
+    if (it != list.end()) {
+      *it = list.back();
+      list.pop_back();
+    }
+  }
+
+  static void grid_unfile(unsigned index)
+  {
+    const grid_record &rec = grid_records[index];
+    if (rec.cx1 > rec.cx2) {
+      grid_remove_index(grid_unbinned, index);
+      return;
+    }
+    for (int cy = rec.cy1; cy <= rec.cy2; ++cy)
+      for (int cx = rec.cx1; cx <= rec.cx2; ++cx)
+        grid_remove_index(grid_cells[grid_key(cx, cy)], index);
+  }
+
+  // The cells an instance's current bounding box covers; cx1 > cx2 if it belongs on the side list.
+  static void grid_span(object_collisions *inst, int &cx1, int &cy1, int &cx2, int &cy2)
+  {
+    cx1 = 0, cx2 = -1, cy1 = cy2 = 0;
+    if (inst->sprite_index == -1 && inst->mask_index == -1)
+      return;
+    const world_bbox_t &box = inst->$bbox_world();
+    const int l = grid_cell(box.left), r = grid_cell(box.right), t = grid_cell(box.top), b = grid_cell(box.bottom);
+    if (r - l >= grid_max_span || b - t >= grid_max_span)
+      return;
+    cx1 = l, cy1 = t, cx2 = r, cy2 = b;
+  }
+
+  // Files an instance under its current bounding box, replacing any earlier filing.
+  static void grid_file(object_collisions *inst)
+  {
+    int cx1, cy1, cx2, cy2;
+    grid_span(inst, cx1, cy1, cx2, cy2);
+
+    unsigned index;
+    std::unordered_map<int, unsigned>::iterator known = grid_record_of.find(inst->id);
+    if (known != grid_record_of.end()) {
+      index = known->second;
+      grid_record &rec = grid_records[index];
+      rec.inst = inst, rec.synced = grid_sync_stamp;
+      if (rec.cx1 == cx1 && rec.cy1 == cy1 && rec.cx2 == cx2 && rec.cy2 == cy2)
+        return;
+      grid_unfile(index);
+    } else {
+      if (grid_free_records.empty()) {
+        index = grid_records.size();
+        grid_records.push_back(grid_record());
+      } else {
+        index = grid_free_records.back();
+        grid_free_records.pop_back();
+      }
+      grid_record_of[inst->id] = index;
+    }
+
+    grid_record &rec = grid_records[index];
+    rec.inst = inst, rec.id = inst->id, rec.stamp = 0, rec.synced = grid_sync_stamp;
+    rec.cx1 = cx1, rec.cy1 = cy1, rec.cx2 = cx2, rec.cy2 = cy2;
+    if (cx1 > cx2) {
+      grid_unbinned.push_back(index);
+      return;
+    }
+    for (int cy = cy1; cy <= cy2; ++cy)
+      for (int cx = cx1; cx <= cx2; ++cx)
+        grid_cells[grid_key(cx, cy)].push_back(index);
+  }
+
+  static void grid_forget(unsigned index)
+  {
+    grid_unfile(index);
+    grid_record_of.erase(grid_records[index].id);
+    grid_records[index].inst = NULL;
+    grid_records[index].id = -1;
+    grid_free_records.push_back(index);
+  }
+
+  // Drops every filing, for a new cell size or after instances have wandered far apart.
+  static void grid_clear()
+  {
+    grid_cells.clear();
+    grid_records.clear();
+    grid_free_records.clear();
+    grid_record_of.clear();
+    grid_unbinned.clear();
+  }
+
+  // Brings the grid up to date with the active instances. Instances whose bounding box still
+  // covers the cells they are filed in are left alone; the rest are moved between cells, and the
+  // records of destroyed or deactivated instances are dropped.
+  static void grid_sync()
+  {
+    // Moving instances leave empty buckets behind; start over once they far outnumber the instances.
+    if (grid_cells.size() > 4 * grid_record_of.size() + 1024)
+      grid_clear();
+
+    ++grid_sync_stamp;
+    for (iterator it = instance_list_first(); it; ++it)
+      grid_file((object_collisions*)*it);
+    for (unsigned i = 0; i < grid_records.size(); ++i)
+      if (grid_records[i].inst && grid_records[i].synced != grid_sync_stamp)
+        grid_forget(i);
+
+    grid_filed_count = instance_list.size();
+    grid_filed_maxid = maxid;
+    grid_stale = false;
+  }
+
+  static void grid_mark_stale() {
+    grid_stale = true;
+  }
+
+  static inline bool grid_selects(const object_collisions *inst, int object) {
+    return object == enigma_user::all || inst->object_index == object || inst->can_cast(object);
+  }
+
+  static inline void grid_visit(unsigned index, int object, std::vector<object_collisions*> &out)
+  {
+    grid_record &rec = grid_records[index];
+    if (rec.stamp == grid_query_stamp) return;
+    rec.stamp = grid_query_stamp;
+    if (fetch_instance_by_id(rec.id) != rec.inst) return; // Destroyed or deactivated since filing
+    if (grid_selects(rec.inst, object))
+      out.push_back(rec.inst);
+  }
+
+  static bool grid_id_less(const object_collisions *a, const object_collisions *b) {
+    return a->id < b->id;
+  }
+
+  collision_candidates::collision_candidates(int object, int left, int top, int right, int bottom):
+      it(), found(NULL), pos(0)
+  {
+    size_t searched = 0;
+    if (object == enigma_user::all) searched = instance_list.size();
+    else if (object >= 0 && size_t(object) < object_idmax) searched = objects[object].count;
+
+    if (!grid_cell_size || searched < grid_min_instances) {
+      it = fetch_inst_iter_by_int(object);
+      return;
+    }
+
+    // Instances created since the last sync raise maxid; destroying, activating or deactivating
+    // instances changes the count.
+    if (grid_stale || grid_filed_maxid != maxid || grid_filed_count != instance_list.size())
+      grid_sync();
+
+    if (grid_result_depth == grid_results.size())
+      grid_results.push_back(new std::vector<object_collisions*>());
+    found = grid_results[grid_result_depth++];
+    found->clear();
+    ++grid_query_stamp;
+
+    const int cx1 = grid_cell(left), cx2 = grid_cell(right), cy1 = grid_cell(top), cy2 = grid_cell(bottom);
+    if (double(cx2 - cx1 + 1) * double(cy2 - cy1 + 1) > double(grid_record_of.size())) {
+      // The query covers more cells than there are instances; just check them all.
+      for (unsigned i = 0; i < grid_records.size(); ++i)
+        if (grid_records[i].inst) grid_visit(i, object, *found);
+    } else {
+      for (int cy = cy1; cy <= cy2; ++cy)
+        for (int cx = cx1; cx <= cx2; ++cx) {
+          std::unordered_map<long long, std::vector<unsigned> >::const_iterator cell = grid_cells.find(grid_key(cx, cy));
+          if (cell == grid_cells.end()) continue;
+          for (size_t i = 0; i < cell->second.size(); ++i)
+            grid_visit(cell->second[i], object, *found);
+        }
+      for (size_t i = 0; i < grid_unbinned.size(); ++i)
+        grid_visit(grid_unbinned[i], object, *found);
+    }
+    std::sort(found->begin(), found->end(), grid_id_less);
+  }
+
+  collision_candidates::~collision_candidates() {
+    if (found) --grid_result_depth;
+  }
+
+  object_collisions* collision_candidates::next()
+  {
+    if (!found) {
+      if (!it) return NULL;
+      object_collisions *const inst = (object_collisions*)*it;
+      ++it;
+      return inst;
+    }
+    while (pos < found->size()) {
+      object_collisions *const inst = (*found)[pos++];
+      if (fetch_instance_by_id(inst->id) == inst) // Skip those destroyed by an earlier candidate
+        return inst;
+    }
+    return NULL;
+  }
+}
+
+namespace enigma_user
+{
+  void collision_broadphase_enable(int cell_size)
+  {
+    enigma::grid_cell_size = cell_size > 0 ? cell_size : 1;
+    enigma::grid_clear();
+    enigma::grid_stale = true;
+    if (!enigma::grid_callbacks_registered) {
+      enigma::register_callback_before_collision_event(enigma::grid_mark_stale);
+      enigma::register_callback_clean_up_roomend(enigma::grid_mark_stale);
+      enigma::grid_callbacks_registered = true;
+    }
+  }
+
+  void collision_broadphase_disable()
+  {
+    enigma::grid_cell_size = 0;
+    enigma::grid_clear();
+    enigma::grid_stale = true;
+  }
+
+  void collision_broadphase_update() {
+    enigma::grid_stale = true;
+  }
+}
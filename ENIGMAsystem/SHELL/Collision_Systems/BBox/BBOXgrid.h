@@ -0,0 +1,58 @@
+/** Copyright (C) 2026 The ENIGMA Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+////////////////////////////////////
+// Broadphase for the collision implementation functions. Off by default; when enabled with
+// collision_broadphase_enable(), instance bounding boxes are filed in a uniform grid of square
+// cells so that a query only visits instances filed in the cells its rectangle touches.
+//
+// Instance positions are plain fields with no write hook, so the grid is brought up to date in
+// one pass instead: on the first query of each step's collision handling, after a room change,
+// after collision_broadphase_update(), and whenever instances have been created, destroyed,
+// activated or deactivated since the last pass. The pass only moves instances whose bounding box
+// left the cells they were filed in. Candidates are always tested against their current bounding
+// box, so an instance moved by code since the last pass is only missed if it has left its filed
+// cells; call collision_broadphase_update() after such moves to have them seen within the event.
+////////////////////////////////////
+
+#ifndef ENIGMA_BBOX_GRID_H
+#define ENIGMA_BBOX_GRID_H
+
+#include "Universal_System/collisions_object.h"
+#include "Universal_System/instance_iterator.h"
+#include <vector>
+#include "BBOXgridfuncs.h"
+
+namespace enigma
+{
+  // Walks the instances selected by an object index, ID or keyword that may overlap the given
+  // world rectangle. With the grid enabled and enough instances to search, only instances filed
+  // near the rectangle are visited, in order of ID; otherwise every selected instance is.
+  class collision_candidates
+  {
+    iterator it;
+    std::vector<object_collisions*> *found;
+    size_t pos;
+
+   public:
+    collision_candidates(int object, int left, int top, int right, int bottom);
+    ~collision_candidates();
+    object_collisions* next();
+  };
+}
+
+#endif
@@ -0,0 +1,30 @@
+/** Copyright (C) 2026 The ENIGMA Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_BBOX_GRID_FUNCS_H
+#define ENIGMA_BBOX_GRID_FUNCS_H
+
+namespace enigma_user
+{
+  // Turns on the uniform-grid broadphase for collision queries, with square cells of the given size in pixels.
+  void collision_broadphase_enable(int cell_size);
+  void collision_broadphase_disable();
+  // Refiles moved instances before the next query; call after moving instances by code mid-step.
+  void collision_broadphase_update();
+}
+
+#endif
@@ -26,38 +26,10 @@
 
 #include "BBOXutil.h"
 #include "BBOXimpl.h"
+#include "BBOXgrid.h"
 #include <cmath>
 #include <floatcomp.h>
 
-static inline void get_border(int *leftv, int *rightv, int *topv, int *bottomv, int left, int top, int right, int bottom, double x, double y, double xscale, double yscale, double angle)
-{
-    if (fzero(angle))
-    {
-        const bool xsp = (xscale >= 0), ysp = (yscale >= 0);
-        const double lsc = left*xscale, rsc = (right+1)*xscale-1, tsc = top*yscale, bsc = (bottom+1)*yscale-1;
-
-        *leftv   = (xsp ? lsc : rsc) + x + .5;
-        *rightv  = (xsp ? rsc : lsc) + x + .5;
-        *topv    = (ysp ? tsc : bsc) + y + .5;
-        *bottomv = (ysp ? bsc : tsc) + y + .5;
-    }
-    else
-    {
-        const double arad = angle*(M_PI/180.0);
-        const double sina = sin(arad), cosa = cos(arad);
-        const double lsc = left*xscale, rsc = (right+1)*xscale-1, tsc = top*yscale, bsc = (bottom+1)*yscale-1;
-        const int quad = int(fmod(fmod(angle, 360) + 360, 360)/90.0);
-        const bool xsp = (xscale >= 0), ysp = (yscale >= 0),
-                   q12 = (quad == 1 || quad == 2), q23 = (quad == 2 || quad == 3),
-                   xs12 = xsp^q12, sx23 = xsp^q23, ys12 = ysp^q12, ys23 = ysp^q23;
-
-        *leftv   = cosa*(xs12 ? lsc : rsc) + sina*(ys23 ? tsc : bsc) + x + .5;
-        *rightv  = cosa*(xs12 ? rsc : lsc) + sina*(ys23 ? bsc : tsc) + x + .5;
-        *topv    = cosa*(ys12 ? tsc : bsc) - sina*(sx23 ? rsc : lsc) + y + .5;
-        *bottomv = cosa*(ys12 ? bsc : tsc) - sina*(sx23 ? lsc : rsc) + y + .5;
-    }
-}
-
 static inline int min(int x, int y) { return x<y? x : y; }
 static inline double min(double x, double y) { return x<y? x : y; }
 static inline int max(int x, int y) { return x>y? x : y; }
@@ -79,9 +51,9 @@ enigma::object_collisions* const collide_inst_inst(int object, bool solid_only,
 
     get_border(&left1, &right1, &top1, &bottom1, box.left, box.top, box.right, box.bottom, x, y, xscale1, yscale1, ia1);
 
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    enigma::collision_candidates candidates(object, left1, top1, right1, bottom1);
+    for (enigma::object_collisions* inst2; (inst2 = candidates.next()); )
     {
-        enigma::object_collisions* const inst2 = (enigma::object_collisions*)*it;
         if (notme && inst2->id == inst1->id)
             continue;
         if (solid_only && !inst2->solid)
@@ -89,12 +61,8 @@ enigma::object_collisions* const collide_inst_inst(int object, bool solid_only,
         if (inst2->sprite_index == -1 && inst2->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box2 = inst2->$bbox_relative();
-        const double x2 = inst2->x, y2 = inst2->y,
-                     xscale2 = inst2->image_xscale, yscale2 = inst2->image_yscale,
-                     ia2 = inst2->image_angle;
-        int left2, top2, right2, bottom2;
-        get_border(&left2, &right2, &top2, &bottom2, box2.left, box2.top, box2.right, box2.bottom, x2, y2, xscale2, yscale2, ia2);
+        const enigma::world_bbox_t &box2 = inst2->$bbox_world();
+        const int left2 = box2.left, top2 = box2.top, right2 = box2.right, bottom2 = box2.bottom;
 
         if (left1 <= right2 && left2 <= right1 && top1 <= bottom2 && top2 <= bottom1)
             return inst2;
@@ -115,9 +83,9 @@ enigma::object_collisions* const collide_inst_rect(int object, bool solid_only,
         y1 = y3;
     }
 
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    enigma::collision_candidates candidates(object, x1, y1, x2, y2);
+    for (enigma::object_collisions* inst; (inst = candidates.next()); )
     {
-        enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (notme && inst->id == enigma::instance_event_iterator->inst->id)
             continue;
         if (solid_only && !inst->solid)
@@ -125,12 +93,8 @@ enigma::object_collisions* const collide_inst_rect(int object, bool solid_only,
          if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
-        const double x = inst->x, y = inst->y,
-                     xscale = inst->image_xscale, yscale = inst->image_yscale,
-                     ia = inst->image_angle;
-        int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        const enigma::world_bbox_t &box = inst->$bbox_world();
+        const int left = box.left, top = box.top, right = box.right, bottom = box.bottom;
 
         if (left <= x2 && x1 <= right && top <= y2 && y1 <= bottom)
             return inst;
@@ -144,9 +108,9 @@ enigma::object_collisions* const collide_inst_line(int object, bool solid_only,
     if (x1 == x2 && y1 == y2)
         return collide_inst_point(object, solid_only, notme, x1, y1);
 
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    enigma::collision_candidates candidates(object, min(x1,x2), min(y1,y2), max(x1,x2), max(y1,y2));
+    for (enigma::object_collisions* inst; (inst = candidates.next()); )
     {
-        enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (notme && inst->id == enigma::instance_event_iterator->inst->id)
             continue;
         if (solid_only && !inst->solid)
@@ -154,12 +118,8 @@ enigma::object_collisions* const collide_inst_line(int object, bool solid_only,
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
-        const double x = inst->x, y = inst->y,
-                     xscale = inst->image_xscale, yscale = inst->image_yscale,
-                     ia = inst->image_angle;
-        int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        const enigma::world_bbox_t &box = inst->$bbox_world();
+        const int left = box.left, top = box.top, right = box.right, bottom = box.bottom;
 
         double minX = max(min(x1,x2),left);
         double maxX = min(max(x1,x2),right);
@@ -202,9 +162,9 @@ enigma::object_collisions* const collide_inst_line(int object, bool solid_only,
 
 enigma::object_collisions* const collide_inst_point(int object, bool solid_only, bool notme, int x1, int y1)
 {
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    enigma::collision_candidates candidates(object, x1, y1, x1, y1);
+    for (enigma::object_collisions* inst; (inst = candidates.next()); )
     {
-        enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (notme && inst->id == enigma::instance_event_iterator->inst->id)
             continue;
         if (solid_only && !inst->solid)
@@ -212,12 +172,8 @@ enigma::object_collisions* const collide_inst_point(int object, bool solid_only,
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
-        const double x = inst->x, y = inst->y,
-                     xscale = inst->image_xscale, yscale = inst->image_yscale,
-                     ia = inst->image_angle;
-        int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        const enigma::world_bbox_t &box = inst->$bbox_world();
+        const int left = box.left, top = box.top, right = box.right, bottom = box.bottom;
 
         if (x1 >= left && x1 <= right && y1 >= top && y1 <= bottom)
             return inst;
@@ -249,9 +205,9 @@ enigma::object_collisions* const collide_inst_ellipse(int object, bool solid_onl
     if (fzero(rx) || fzero(ry))
         return 0;
 
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    enigma::collision_candidates candidates(object, int(floor(x1 - fabs(rx))), int(floor(y1 - fabs(ry))), int(ceil(x1 + fabs(rx))), int(ceil(y1 + fabs(ry))));
+    for (enigma::object_collisions* inst; (inst = candidates.next()); )
     {
-        enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (notme && inst->id == enigma::instance_event_iterator->inst->id)
             continue;
         if (solid_only && !inst->solid)
@@ -259,12 +215,8 @@ enigma::object_collisions* const collide_inst_ellipse(int object, bool solid_onl
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
-        const double x = inst->x, y = inst->y,
-                     xscale = inst->image_xscale, yscale = inst->image_yscale,
-                     ia = inst->image_angle;
-        int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        const enigma::world_bbox_t &box = inst->$bbox_world();
+        const int left = box.left, top = box.top, right = box.right, bottom = box.bottom;
 
         const bool intersects = line_ellipse_intersects(rx, ry, left-x1, top-y1, bottom-y1) ||
                                  line_ellipse_intersects(rx, ry, right-x1, top-y1, bottom-y1) ||
@@ -281,20 +233,16 @@ enigma::object_collisions* const collide_inst_ellipse(int object, bool solid_onl
 
 void destroy_inst_point(int object, bool solid_only, int x1, int y1)
 {
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    enigma::collision_candidates candidates(object, x1, y1, x1, y1);
+    for (enigma::object_collisions* inst; (inst = candidates.next()); )
     {
-        enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (solid_only && !inst->solid)
             continue;
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
-        const double x = inst->x, y = inst->y,
-                     xscale = inst->image_xscale, yscale = inst->image_yscale,
-                     ia = inst->image_angle;
-        int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        const enigma::world_bbox_t &box = inst->$bbox_world();
+        const int left = box.left, top = box.top, right = box.right, bottom = box.bottom;
 
         if (x1 >= left && x1 <= right && y1 >= top && y1 <= bottom)
             enigma_user::instance_destroy(inst->id);
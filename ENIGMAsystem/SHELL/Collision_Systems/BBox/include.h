@@ -1,5 +1,6 @@
 #include "BBOXutil.h"
 #include "BBOXimpl.h"
+#include "BBOXgridfuncs.h"
 #include "../General/CSfuncs.h"
 #include "Collision_Systems/actions.h"
 
@@ -27,62 +27,78 @@
 #include "Universal_System/math_consts.h"
 
 #include "PRECimpl.h"
+#include "PRECmask.h"
 #include <cmath>
 #include <utility>
 
-static inline void get_border(int *leftv, int *rightv, int *topv, int *bottomv, int left, int top, int right, int bottom, double x, double y, double xscale, double yscale, double angle)
-{
-    if (angle == 0)
-    {
-        const bool xsp = (xscale >= 0), ysp = (yscale >= 0);
-        const double lsc = left*xscale, rsc = (right+1)*xscale-1, tsc = top*yscale, bsc = (bottom+1)*yscale-1;
-
-        *leftv   = (xsp ? lsc : rsc) + x + .5;
-        *rightv  = (xsp ? rsc : lsc) + x + .5;
-        *topv    = (ysp ? tsc : bsc) + y + .5;
-        *bottomv = (ysp ? bsc : tsc) + y + .5;
-    }
-    else
-    {
-        const double arad = angle*(M_PI/180.0);
-        const double sina = sin(arad), cosa = cos(arad);
-        const double lsc = left*xscale, rsc = (right+1)*xscale-1, tsc = top*yscale, bsc = (bottom+1)*yscale-1;
-        const int quad = int(fmod(fmod(angle, 360) + 360, 360)/90.0);
-        const bool xsp = (xscale >= 0), ysp = (yscale >= 0),
-                   q12 = (quad == 1 || quad == 2), q23 = (quad == 2 || quad == 3),
-                   xs12 = xsp^q12, sx23 = xsp^q23, ys12 = ysp^q12, ys23 = ysp^q23;
-
-        *leftv   = cosa*(xs12 ? lsc : rsc) + sina*(ys23 ? tsc : bsc) + x + .5;
-        *rightv  = cosa*(xs12 ? rsc : lsc) + sina*(ys23 ? bsc : tsc) + x + .5;
-        *topv    = cosa*(ys12 ? tsc : bsc) - sina*(sx23 ? rsc : lsc) + y + .5;
-        *bottomv = cosa*(ys12 ? bsc : tsc) - sina*(sx23 ? lsc : rsc) + y + .5;
-    }
-}
+using enigma::get_border;
 
 static inline int min(int x, int y) { return x<y? x : y; }
 static inline double min(double x, double y) { return x<y? x : y; }
 static inline int max(int x, int y) { return x>y? x : y; }
 static inline double max(double x, double y) { return x>y? x : y; }
 
+// Unrotated, unscaled masks line up with room pixels, so they can be tested 64 pixels at a time.
+static inline bool mask_is_aligned(double xscale, double yscale, double ia) {
+    return xscale == 1.0 && yscale == 1.0 && ia == 0.0;
+}
+
+// The transformed paths below map room pixel c to mask pixel int(c - x) + offset. Truncating toward
+// zero maps the pixels either side of a fractional x to the same mask pixel, so the aligned paths
+// use the same mapping: rows directly, and columns as separate spans before and from mask_split(x),
+// each offset by the mask_origin() of its first pixel. Both paths then find the same collisions.
+static inline int mask_origin(double x, int offset, int c) {
+    return c - (int(c - x) + offset);
+}
+static inline int mask_split(double x) {
+    return int(floor(x)) + 1;
+}
+
+// Keeps only the pixels of a word that fall at or before the given last column.
+static inline enigma::mask_word mask_clip(enigma::mask_word bits, int colindex, int last) {
+    const int n = last - colindex + 1;
+    return n < 64 ? bits & ((enigma::mask_word(1) << n) - 1) : bits;
+}
+
 static bool precise_collision_single(int intersection_left, int intersection_right, int intersection_top, int intersection_bottom,
                                 double x1, double y1,
                                 double xscale1, double yscale1,
                                 double ia1,
-                                unsigned char* pixels1,
+                                const enigma::mask_word* pixels1,
                                 int w1, int h1,
                                 int xoffset1, int yoffset1)
 {
+    if (mask_is_aligned(xscale1, yscale1, ia1)) {
+        const int stride1 = enigma::mask_stride(w1), split1 = mask_split(x1);
 
-    if (xscale1 != 0.0 && yscale1 != 0.0) {
+        for (int rowindex = intersection_top; rowindex <= intersection_bottom; rowindex++)
+        {
+            const int py1 = int(rowindex - y1) + yoffset1;
+            if (py1 < 0 || py1 >= h1) continue;
+            const enigma::mask_word* row1 = pixels1 + py1*stride1;
+            for (int start = intersection_left, end; start <= intersection_right; start = end + 1)
+            {
+                end = (start < split1 && split1 <= intersection_right) ? split1 - 1 : intersection_right;
+                const int ox1 = mask_origin(x1, xoffset1, start);
+                for (int colindex = start; colindex <= end; colindex += 64)
+                {
+                    if (mask_clip(enigma::mask_row_bits(row1, stride1, colindex - ox1), colindex, end)) {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
 
-        const double pi_half = M_PI/2.0;
+    if (xscale1 != 0.0 && yscale1 != 0.0) {
 
         const double arad1 = ia1*M_PI/180.0;
 
         const double cosa1 = cos(-arad1);
         const double sina1 = sin(-arad1);
-        const double cosa90_1 = cos(-arad1 + pi_half);
-        const double sina90_1 = sin(-arad1 + pi_half);
+        const double cosa90_1 = -sina1; // cos(-arad1 + pi/2), but exactly zero when unrotated
+        const double sina90_1 = cosa1;  // sin(-arad1 + pi/2)
 
         for (int rowindex = intersection_top; rowindex <= intersection_bottom; rowindex++)
         {
@@ -94,7 +110,7 @@ static bool precise_collision_single(int intersection_left, int intersection_rig
                 const int by1 = (rowindex - y1);
                 const int px1 = (int)((bx1*cosa1 + by1*sina1)/xscale1 + xoffset1);
                 const int py1 = (int)((bx1*cosa90_1 + by1*sina90_1)/yscale1 + yoffset1);
-                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1[py1*w1 + px1] != 0;
+                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && enigma::mask_pixel(pixels1, w1, px1, py1);
 
                 if (p1) {
                     return true;
@@ -109,27 +125,53 @@ static bool precise_collision_pair(int intersection_left, int intersection_right
                                 double x1, double y1, double x2, double y2,
                                 double xscale1, double yscale1, double xscale2, double yscale2,
                                 double ia1, double ia2,
-                                unsigned char* pixels1, unsigned char* pixels2,
+                                const enigma::mask_word* pixels1, const enigma::mask_word* pixels2,
                                 int w1, int h1, int w2, int h2,
                                 int xoffset1, int yoffset1, int xoffset2, int yoffset2)
 {
+    if (mask_is_aligned(xscale1, yscale1, ia1) && mask_is_aligned(xscale2, yscale2, ia2)) {
+        const int stride1 = enigma::mask_stride(w1), stride2 = enigma::mask_stride(w2);
+        const int split1 = mask_split(x1), split2 = mask_split(x2);
 
-    if (xscale1 != 0.0 && yscale1 != 0.0 && xscale2 != 0.0 && yscale2 != 0.0) {
+        for (int rowindex = intersection_top; rowindex <= intersection_bottom; rowindex++)
+        {
+            const int py1 = int(rowindex - y1) + yoffset1, py2 = int(rowindex - y2) + yoffset2;
+            if (py1 < 0 || py1 >= h1 || py2 < 0 || py2 >= h2) continue;
+            const enigma::mask_word* row1 = pixels1 + py1*stride1;
+            const enigma::mask_word* row2 = pixels2 + py2*stride2;
+            for (int start = intersection_left, end; start <= intersection_right; start = end + 1)
+            {
+                end = intersection_right;
+                if (start < split1 && split1 <= end) end = split1 - 1;
+                if (start < split2 && split2 <= end) end = split2 - 1;
+                const int ox1 = mask_origin(x1, xoffset1, start), ox2 = mask_origin(x2, xoffset2, start);
+                for (int colindex = start; colindex <= end; colindex += 64)
+                {
+                    const enigma::mask_word bits = enigma::mask_row_bits(row1, stride1, colindex - ox1) &
+                                                   enigma::mask_row_bits(row2, stride2, colindex - ox2);
+                    if (mask_clip(bits, colindex, end)) {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
 
-        const double pi_half = M_PI/2.0;
+    if (xscale1 != 0.0 && yscale1 != 0.0 && xscale2 != 0.0 && yscale2 != 0.0) {
 
         const double arad1 = ia1*M_PI/180.0;
         const double arad2 = ia2*M_PI/180.0;
 
         const double cosa1 = cos(-arad1);
         const double sina1 = sin(-arad1);
-        const double cosa90_1 = cos(-arad1 + pi_half);
-        const double sina90_1 = sin(-arad1 + pi_half);
+        const double cosa90_1 = -sina1; // cos(-arad1 + pi/2), but exactly zero when unrotated
+        const double sina90_1 = cosa1;  // sin(-arad1 + pi/2)
 
         const double cosa2 = cos(-arad2);
         const double sina2 = sin(-arad2);
-        const double cosa90_2 = cos(-arad2 + pi_half);
-        const double sina90_2 = sin(-arad2 + pi_half);
+        const double cosa90_2 = -sina2; // cos(-arad2 + pi/2), but exactly zero when unrotated
+        const double sina90_2 = cosa2;  // sin(-arad2 + pi/2)
 
         for (int rowindex = intersection_top; rowindex <= intersection_bottom; rowindex++)
         {
@@ -141,14 +183,14 @@ static bool precise_collision_pair(int intersection_left, int intersection_right
                 const int by1 = (rowindex - y1);
                 const int px1 = (int)((bx1*cosa1 + by1*sina1)/xscale1 + xoffset1);
                 const int py1 = (int)((bx1*cosa90_1 + by1*sina90_1)/yscale1 + yoffset1);
-                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1[py1*w1 + px1] != 0;
+                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && enigma::mask_pixel(pixels1, w1, px1, py1);
 
                 //Test for second image.
                 const int bx2 = (colindex - x2);
                 const int by2 = (rowindex - y2);
                 const int px2 = (int)((bx2*cosa2 + by2*sina2)/xscale2 + xoffset2);
                 const int py2 = (int)((bx2*cosa90_2 + by2*sina90_2)/yscale2 + yoffset2);
-                const bool p2 = px2 >= 0 && py2 >= 0 && px2 < w2 && py2 < h2 && pixels2[py2*w2 + px2] != 0;
+                const bool p2 = px2 >= 0 && py2 >= 0 && px2 < w2 && py2 < h2 && enigma::mask_pixel(pixels2, w2, px2, py2);
 
                 //Final test.
                 if (p1 && p2) {
@@ -165,21 +207,19 @@ static bool precise_collision_line(int intersection_left, int intersection_right
                                 double x1, double y1,
                                 double xscale1, double yscale1,
                                 double ia1,
-                                unsigned char* pixels1,
+                                const enigma::mask_word* pixels1,
                                 int w1, int h1,
                                 int xoffset1, int yoffset1,
                                 int lx1, int ly1, int lx2, int ly2)
 {
     if (xscale1 != 0.0 && yscale1 != 0.0) {
 
-        const double pi_half = M_PI/2.0;
-
         const double arad1 = ia1*M_PI/180.0;
 
         const double cosa1 = cos(-arad1);
         const double sina1 = sin(-arad1);
-        const double cosa90_1 = cos(-arad1 + pi_half);
-        const double sina90_1 = sin(-arad1 + pi_half);
+        const double cosa90_1 = -sina1; // cos(-arad1 + pi/2), but exactly zero when unrotated
+        const double sina90_1 = cosa1;  // sin(-arad1 + pi/2)
 
         if (lx1 != lx2 && abs(lx1-lx2) >= abs(ly1-ly2)) { // The slope is defined and in [-1;1].
             const int minX = max(min(lx1, lx2), intersection_left),
@@ -197,7 +237,7 @@ static bool precise_collision_line(int intersection_left, int intersection_right
                 const int by1 = (gy - y1);
                 const int px1 = (int)((bx1*cosa1 + by1*sina1)/xscale1 + xoffset1);
                 const int py1 = (int)((bx1*cosa90_1 + by1*sina90_1)/yscale1 + yoffset1);
-                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1[py1*w1 + px1] != 0;
+                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && enigma::mask_pixel(pixels1, w1, px1, py1);
 
                 if (p1) {
                     return true;
@@ -220,7 +260,7 @@ static bool precise_collision_line(int intersection_left, int intersection_right
                 const int by1 = (gy - y1);
                 const int px1 = (int)((bx1*cosa1 + by1*sina1)/xscale1 + xoffset1);
                 const int py1 = (int)((bx1*cosa90_1 + by1*sina90_1)/yscale1 + yoffset1);
-                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1[py1*w1 + px1] != 0;
+                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && enigma::mask_pixel(pixels1, w1, px1, py1);
 
                 if (p1) {
                     return true;
@@ -236,7 +276,7 @@ static bool precise_collision_ellipse(int intersection_left, int intersection_ri
                                 double x1, double y1,
                                 double xscale1, double yscale1,
                                 double ia1,
-                                unsigned char* pixels1,
+                                const enigma::mask_word* pixels1,
                                 int w1, int h1,
                                 int xoffset1, int yoffset1,
                                 int ex, int ey, int rx, int ry)
@@ -244,14 +284,12 @@ static bool precise_collision_ellipse(int intersection_left, int intersection_ri
 
     if (xscale1 != 0.0 && yscale1 != 0.0) {
 
-        const double pi_half = M_PI/2.0;
-
         const double arad1 = ia1*M_PI/180.0;
 
         const double cosa1 = cos(-arad1);
         const double sina1 = sin(-arad1);
-        const double cosa90_1 = cos(-arad1 + pi_half);
-        const double sina90_1 = sin(-arad1 + pi_half);
+        const double cosa90_1 = -sina1; // cos(-arad1 + pi/2), but exactly zero when unrotated
+        const double sina90_1 = cosa1;  // sin(-arad1 + pi/2)
 
         const double rx_2 = rx*rx, ry_2 = ry*ry;
 
@@ -268,7 +306,7 @@ static bool precise_collision_ellipse(int intersection_left, int intersection_ri
                 const int by1 = (rowindex - y1);
                 const int px1 = (int)((bx1*cosa1 + by1*sina1)/xscale1 + xoffset1);
                 const int py1 = (int)((bx1*cosa90_1 + by1*sina90_1)/yscale1 + yoffset1);
-                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1[py1*w1 + px1] != 0;
+                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && enigma::mask_pixel(pixels1, w1, px1, py1);
 
                 if (p1) {
                     return true;
@@ -305,12 +343,11 @@ enigma::object_collisions* const collide_inst_inst(int object, bool solid_only,
         if (inst2->sprite_index == -1 && inst2->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box2 = inst2->$bbox_relative();
         const double x2 = inst2->x, y2 = inst2->y,
                      xscale2 = inst2->image_xscale, yscale2 = inst2->image_yscale,
                      ia2 = inst2->image_angle;
-        int left2, top2, right2, bottom2;
-        get_border(&left2, &right2, &top2, &bottom2, box2.left, box2.top, box2.right, box2.bottom, x2, y2, xscale2, yscale2, ia2);
+        const enigma::world_bbox_t &box2 = inst2->$bbox_world();
+        const int left2 = box2.left, top2 = box2.top, right2 = box2.right, bottom2 = box2.bottom;
 
         if (left1 <= right2 && left2 <= right1 && top1 <= bottom2 && top2 <= bottom1) {
 
@@ -324,8 +361,8 @@ enigma::object_collisions* const collide_inst_inst(int object, bool solid_only,
             const int usi1 = ((int) inst1->image_index) % sprite1->subcount;
             const int usi2 = ((int) inst2->image_index) % sprite2->subcount;
 
-            unsigned char* pixels1 = (unsigned char*) (sprite1->colldata[usi1]);
-            unsigned char* pixels2 = (unsigned char*) (sprite2->colldata[usi2]);
+            const enigma::mask_word* pixels1 = (const enigma::mask_word*) (sprite1->colldata[usi1]);
+            const enigma::mask_word* pixels2 = (const enigma::mask_word*) (sprite2->colldata[usi2]);
 
             if (pixels1 == 0 && pixels2 == 0) { //bbox vs. bbox.
                 return inst2;
@@ -416,12 +453,11 @@ enigma::object_collisions* const collide_inst_rect(int object, bool solid_only,
          if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
         const double x = inst->x, y = inst->y,
                      xscale = inst->image_xscale, yscale = inst->image_yscale,
                      ia = inst->image_angle;
-        int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        const enigma::world_bbox_t &box = inst->$bbox_world();
+        const int left = box.left, top = box.top, right = box.right, bottom = box.bottom;
 
         if (left <= x2 && x1 <= right && top <= y2 && y1 <= bottom) {
 
@@ -436,7 +472,7 @@ enigma::object_collisions* const collide_inst_rect(int object, bool solid_only,
 
             const int usi = ((int) inst->image_index) % sprite->subcount;
 
-            unsigned char* pixels = (unsigned char*) (sprite->colldata[usi]);
+            const enigma::mask_word* pixels = (const enigma::mask_word*) (sprite->colldata[usi]);
 
             if (pixels == 0) { //bbox.
                 return inst;
@@ -491,12 +527,11 @@ enigma::object_collisions* const collide_inst_line(int object, bool solid_only,
         if (inst->sprite_index == -1 && inst->mask_index == -1) // No sprite/mask then no collision.
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
         const double x = inst->x, y = inst->y,
                      xscale = inst->image_xscale, yscale = inst->image_yscale,
                      ia = inst->image_angle;
-        int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        const enigma::world_bbox_t &box = inst->$bbox_world();
+        const int left = box.left, top = box.top, right = box.right, bottom = box.bottom;
 
         double minX = max(min(x1,x2),left);
         double maxX = min(max(x1,x2),right);
@@ -542,7 +577,7 @@ enigma::object_collisions* const collide_inst_line(int object, bool solid_only,
 
                 const int usi = ((int) inst->image_index) % sprite->subcount;
 
-                unsigned char* pixels = (unsigned char*) (sprite->colldata[usi]);
+                const enigma::mask_word* pixels = (const enigma::mask_word*) (sprite->colldata[usi]);
 
                 if (pixels == NULL) { // Bounding box.
                     return inst;
@@ -596,12 +631,11 @@ enigma::object_collisions* const collide_inst_point(int object, bool solid_only,
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
         const double x = inst->x, y = inst->y,
                      xscale = inst->image_xscale, yscale = inst->image_yscale,
                      ia = inst->image_angle;
-        int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        const enigma::world_bbox_t &box = inst->$bbox_world();
+        const int left = box.left, top = box.top, right = box.right, bottom = box.bottom;
 
         if (x1 >= left && x1 <= right && y1 >= top && y1 <= bottom) {
 
@@ -616,7 +650,7 @@ enigma::object_collisions* const collide_inst_point(int object, bool solid_only,
 
             const int usi = ((int) inst->image_index) % sprite->subcount;
 
-            unsigned char* pixels = (unsigned char*) (sprite->colldata[usi]);
+            const enigma::mask_word* pixels = (const enigma::mask_word*) (sprite->colldata[usi]);
 
             if (pixels == 0) { //bbox.
                 return inst;
@@ -689,12 +723,11 @@ enigma::object_collisions* const collide_inst_ellipse(int object, bool solid_onl
         if (inst->sprite_index == -1 && inst->mask_index == -1) // No sprite/mask then no collision.
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
         const double x = inst->x, y = inst->y,
                      xscale = inst->image_xscale, yscale = inst->image_yscale,
                      ia = inst->image_angle;
-        int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        const enigma::world_bbox_t &box = inst->$bbox_world();
+        const int left = box.left, top = box.top, right = box.right, bottom = box.bottom;
 
         const bool intersects = line_ellipse_intersects(rx, ry, left-x1, top-y1, bottom-y1) ||
                                  line_ellipse_intersects(rx, ry, right-x1, top-y1, bottom-y1) ||
@@ -714,7 +747,7 @@ enigma::object_collisions* const collide_inst_ellipse(int object, bool solid_onl
 
             const int usi = ((int) inst->image_index) % sprite->subcount;
 
-            unsigned char* pixels = (unsigned char*) (sprite->colldata[usi]);
+            const enigma::mask_word* pixels = (const enigma::mask_word*) (sprite->colldata[usi]);
 
             if (pixels == 0) { // Bounding Box.
                 return inst;
@@ -764,12 +797,11 @@ void destroy_inst_point(int object, bool solid_only, int x1, int y1)
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
         const double x = inst->x, y = inst->y,
                      xscale = inst->image_xscale, yscale = inst->image_yscale,
                      ia = inst->image_angle;
-        int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        const enigma::world_bbox_t &box = inst->$bbox_world();
+        const int left = box.left, top = box.top, right = box.right, bottom = box.bottom;
 
         if (x1 >= left && x1 <= right && y1 >= top && y1 <= bottom) {
 
@@ -779,7 +811,7 @@ void destroy_inst_point(int object, bool solid_only, int x1, int y1)
 
             const int usi = ((int) inst->image_index) % sprite->subcount;
 
-            unsigned char* pixels = (unsigned char*) (sprite->colldata[usi]);
+            const enigma::mask_word* pixels = (const enigma::mask_word*) (sprite->colldata[usi]);
 
             if (pixels == 0) { //bbox.
                 enigma_user::instance_destroy(inst->id);
@@ -825,12 +857,11 @@ void change_inst_point(int obj, bool perf, int x1, int y1)
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
         const double x = inst->x, y = inst->y,
                      xscale = inst->image_xscale, yscale = inst->image_yscale,
                      ia = inst->image_angle;
-        int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        const enigma::world_bbox_t &box = inst->$bbox_world();
+        const int left = box.left, top = box.top, right = box.right, bottom = box.bottom;
 
         if (x1 >= left && x1 <= right && y1 >= top && y1 <= bottom) {
 
@@ -840,7 +871,7 @@ void change_inst_point(int obj, bool perf, int x1, int y1)
 
             const int usi = ((int) inst->image_index) % sprite->subcount;
 
-            unsigned char* pixels = (unsigned char*) (sprite->colldata[usi]);
+            const enigma::mask_word* pixels = (const enigma::mask_word*) (sprite->colldata[usi]);
 
             if (pixels == 0) { //bbox.
                 enigma::instance_change_inst(obj, perf, inst);
@@ -0,0 +1,60 @@
+/** Copyright (C) 2026 The ENIGMA Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+////////////////////////////////////
+// Layout of precise collision masks. A mask stores one bit per pixel, row by row, with each row
+// padded to a whole number of 64-bit words; pixel x of a row is bit (x % 64) of word (x / 64).
+// Padding bits are always clear, so whole words can be tested without masking the row's end.
+////////////////////////////////////
+
+#ifndef ENIGMA_PREC_MASK_H
+#define ENIGMA_PREC_MASK_H
+
+#include <stdint.h>
+
+namespace enigma
+{
+  typedef uint64_t mask_word;
+
+  // Number of words in each row of a mask for a sprite of the given width.
+  static inline int mask_stride(int w) {
+    return (w + 63) >> 6;
+  }
+
+  static inline void mask_set(mask_word *mask, int w, int px, int py) {
+    mask[py*mask_stride(w) + (px >> 6)] |= mask_word(1) << (px & 63);
+  }
+
+  // Assumes 0 <= px < w and 0 <= py < h.
+  static inline bool mask_pixel(const mask_word *mask, int w, int px, int py) {
+    return (mask[py*mask_stride(w) + (px >> 6)] >> (px & 63)) & 1;
+  }
+
+  // Returns the 64 pixels of a row starting at the given column, which may lie outside the row;
+  // pixels outside the row read as clear.
+  static inline mask_word mask_row_bits(const mask_word *row, int words, int column)
+  {
+    const int wi = column >= 0 ? column >> 6 : -((63 - column) >> 6);
+    const int shift = column - wi*64;
+    const mask_word lo = (wi >= 0 && wi < words) ? row[wi] : 0;
+    if (!shift) return lo;
+    const mask_word hi = (wi + 1 >= 0 && wi + 1 < words) ? row[wi + 1] : 0;
+    return (lo >> shift) | (hi << (64 - shift));
+  }
+}
+
+#endif
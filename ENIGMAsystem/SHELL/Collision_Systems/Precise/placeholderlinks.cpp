@@ -17,6 +17,7 @@
 
 #include "Collision_Systems/collision_mandatory.h"
 #include "Universal_System/nlpo2.h"
+#include "PRECmask.h"
 
 #include <iostream>
 
@@ -35,13 +36,14 @@ namespace enigma
       case ct_precise:
         {
           const unsigned int w = spr->width, h = spr->height;
-          unsigned char* colldata = new unsigned char[w*h];
+          mask_word* colldata = new mask_word[mask_stride(w)*h](); // Initialize all bits to 0.
 
           for (unsigned int rowindex = 0; rowindex < h; rowindex++)
           {
             for(unsigned int colindex = 0; colindex < w; colindex++)
             {
-              colldata[rowindex*w + colindex] = (input_data[4*(rowindex*w + colindex) + 3] != 0) ? 1 : 0; // If alpha != 0 then 1 else 0.
+              if (input_data[4*(rowindex*w + colindex) + 3] != 0) // If alpha != 0 then 1 else 0.
+                mask_set(colldata, w, colindex, rowindex);
             }
           }
 
@@ -52,7 +54,7 @@ namespace enigma
         {
           // Create ellipse inside bbox.
           const unsigned int w = spr->width, h = spr->height;
-          unsigned char* colldata = new unsigned char[w*h](); // Initialize all elements to 0.
+          mask_word* colldata = new mask_word[mask_stride(w)*h](); // Initialize all bits to 0.
           const bbox_rect_t bbox = spr->bbox;
 
           const unsigned int a = max(bbox.right-bbox.left, bbox.bottom-bbox.top)/2, // Major radius.
@@ -72,7 +74,8 @@ namespace enigma
             {
               const int xcp = x-xc, ycp = y-yc; // Center to point.
               const bool is_inside_ellipse = b_2*xcp*xcp + a_2*ycp*ycp <= a_2b_2;
-              colldata[y*w + x] = (is_inside_ellipse ? 1 : 0); // If point inside ellipse, 1, else 0.
+              if (is_inside_ellipse) // If point inside ellipse, 1, else 0.
+                mask_set(colldata, w, x, y);
             }
           }
 
@@ -82,7 +85,7 @@ namespace enigma
         {
           // Create diamond inside bbox.
           const unsigned int w = spr->width, h = spr->height;
-          unsigned char* colldata = new unsigned char[w*h](); // Initialize all elements to 0.
+          mask_word* colldata = new mask_word[mask_stride(w)*h](); // Initialize all bits to 0.
           const bbox_rect_t bbox = spr->bbox;
 
           // Diamond corners.
@@ -110,7 +113,8 @@ namespace enigma
                                               cp(xlb, -ylb, xlp, -ylp) >= 0 &&
                                               cp(xrt, -yrt, xrp, -yrp) >= 0 &&
                                               cp(xrb, -yrb, xrp, -yrp) <= 0;
-              colldata[y*w + x] = (is_inside_diamond ? 1 : 0); // If point inside diamond, 1, else 0.
+              if (is_inside_diamond) // If point inside diamond, 1, else 0.
+                mask_set(colldata, w, x, y);
             }
           }
 
@@ -121,7 +125,7 @@ namespace enigma
         {
           // Create circle fitting inside bbox.
           const unsigned int w = spr->width, h = spr->height;
-          unsigned char* colldata = new unsigned char[w*h](); // Initialize all elements to 0.
+          mask_word* colldata = new mask_word[mask_stride(w)*h](); // Initialize all bits to 0.
           const bbox_rect_t bbox = spr->bbox;
 
           const unsigned int r = min(bbox.right-bbox.left, bbox.bottom-bbox.top)/2; // Radius.
@@ -140,7 +144,8 @@ namespace enigma
             {
               const int xcp = x-xc, ycp = y-yc; // Center to point.
               const bool is_inside_circle = xcp*xcp + ycp*ycp <= r_2;
-              colldata[y*w + x] = (is_inside_circle ? 1 : 0); // If point inside circle, 1, else 0.
+              if (is_inside_circle) // If point inside circle, 1, else 0.
+                mask_set(colldata, w, x, y);
             }
           }
 
@@ -153,7 +158,7 @@ namespace enigma
   void free_collision_mask(void* mask)
   {
     if (mask != 0) {
-      delete[] (unsigned char*)mask;
+      delete[] (mask_word*)mask;
     }
   }
 };
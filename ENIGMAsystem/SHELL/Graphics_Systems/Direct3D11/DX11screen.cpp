@@ -148,6 +148,7 @@ void screen_redraw()
                 if (instance_event_iterator == inst_depth->depth.myiter) {
                     instance_event_iterator = inst_depth->depth.myiter->prev;
                 }
+                retire_inst_iter(inst_depth->depth.myiter);
                 inst_depth->depth.myiter = mynewiter;
             }
         }
@@ -301,6 +302,7 @@ void screen_redraw()
 					if (instance_event_iterator == inst_depth->depth.myiter) {
 						instance_event_iterator = inst_depth->depth.myiter->prev;
 					}
+					retire_inst_iter(inst_depth->depth.myiter);
 					inst_depth->depth.myiter = mynewiter;
 				}
 			}
@@ -17,7 +17,9 @@
 **/
 
 #include <cmath>
+#include <map>
 #include <string>
+#include <vector>
 #include <cstdint>
 #include "libEGMstd.h"
 #include "Universal_System/var4.h"
@@ -54,29 +56,25 @@ unsigned valign = enigma_user::fa_top; //default alignment
 
 const string unicodeAnds = "\x1F\x1F\x1F\x1F\x1F\x1F\x1F\x1F\x1F\x1F\x1F\x1F\x1F\x1F\x1F\x1F\x0F\x0F\x0F\x0F\x0F\x0F\x0F\x0F\x07\x07\x07\x07\x03\x03\x01";
 
-static uint32_t getUnicodeCharacter(const string str, size_t& pos) {
-  uint32_t character = 0;
-  if (str[pos] & 0x80) {
-    character = (str[pos] & unicodeAnds[(str[pos] >> 1) & 0x1F]);
-    for (size_t ii = 1; ii <= 6; ii++) {
-      if ((str[pos + ii] & 0xC0) != 0x80) { pos += ii - 1; break; }
-      character <<= 6;
-      character |= (str[pos + ii] & 0x3F);
-    }
-  } else {
-    character = (uint32_t)str[pos];
+// Decodes the UTF-8 character starting at pos, leaving pos on its last byte.
+static inline uint32_t getUnicodeCharacter(const string& str, size_t& pos) {
+  const unsigned char lead = str[pos];
+  if (!(lead & 0x80))
+    return lead;
+  uint32_t character = lead & unicodeAnds[(lead >> 1) & 0x1F];
+  const size_t len = str.length();
+  size_t ii = 1;
+  while (ii <= 6 && pos + ii < len && (str[pos + ii] & 0xC0) == 0x80) {
+    character <<= 6;
+    character |= (str[pos + ii] & 0x3F);
+    ii++;
   }
+  pos += ii - 1;
   return character;
 }
 
-static fontglyph* findGlyph(const font *const fnt, uint32_t character) {
-  for (size_t i = 0; i < fnt->glyphRangeCount; i++) {
-    fontglyphrange* fgr = fnt->glyphRanges[i];
-    if (character >= fgr->glyphstart && character < fgr->glyphstart + fgr->glyphcount) {
-      return fgr->glyphs[character - fgr->glyphstart];
-    }
-  }
-  return NULL;
+static inline fontglyph* findGlyph(const font *const fnt, uint32_t character) {
+  return font_find_glyph(fnt, character);
 }
 
 namespace enigma_user {
@@ -341,13 +339,83 @@ unsigned int string_width_ext_line_count(variant vstr, gs_scalar w)
 
 ////////////////////////////////////////////////////
 
-namespace enigma_user
-{
+namespace enigma {
+  // A glyph placed relative to the point its text is drawn at.
+  struct text_glyph {
+    const fontglyph *g;
+    gs_scalar x, y;
+    text_glyph(const fontglyph *G, gs_scalar X, gs_scalar Y): g(G), x(X), y(Y) {}
+  };
+
+  // Strings drawn recently, broken into lines and placed, so that text drawn every step is only
+  // laid out once. Everything a layout depends on is in its key, besides the fonts' glyphs, and
+  // the whole cache is dropped when any of those change. Layouts are kept in two generations:
+  // once the newer one fills, the older one is dropped and the newer takes its place, and a
+  // layout found in the older one moves back to the newer. Text drawn every step thus stays
+  // cached however many other strings come and go.
+  struct text_layout_key {
+    int font;
+    bool ext;
+    gs_scalar sep, w;
+    unsigned halign, valign;
+    string str;
+    bool operator<(const text_layout_key &o) const {
+      if (font != o.font) return font < o.font;
+      if (ext != o.ext) return ext < o.ext;
+      if (sep != o.sep) return sep < o.sep;
+      if (w != o.w) return w < o.w;
+      if (halign != o.halign) return halign < o.halign;
+      if (valign != o.valign) return valign < o.valign;
+      return str < o.str;
+    }
+  };
+  static map<text_layout_key, vector<text_glyph> > text_layouts, text_layouts_old;
+  static unsigned text_layouts_generation = 0;
+  static const size_t text_layouts_max = 256; // In each generation
 
-void draw_text(gs_scalar x, gs_scalar y, variant vstr)
+  // Returns the layout for key, empty if it has yet to be laid out.
+  static vector<text_glyph> &text_layout(const text_layout_key &key, bool &found)
+  {
+    if (text_layouts_generation != font_glyph_generation) {
+      text_layouts.clear(), text_layouts_old.clear();
+      text_layouts_generation = font_glyph_generation;
+    }
+    map<text_layout_key, vector<text_glyph> >::iterator it = text_layouts.find(key);
+    if ((found = it != text_layouts.end()))
+      return it->second;
+    if (text_layouts.size() >= text_layouts_max)
+      text_layouts_old.swap(text_layouts), text_layouts.clear();
+    vector<text_glyph> &layout = text_layouts[key];
+    it = text_layouts_old.find(key);
+    if ((found = it != text_layouts_old.end())) {
+      layout.swap(it->second);
+      text_layouts_old.erase(it);
+    }
+    return layout;
+  }
+
+  static void draw_text_layout(const font *const fnt, const vector<text_glyph> &layout, gs_scalar x, gs_scalar y)
+  {
+    using namespace enigma_user;
+    for (size_t i = 0; i < layout.size(); i++)
+    {
+      const fontglyph *const g = layout[i].g;
+      const gs_scalar xx = x + layout[i].x, yy = y + layout[i].y;
+      draw_primitive_begin_texture(pr_trianglestrip, fnt->texture);
+      draw_vertex_texture(xx + g->x,  yy + g->y, g->tx, g->ty);
+      draw_vertex_texture(xx + g->x2, yy + g->y, g->tx2, g->ty);
+      draw_vertex_texture(xx + g->x,  yy + g->y2, g->tx,  g->ty2);
+      draw_vertex_texture(xx + g->x2, yy + g->y2, g->tx2, g->ty2);
+      draw_primitive_end();
+    }
+  }
+}
+
+// Lay out draw_text and draw_text_ext, placing glyphs as those did when they drew them directly.
+static void layout_text(const font *const fnt, const string &str, vector<text_glyph> &layout)
 {
-  string str = toString(vstr);
-  get_fontv(fnt,currentfont);
+  using namespace enigma_user;
+  const gs_scalar x = 0, y = 0;
   gs_scalar yy = valign == fa_top ? y+fnt->yoffset : valign == fa_middle ? y +fnt->yoffset - string_height(str)/2 : y + fnt->yoffset - string_height(str);
   float slen = get_space_width(fnt);
   if (halign == fa_left){
@@ -365,12 +433,7 @@ void draw_text(gs_scalar x, gs_scalar y, variant vstr)
           if (character == ' ' or g == NULL) {
             xx += slen;
           } else {
-            draw_primitive_begin_texture(pr_trianglestrip, fnt->texture);
-            draw_vertex_texture(xx + g->x,  yy + g->y, g->tx, g->ty);
-            draw_vertex_texture(xx + g->x2, yy + g->y, g->tx2, g->ty);
-            draw_vertex_texture(xx + g->x,  yy + g->y2, g->tx,  g->ty2);
-            draw_vertex_texture(xx + g->x2, yy + g->y2, g->tx2, g->ty2);
-            draw_primitive_end();
+            layout.push_back(text_glyph(g, xx, yy));
             xx += gs_scalar(g->xs);
           }
         }
@@ -392,12 +455,7 @@ void draw_text(gs_scalar x, gs_scalar y, variant vstr)
           if (character == ' ' or g == NULL) {
             xx += slen;
           } else {
-            draw_primitive_begin_texture(pr_trianglestrip, fnt->texture);
-            draw_vertex_texture(xx + g->x,  yy + g->y, g->tx, g->ty);
-            draw_vertex_texture(xx + g->x2, yy + g->y, g->tx2, g->ty);
-            draw_vertex_texture(xx + g->x,  yy + g->y2, g->tx,  g->ty2);
-            draw_vertex_texture(xx + g->x2, yy + g->y2, g->tx2, g->ty2);
-            draw_primitive_end();
+            layout.push_back(text_glyph(g, xx, yy));
             xx += gs_scalar(g->xs);
           }
         }
@@ -405,6 +463,90 @@ void draw_text(gs_scalar x, gs_scalar y, variant vstr)
   }
 }
 
+static void layout_text_ext(const font *const fnt, const string &str, gs_scalar sep, gs_scalar w, vector<text_glyph> &layout)
+{
+  using namespace enigma_user;
+  const gs_scalar x = 0, y = 0;
+
+  gs_scalar yy = valign == fa_top ? y+fnt->yoffset : valign == fa_middle ? y + fnt->yoffset - string_height_ext(str,sep,w)/2 : y + fnt->yoffset - string_height_ext(str,sep,w);
+  float slen = get_space_width(fnt);
+  if (halign == fa_left){
+    gs_scalar xx = x, width = 0, tw = 0;
+    for (size_t i = 0; i < str.length(); i++)
+    {
+      uint32_t character = getUnicodeCharacter(str, i);
+      if (character == '\r') {
+        xx = x, yy += (sep+2 ? fnt->height : sep), i += str[i+1] == '\n';
+      } else if (character == '\n') {
+            xx = x, yy += (sep+2 ? fnt->height : sep);
+      } else {
+        fontglyph* g = findGlyph(fnt, character);
+        if (character == ' ' or g == NULL) {
+          xx += slen, width = xx-x;
+          tw = 0;
+          for (size_t c = i+1; c < str.length(); c++)
+          {
+          character = getUnicodeCharacter(str, c);
+          if (character == ' ' or character == '\r' or character == '\n')
+            break;
+          g = findGlyph(fnt, character);
+          tw += g->xs;
+          }
+          if (width+tw >= w && w != -1)
+          xx = x, yy += (sep==-1 ? fnt->height : sep), width = 0, tw = 0;
+        } else {
+          layout.push_back(text_glyph(g, xx, yy));
+          xx += gs_scalar(g->xs);
+        }
+      }
+    }
+  } else {
+    gs_scalar xx = halign == fa_center ? x-gs_scalar(string_width_ext_line(str,w,0)/2) : x-gs_scalar(string_width_ext_line(str,w,0)), line = 0, width = 0, tw = 0;
+    for (size_t i = 0; i < str.length(); i++)
+    {
+      uint32_t character = getUnicodeCharacter(str, i);
+      if (character == '\r') {
+        line += 1, xx = halign == fa_center ? x-gs_scalar(string_width_ext_line(str,w,line)/2) : x-gs_scalar(string_width_ext_line(str,w,line)), yy += (sep+2 ? fnt->height : sep), i += str[i+1] == '\n', width = 0;
+      } else if (character == '\n') {
+        line += 1, xx = halign == fa_center ? x-gs_scalar(string_width_ext_line(str,w,line)/2) : x-gs_scalar(string_width_ext_line(str,w,line)), yy += (sep+2 ? fnt->height : sep), width = 0;
+      } else {
+        fontglyph* g = findGlyph(fnt, character);
+        if (character == ' ' or g == NULL) {
+          xx += slen, width += slen, tw = 0;
+          for (size_t c = i+1; c < str.length(); c++)
+          {
+          character = getUnicodeCharacter(str, c);
+          if (character == ' ' or character == '\r' or character == '\n')
+            break;
+          g = findGlyph(fnt, character);
+          tw += g->xs;
+          }
+
+          if (width+tw >= w && w != -1)
+          line += 1, xx = halign == fa_center ? x-gs_scalar(string_width_ext_line(str,w,line)/2) : x-gs_scalar(string_width_ext_line(str,w,line)), yy += (sep==-1 ? fnt->height : sep), width = 0, tw = 0;
+        } else {
+          layout.push_back(text_glyph(g, xx, yy));
+          xx += gs_scalar(g->xs);
+          width += g->xs;
+        }
+      }
+    }
+  }
+}
+
+namespace enigma_user
+{
+
+void draw_text(gs_scalar x, gs_scalar y, variant vstr)
+{
+  get_fontv(fnt,currentfont);
+  const text_layout_key key = { currentfont, false, 0, 0, halign, valign, toString(vstr) };
+  bool found;
+  vector<text_glyph> &layout = text_layout(key, found);
+  if (!found) layout_text(fnt, key.str, layout);
+  draw_text_layout(fnt, layout, x, y);
+}
+
 
 void draw_text_sprite(gs_scalar x, gs_scalar y, variant vstr, int sep, int lineWidth, int sprite, int firstChar, int scale)
 {
@@ -535,83 +677,12 @@ void draw_text_skewed(gs_scalar x, gs_scalar y, variant vstr, gs_scalar top, gs_
 
 void draw_text_ext(gs_scalar x, gs_scalar y, variant vstr, gs_scalar sep, gs_scalar w)
 {
-  string str = toString(vstr);
   get_fontv(fnt,currentfont);
-
-  gs_scalar yy = valign == fa_top ? y+fnt->yoffset : valign == fa_middle ? y + fnt->yoffset - string_height_ext(str,sep,w)/2 : y + fnt->yoffset - string_height_ext(str,sep,w);
-  float slen = get_space_width(fnt);
-  if (halign == fa_left){
-    gs_scalar xx = x, width = 0, tw = 0;
-    for (size_t i = 0; i < str.length(); i++)
-    {
-      uint32_t character = getUnicodeCharacter(str, i);
-      if (character == '\r') {
-        xx = x, yy += (sep+2 ? fnt->height : sep), i += str[i+1] == '\n';
-      } else if (character == '\n') {
-            xx = x, yy += (sep+2 ? fnt->height : sep);
-      } else {
-        fontglyph* g = findGlyph(fnt, character);
-        if (character == ' ' or g == NULL) {
-          xx += slen, width = xx-x;
-          tw = 0;
-          for (size_t c = i+1; c < str.length(); c++)
-          {
-          character = getUnicodeCharacter(str, c);
-          if (character == ' ' or character == '\r' or character == '\n')
-            break;
-          g = findGlyph(fnt, character);
-          tw += g->xs;
-          }
-          if (width+tw >= w && w != -1)
-          xx = x, yy += (sep==-1 ? fnt->height : sep), width = 0, tw = 0;
-        } else {
-          draw_primitive_begin_texture(pr_trianglestrip, fnt->texture);
-          draw_vertex_texture(xx + g->x,  yy + g->y, g->tx, g->ty);
-          draw_vertex_texture(xx + g->x2, yy + g->y, g->tx2, g->ty);
-          draw_vertex_texture(xx + g->x,  yy + g->y2, g->tx,  g->ty2);
-          draw_vertex_texture(xx + g->x2, yy + g->y2, g->tx2, g->ty2);
-          draw_primitive_end();
-          xx += gs_scalar(g->xs);
-        }
-      }
-    }
-  } else {
-    gs_scalar xx = halign == fa_center ? x-gs_scalar(string_width_ext_line(str,w,0)/2) : x-gs_scalar(string_width_ext_line(str,w,0)), line = 0, width = 0, tw = 0;
-    for (size_t i = 0; i < str.length(); i++)
-    {
-      uint32_t character = getUnicodeCharacter(str, i);
-      if (character == '\r') {
-        line += 1, xx = halign == fa_center ? x-gs_scalar(string_width_ext_line(str,w,line)/2) : x-gs_scalar(string_width_ext_line(str,w,line)), yy += (sep+2 ? fnt->height : sep), i += str[i+1] == '\n', width = 0;
-      } else if (character == '\n') {
-        line += 1, xx = halign == fa_center ? x-gs_scalar(string_width_ext_line(str,w,line)/2) : x-gs_scalar(string_width_ext_line(str,w,line)), yy += (sep+2 ? fnt->height : sep), width = 0;
-      } else {
-        fontglyph* g = findGlyph(fnt, character);
-        if (character == ' ' or g == NULL) {
-          xx += slen, width += slen, tw = 0;
-          for (size_t c = i+1; c < str.length(); c++)
-          {
-          character = getUnicodeCharacter(str, c);
-          if (character == ' ' or character == '\r' or character == '\n')
-            break;
-          g = findGlyph(fnt, character);
-          tw += g->xs;
-          }
-
-          if (width+tw >= w && w != -1)
-          line += 1, xx = halign == fa_center ? x-gs_scalar(string_width_ext_line(str,w,line)/2) : x-gs_scalar(string_width_ext_line(str,w,line)), yy += (sep==-1 ? fnt->height : sep), width = 0, tw = 0;
-        } else {
-          draw_primitive_begin_texture(pr_trianglestrip, fnt->texture);
-          draw_vertex_texture(xx + g->x,  yy + g->y, g->tx, g->ty);
-          draw_vertex_texture(xx + g->x2, yy + g->y, g->tx2, g->ty);
-          draw_vertex_texture(xx + g->x,  yy + g->y2, g->tx,  g->ty2);
-          draw_vertex_texture(xx + g->x2, yy + g->y2, g->tx2, g->ty2);
-          draw_primitive_end();
-          xx += gs_scalar(g->xs);
-          width += g->xs;
-        }
-      }
-    }
-  }
+  const text_layout_key key = { currentfont, true, sep, w, halign, valign, toString(vstr) };
+  bool found;
+  vector<text_glyph> &layout = text_layout(key, found);
+  if (!found) layout_text_ext(fnt, key.str, sep, w, layout);
+  draw_text_layout(fnt, layout, x, y);
 }
 
 void draw_text_transformed(gs_scalar x, gs_scalar y, variant vstr, gs_scalar xscale, gs_scalar yscale, double rot)
@@ -73,16 +73,17 @@ void draw_sprite(int spr,int subimg, gs_scalar x, gs_scalar y, int color, gs_sca
     alpha=clamp_alpha(alpha);
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
+    const enigma::texture_rect &tr = spr2d->texrectarray[usi];
 
-	const gs_scalar tbx = spr2d->texbordxarray[usi], tby = spr2d->texbordyarray[usi],
+	const gs_scalar tbx1 = tr.left, tby1 = tr.top, tbx2 = tr.right, tby2 = tr.bottom,
 			xvert1 = x-spr2d->xoffset, xvert2 = xvert1 + spr2d->width,
 			yvert1 = y-spr2d->yoffset, yvert2 = yvert1 + spr2d->height;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-	draw_vertex_texture_color(xvert1,yvert1,0,0,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbx,0,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2, 0,tby,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert2, tbx,tby,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tbx1,tby1,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tbx2,tby1,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2, tbx1,tby2,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert2, tbx2,tby2,color,alpha);
 	draw_primitive_end();
 }
 
@@ -91,25 +92,26 @@ void draw_sprite_ext(int spr, int subimg, gs_scalar x, gs_scalar y, gs_scalar xs
     alpha=clamp_alpha(alpha);
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
+    const enigma::texture_rect &tr = spr2d->texrectarray[usi];
 
 	rot *= M_PI/180;
 
     const gs_scalar
     w = spr2d->width*xscale, h = spr2d->height*yscale,
-    tbx = spr2d->texbordxarray[usi], tby = spr2d->texbordyarray[usi],
+    tbx1 = tr.left, tby1 = tr.top, tbx2 = tr.right, tby2 = tr.bottom,
     wsinrot = w*sin(rot), wcosrot = w*cos(rot);
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
 	gs_scalar
 		ulcx = x - xscale * spr2d->xoffset * cos(rot) + yscale * spr2d->yoffset * cos(M_PI/2+rot),
 		ulcy = y + xscale * spr2d->xoffset * sin(rot) - yscale * spr2d->yoffset * sin(M_PI/2+rot);
-	draw_vertex_texture_color(ulcx,ulcy, 0,0, color, alpha);
-	draw_vertex_texture_color(ulcx + wcosrot, ulcy - wsinrot, tbx, 0, color, alpha);
+	draw_vertex_texture_color(ulcx,ulcy, tbx1,tby1, color, alpha);
+	draw_vertex_texture_color(ulcx + wcosrot, ulcy - wsinrot, tbx2, tby1, color, alpha);
 	const double mpr = 3*M_PI/2 + rot;
     ulcx += h * cos(mpr);
     ulcy -= h * sin(mpr);
-	draw_vertex_texture_color(ulcx,ulcy, 0,tby, color, alpha);
-	draw_vertex_texture_color(ulcx + wcosrot, ulcy - wsinrot, tbx,tby, color, alpha);
+	draw_vertex_texture_color(ulcx,ulcy, tbx1,tby2, color, alpha);
+	draw_vertex_texture_color(ulcx + wcosrot, ulcy - wsinrot, tbx2,tby2, color, alpha);
 	draw_primitive_end();
 }
 
@@ -118,14 +120,15 @@ void draw_sprite_pos(int spr, int subimg, gs_scalar x1, gs_scalar y1, gs_scalar
     alpha=clamp_alpha(alpha);
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
+    const enigma::texture_rect &tr = spr2d->texrectarray[usi];
 
-    const gs_scalar tbx = spr2d->texbordxarray[usi], tby = spr2d->texbordyarray[usi];
+    const gs_scalar tbx1 = tr.left, tby1 = tr.top, tbx2 = tr.right, tby2 = tr.bottom;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-	draw_vertex_texture_color(x1,y1,0,0,draw_get_color(),alpha);
-	draw_vertex_texture_color(x2,y1,tbx,0,draw_get_color(),alpha);
-	draw_vertex_texture_color(x1,y2,0,tby,draw_get_color(),alpha);
-	draw_vertex_texture_color(x2,y2,tbx,tby,draw_get_color(),alpha);
+	draw_vertex_texture_color(x1,y1,tbx1,tby1,draw_get_color(),alpha);
+	draw_vertex_texture_color(x2,y1,tbx2,tby1,draw_get_color(),alpha);
+	draw_vertex_texture_color(x1,y2,tbx1,tby2,draw_get_color(),alpha);
+	draw_vertex_texture_color(x2,y2,tbx2,tby2,draw_get_color(),alpha);
 	draw_primitive_end();
 }
 
@@ -134,10 +137,11 @@ void draw_sprite_part(int spr, int subimg, gs_scalar left, gs_scalar top, gs_sca
     alpha=clamp_alpha(alpha);
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
+    const enigma::texture_rect &tr = spr2d->texrectarray[usi];
 
-	gs_scalar tbw = spr2d->width/(gs_scalar)spr2d->texbordxarray[usi], tbh = spr2d->height/(gs_scalar)spr2d->texbordyarray[usi],
-	  tbx1 = left/tbw, tbx2 = tbx1 + width/tbw,
-	  tby1 = top/tbh, tby2 = tby1 + height/tbh;
+	gs_scalar tbw = spr2d->width/(gs_scalar)(tr.right - tr.left), tbh = spr2d->height/(gs_scalar)(tr.bottom - tr.top),
+	  tbx1 = tr.left + left/tbw, tbx2 = tbx1 + width/tbw,
+	  tby1 = tr.top + top/tbh, tby2 = tby1 + height/tbh;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
 	draw_vertex_texture_color(x,y,tbx1,tby1,color,alpha);
@@ -152,12 +156,13 @@ void draw_sprite_part_offset(int spr, int subimg, gs_scalar left, gs_scalar top,
     alpha=clamp_alpha(alpha);
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
+    const enigma::texture_rect &tr = spr2d->texrectarray[usi];
 
-	gs_scalar tbw = spr2d->width/spr2d->texbordxarray[usi], tbh = spr2d->height/spr2d->texbordyarray[usi],
+	gs_scalar tbw = spr2d->width/(tr.right - tr.left), tbh = spr2d->height/(tr.bottom - tr.top),
 	  xvert1 = x-spr2d->xoffset, xvert2 = xvert1 + spr2d->width,
 	  yvert1 = y-spr2d->yoffset, yvert2 = yvert1 + spr2d->height,
-	  tbx1 = left/tbw, tbx2 = tbx1 + width/tbw,
-	  tby1 = top/tbh, tby2 = tby1 + height/tbh;
+	  tbx1 = tr.left + left/tbw, tbx2 = tbx1 + width/tbw,
+	  tby1 = tr.top + top/tbh, tby2 = tby1 + height/tbh;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
 	draw_vertex_texture_color(xvert1,yvert1,tbx1,tby1,color,alpha);
@@ -172,12 +177,13 @@ void draw_sprite_part_ext(int spr, int subimg, gs_scalar left, gs_scalar top, gs
     alpha=clamp_alpha(alpha);
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
+    const enigma::texture_rect &tr = spr2d->texrectarray[usi];
 
-	gs_scalar tbw = spr2d->width/(gs_scalar)spr2d->texbordxarray[usi], tbh = spr2d->height/(gs_scalar)spr2d->texbordyarray[usi],
+	gs_scalar tbw = spr2d->width/(gs_scalar)(tr.right - tr.left), tbh = spr2d->height/(gs_scalar)(tr.bottom - tr.top),
 	  xvert1 = x, xvert2 = xvert1 + width*xscale,
 	  yvert1 = y, yvert2 = yvert1 + height*yscale,
-	  tbx1 = left/tbw, tbx2 = tbx1 + width/tbw,
-	  tby1 = top/tbh, tby2 = tby1 + height/tbh;
+	  tbx1 = tr.left + left/tbw, tbx2 = tbx1 + width/tbw,
+	  tby1 = tr.top + top/tbh, tby2 = tby1 + height/tbh;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
 	draw_vertex_texture_color(xvert1,yvert1,tbx1,tby1,color,alpha);
@@ -192,10 +198,10 @@ void draw_sprite_general(int spr, int subimg, gs_scalar left, gs_scalar top, gs_
     alpha=clamp_alpha(alpha);
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
+    const enigma::texture_rect &tr = spr2d->texrectarray[usi];
 
 	const gs_scalar
-	  tbx = spr2d->texbordxarray[usi],  tby = spr2d->texbordyarray[usi],
-	  tbw = spr2d->width/tbx, tbh = spr2d->height/tby,
+	  tbw = spr2d->width/(tr.right - tr.left), tbh = spr2d->height/(tr.bottom - tr.top),
 	  w = width*xscale, h = height*yscale;
 
     rot *= M_PI/180;
@@ -207,14 +213,14 @@ void draw_sprite_general(int spr, int subimg, gs_scalar left, gs_scalar top, gs_
     ulcx = x + xscale * cos(M_PI+rot) + yscale * cos(M_PI/2+rot),
     ulcy = y - yscale * sin(M_PI+rot) - yscale * sin(M_PI/2+rot);
 
-	draw_vertex_texture_color(ulcx, ulcy, left/tbw, top/tbh, c1, alpha);
-	draw_vertex_texture_color((ulcx + wcosrot), (ulcy - wsinrot), (left+width)/tbw, top/tbh, c2, alpha);
+	draw_vertex_texture_color(ulcx, ulcy, tr.left + left/tbw, tr.top + top/tbh, c1, alpha);
+	draw_vertex_texture_color((ulcx + wcosrot), (ulcy - wsinrot), tr.left + (left+width)/tbw, tr.top + top/tbh, c2, alpha);
 
     ulcx += h * cos(3*M_PI/2 + rot);
     ulcy -= h * sin(3*M_PI/2 + rot);
 
-	draw_vertex_texture_color((ulcx + wcosrot), (ulcy - wsinrot), (left+width)/tbw, (top+height)/tbh, c4, alpha);
-	draw_vertex_texture_color(ulcx, ulcy, left/tbw, (top+height)/tbh, c3, alpha);
+	draw_vertex_texture_color((ulcx + wcosrot), (ulcy - wsinrot), tr.left + (left+width)/tbw, tr.top + (top+height)/tbh, c4, alpha);
+	draw_vertex_texture_color(ulcx, ulcy, tr.left + left/tbw, tr.top + (top+height)/tbh, c3, alpha);
 
     draw_primitive_end();
 }
@@ -224,16 +230,17 @@ void draw_sprite_stretched(int spr, int subimg, gs_scalar x, gs_scalar y, gs_sca
     alpha=clamp_alpha(alpha);
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
+    const enigma::texture_rect &tr = spr2d->texrectarray[usi];
 
-    const gs_scalar tbx = spr2d->texbordxarray[usi], tby = spr2d->texbordyarray[usi],
+    const gs_scalar tbx1 = tr.left, tby1 = tr.top, tbx2 = tr.right, tby2 = tr.bottom,
                 xvert1 = x-spr2d->xoffset, xvert2 = xvert1 + width,
                 yvert1 = y-spr2d->yoffset, yvert2 = yvert1 + height;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-	draw_vertex_texture_color(xvert1,yvert1,0,0,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbx,0,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2, 0,tby,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert2, tbx,tby,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tbx1,tby1,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tbx2,tby1,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2, tbx1,tby2,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert2, tbx2,tby2,color,alpha);
 	draw_primitive_end();
 }
 
@@ -242,16 +249,17 @@ void draw_sprite_stretched_ext(int spr, int subimg, gs_scalar x, gs_scalar y, gs
     alpha=clamp_alpha(alpha);
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
+    const enigma::texture_rect &tr = spr2d->texrectarray[usi];
 
-    const gs_scalar tbx = spr2d->texbordxarray[usi], tby = spr2d->texbordyarray[usi],
+    const gs_scalar tbx1 = tr.left, tby1 = tr.top, tbx2 = tr.right, tby2 = tr.bottom,
                 xvert1 = x-spr2d->xoffset, xvert2 = xvert1 + width,
                 yvert1 = y-spr2d->yoffset, yvert2 = yvert1 + height;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-	draw_vertex_texture_color(xvert1,yvert1,0,0,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbx,0,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2, 0,tby,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert2, tbx,tby,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tbx1,tby1,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tbx2,tby1,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2, tbx1,tby2,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert2, tbx2,tby2,color,alpha);
 	draw_primitive_end();
 }
 
@@ -259,16 +267,17 @@ void d3d_draw_sprite(int spr,int subimg, gs_scalar x, gs_scalar y, gs_scalar z)
 {
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
+    const enigma::texture_rect &tr = spr2d->texrectarray[usi];
 
-	const gs_scalar tbx = spr2d->texbordxarray[usi], tby = spr2d->texbordyarray[usi],
+	const gs_scalar tbx1 = tr.left, tby1 = tr.top, tbx2 = tr.right, tby2 = tr.bottom,
 			xvert1 = x-spr2d->xoffset, xvert2 = xvert1 + spr2d->width,
 			yvert1 = y-spr2d->yoffset, yvert2 = yvert1 + spr2d->height;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-	d3d_vertex_texture(xvert1,yvert1,z,0,0);
-	d3d_vertex_texture(xvert2,yvert1,z,tbx,0);
-	d3d_vertex_texture(xvert1,yvert2,z,0,tby);
-	d3d_vertex_texture(xvert2,yvert2,z,tbx,tby);
+	d3d_vertex_texture(xvert1,yvert1,z,tbx1,tby1);
+	d3d_vertex_texture(xvert2,yvert1,z,tbx2,tby1);
+	d3d_vertex_texture(xvert1,yvert2,z,tbx1,tby2);
+	d3d_vertex_texture(xvert2,yvert2,z,tbx2,tby2);
 	draw_primitive_end();
 }
 
@@ -278,6 +287,7 @@ void draw_sprite_padded(int spr, int subimg, gs_scalar left, gs_scalar top, gs_s
   alpha=clamp_alpha(alpha);
   get_spritev(spr2d,spr);
   const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
+  const enigma::texture_rect &tr = spr2d->texrectarray[usi];
 
 	//Order x1,y1,x2,y2 correctly
 	if (x1>x2) {gs_scalar tx = x2; x2 = x1, x1 = tx;}
@@ -290,7 +300,7 @@ void draw_sprite_padded(int spr, int subimg, gs_scalar left, gs_scalar top, gs_s
 
 	const gs_scalar midw = w-left-right, midh = h-top-bottom;
 	const gs_scalar midtw = spr2d->width-left-right, midth = spr2d->height-bottom-top;
-	const gs_scalar tbw = spr2d->width/(gs_scalar)spr2d->texbordxarray[usi], tbh = spr2d->height/(gs_scalar)spr2d->texbordyarray[usi];
+	const gs_scalar tbw = spr2d->width/(gs_scalar)(tr.right - tr.left), tbh = spr2d->height/(gs_scalar)(tr.bottom - tr.top);
 	const gs_scalar tbl = left/tbw, tbt = top/tbh, tbr = right/tbw, tbb = bottom/tbh, tbmw = midtw/tbw, tbmh = midth/tbh;
 
   //Draw top-left corner
@@ -298,28 +308,28 @@ void draw_sprite_padded(int spr, int subimg, gs_scalar left, gs_scalar top, gs_s
 	          yvert1 = y1, yvert2 = yvert1 + top;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-	draw_vertex_texture_color(xvert1,yvert1,0.0,0.0,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbl,0.0,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2,0.0,tbt,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert2,tbl,tbt,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tr.left,tr.top,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tr.left+tbl,tr.top,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2,tr.left,tr.top+tbt,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert2,tr.left+tbl,tr.top+tbt,color,alpha);
 
 	//Draw left side
 	xvert1 = x1, xvert2 = xvert1 + left,
 	yvert1 = y1 + top, yvert2 = yvert1 + midh;
 
-	draw_vertex_texture_color(xvert1,yvert1,0.0,tbt,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbl,tbt,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2,0.0,tbt+tbmh,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert2,tbl,tbt+tbmh,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tr.left,tr.top+tbt,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tr.left+tbl,tr.top+tbt,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2,tr.left,tr.top+tbt+tbmh,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert2,tr.left+tbl,tr.top+tbt+tbmh,color,alpha);
 
 	//Draw bottom-left corner
 	xvert1 = x1, xvert2 = xvert1 + left,
 	yvert1 = y1 + top + midh, yvert2 = yvert1 + bottom;
 
-	draw_vertex_texture_color(xvert1,yvert1,0.0,tbt+tbmh,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbl,tbt+tbmh,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2,0.0,tbt+tbmh+tbb,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert2,tbl,tbt+tbmh+tbb,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tr.left,tr.top+tbt+tbmh,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tr.left+tbl,tr.top+tbt+tbmh,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2,tr.left,tr.top+tbt+tbmh+tbb,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert2,tr.left+tbl,tr.top+tbt+tbmh+tbb,color,alpha);
 	draw_primitive_end();
 
 	//Draw top
@@ -327,28 +337,28 @@ void draw_sprite_padded(int spr, int subimg, gs_scalar left, gs_scalar top, gs_s
   yvert1 = y1, yvert2 = yvert1 + top;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-	draw_vertex_texture_color(xvert1,yvert1,tbl,0.0,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbl+tbmw,0.0,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2,tbl,tbt,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert2,tbl+tbmw,tbt,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tr.left+tbl,tr.top,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tr.left+tbl+tbmw,tr.top,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2,tr.left+tbl,tr.top+tbt,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert2,tr.left+tbl+tbmw,tr.top+tbt,color,alpha);
 
   //Draw middle
   xvert1 = x1 + left, xvert2 = xvert1 + midw,
   yvert1 = y1 + top, yvert2 = yvert1 + midh;
 
-	draw_vertex_texture_color(xvert1,yvert1,tbl,tbt,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbl+tbmw,tbt,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2,tbl,tbt+tbmh,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert2,tbl+tbmw,tbt+tbmh,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tr.left+tbl,tr.top+tbt,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tr.left+tbl+tbmw,tr.top+tbt,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2,tr.left+tbl,tr.top+tbt+tbmh,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert2,tr.left+tbl+tbmw,tr.top+tbt+tbmh,color,alpha);
 
 	//Draw bottom
   xvert1 = x1 + left, xvert2 = xvert1 + midw,
   yvert1 = y1 + midh + top, yvert2 = yvert1 + bottom;
 
-	draw_vertex_texture_color(xvert1,yvert1,tbl,tbt+tbmh,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbl+tbmw,tbt+tbmh,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2,tbl,tbt+tbmh+tbb,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert2,tbl+tbmw,tbt+tbmh+tbb,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tr.left+tbl,tr.top+tbt+tbmh,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tr.left+tbl+tbmw,tr.top+tbt+tbmh,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2,tr.left+tbl,tr.top+tbt+tbmh+tbb,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert2,tr.left+tbl+tbmw,tr.top+tbt+tbmh+tbb,color,alpha);
 	draw_primitive_end();
 
 	//Draw top-right corner
@@ -356,28 +366,28 @@ void draw_sprite_padded(int spr, int subimg, gs_scalar left, gs_scalar top, gs_s
   yvert1 = y1, yvert2 = yvert1 + top;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-	draw_vertex_texture_color(xvert1,yvert1,tbl+tbmw,0.0,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbl+tbmw+tbr,0.0,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2,tbl+tbmw,tbt,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert2,tbl+tbmw+tbr,tbt,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tr.left+tbl+tbmw,tr.top,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tr.left+tbl+tbmw+tbr,tr.top,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2,tr.left+tbl+tbmw,tr.top+tbt,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert2,tr.left+tbl+tbmw+tbr,tr.top+tbt,color,alpha);
 
 	//Draw right side
 	xvert1 = x1 + midw + left, xvert2 = xvert1 + right,
 	yvert1 = y1 + top, yvert2 = yvert1 + midh;
 
-	draw_vertex_texture_color(xvert1,yvert1,tbl+tbmw,tbt,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbl+tbmw+tbr,tbt,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2,tbl+tbmw,tbt+tbmh,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert2,tbl+tbmw+tbr,tbt+tbmh,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tr.left+tbl+tbmw,tr.top+tbt,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tr.left+tbl+tbmw+tbr,tr.top+tbt,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2,tr.left+tbl+tbmw,tr.top+tbt+tbmh,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert2,tr.left+tbl+tbmw+tbr,tr.top+tbt+tbmh,color,alpha);
 
 	//Draw bottom-right corner
     xvert1 = x1 + midw + left, xvert2 = xvert1 + right,
     yvert1 = y1 + top + midh, yvert2 = yvert1 + bottom;
 
-	draw_vertex_texture_color(xvert1,yvert1,tbl+tbmw,tbt+tbmh,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbl+tbmw+tbr,tbt+tbmh,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2,tbl+tbmw,tbt+tbmh+tbb,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert2,tbl+tbmw+tbr,tbt+tbmh+tbb,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tr.left+tbl+tbmw,tr.top+tbt+tbmh,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tr.left+tbl+tbmw+tbr,tr.top+tbt+tbmh,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2,tr.left+tbl+tbmw,tr.top+tbt+tbmh+tbb,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert2,tr.left+tbl+tbmw+tbr,tr.top+tbt+tbmh+tbb,color,alpha);
 	draw_primitive_end();
 }
 
@@ -399,11 +409,12 @@ void draw_sprite_tiled(int spr, int subimg, gs_scalar x, gs_scalar y, int color,
     alpha=clamp_alpha(alpha);
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
+    const enigma::texture_rect &tr = spr2d->texrectarray[usi];
 
     x = ((spr2d->xoffset+x)<0?0:spr2d->width)-fmod(spr2d->xoffset+x,spr2d->width);
     y = ((spr2d->yoffset+y)<0?0:spr2d->height)-fmod(spr2d->yoffset+y,spr2d->height);
 
-    const gs_scalar tbx  = spr2d->texbordxarray[usi], tby  = spr2d->texbordyarray[usi];
+    const gs_scalar tbx1 = tr.left, tby1 = tr.top, tbx2 = tr.right, tby2 = tr.bottom;
 
     const int
     hortil = int(ceil((view_enabled ? (gs_scalar)(view_xview[view_current] + view_wview[view_current]) : (gs_scalar)room_width) / ((gs_scalar)spr2d->width))) + 1,
@@ -416,10 +427,10 @@ void draw_sprite_tiled(int spr, int subimg, gs_scalar x, gs_scalar y, int color,
         for (int c=0; c<vertil; ++c)
         {
 			draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-			draw_vertex_texture_color(xvert1,yvert1,0,0,color,alpha);
-			draw_vertex_texture_color(xvert2,yvert1,tbx,0,color,alpha);
-			draw_vertex_texture_color(xvert1,yvert2,0,tby,color,alpha);
-			draw_vertex_texture_color(xvert2,yvert2,tbx,tby,color,alpha);
+			draw_vertex_texture_color(xvert1,yvert1,tbx1,tby1,color,alpha);
+			draw_vertex_texture_color(xvert2,yvert1,tbx2,tby1,color,alpha);
+			draw_vertex_texture_color(xvert1,yvert2,tbx1,tby2,color,alpha);
+			draw_vertex_texture_color(xvert2,yvert2,tbx2,tby2,color,alpha);
 			draw_primitive_end();
             yvert1 = yvert2;
             yvert2 += spr2d->height;
@@ -434,9 +445,10 @@ void draw_sprite_tiled_ext(int spr, int subimg, gs_scalar x, gs_scalar y, gs_sca
     alpha=clamp_alpha(alpha);
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
+    const enigma::texture_rect &tr = spr2d->texrectarray[usi];
 
     const gs_scalar
-    tbx  = spr2d->texbordxarray[usi], tby  = spr2d->texbordyarray[usi],
+    tbx1 = tr.left, tby1 = tr.top, tbx2 = tr.right, tby2 = tr.bottom,
     width_scaled = spr2d->width*xscale, height_scaled = spr2d->height*yscale;
 
     x = ((spr2d->xoffset*xscale+x)<0?0:width_scaled)-fmod(spr2d->xoffset*xscale+x,width_scaled);
@@ -453,10 +465,10 @@ void draw_sprite_tiled_ext(int spr, int subimg, gs_scalar x, gs_scalar y, gs_sca
         for (int c=0; c<vertil; ++c)
         {
 			draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-			draw_vertex_texture_color(xvert1,yvert1,0,0,color,alpha);
-			draw_vertex_texture_color(xvert2,yvert1,tbx,0,color,alpha);
-			draw_vertex_texture_color(xvert1,yvert2,0,tby,color,alpha);
-			draw_vertex_texture_color(xvert2,yvert2,tbx,tby,color,alpha);
+			draw_vertex_texture_color(xvert1,yvert1,tbx1,tby1,color,alpha);
+			draw_vertex_texture_color(xvert2,yvert1,tbx2,tby1,color,alpha);
+			draw_vertex_texture_color(xvert1,yvert2,tbx1,tby2,color,alpha);
+			draw_vertex_texture_color(xvert2,yvert2,tbx2,tby2,color,alpha);
 			draw_primitive_end();
             yvert1 = yvert2;
             yvert2 += height_scaled;
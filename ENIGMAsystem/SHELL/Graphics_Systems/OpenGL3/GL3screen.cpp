@@ -201,6 +201,7 @@ static inline void draw_insts()
       if (instance_event_iterator == inst_depth->depth.myiter) {
         instance_event_iterator = inst_depth->depth.myiter->prev;
       }
+      retire_inst_iter(inst_depth->depth.myiter);
       inst_depth->depth.myiter = mynewiter;
     }
   }
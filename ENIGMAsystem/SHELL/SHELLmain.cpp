@@ -134,9 +134,8 @@ namespace enigma
     
     // Now clean up instances and free them from memory.
     for (enigma::iterator it = instance_list_first(); it; ++it)
-    { 
-        it->unlink(); delete *it; 
-    }
+      it->unlink();
+    dispose_destroyed_instances();
     return 0;
   }
 }
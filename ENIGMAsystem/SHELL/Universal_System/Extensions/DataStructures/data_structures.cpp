@@ -36,6 +36,8 @@
 
 #include <sstream>
 #include <string>
+#include <cstring>
+#include <functional>
 
 #include <floatcomp.h>
 
@@ -54,32 +56,133 @@ template<typename t> bool tequal(t v1, t v2) { return v1 == v2; }
 template<> bool tequal(float v1, float v2)   { return fequal(v1, v2); }
 template<> bool tequal(double v1, double v2) { return fequal(v1, v2); }
 
+// Cells of a grid compare as the values they stand for, so packed ds_grid reals compare as variants do.
+template<typename t> bool cell_equal(t v1, t v2) { return tequal(v1, v2); }
+template<> bool cell_equal(double v1, double v2) { return fabs(v1 - v2) < var_e; }
+
+// Empties the stand-in that ds_table hands out for IDs that don't exist.
+template <typename t> void ds_reset(t &val) { val = t(); }
+
+// Data structures indexed by ID, resolved with a single array access. IDs are handed out in
+// sequence and never reused, so a stale ID can never reach a structure created after it.
+// The table only grows when a structure is created. Indexing an ID that does not exist, such as
+// noone or a destroyed structure, gives an empty stand-in, and anything written to it is dropped.
+template <typename t>
+class ds_table
+{
+    vector<t*> items;
+    unsigned int live;
+    t missing;
+
+    public:
+    ds_table(): live(0) {}
+    unsigned int add(const t &val = t())
+    {
+        items.push_back(new t(val));
+        live++;
+        return items.size() - 1;
+    }
+    t &operator[](const unsigned int id)
+    {
+        if (exists(id))
+            return *items[id];
+        ds_reset(missing);
+        return missing;
+    }
+    bool exists(const unsigned int id) const
+    {
+        return id < items.size() && items[id];
+    }
+    void erase(const unsigned int id)
+    {
+        if (exists(id))
+        {
+            delete items[id];
+            items[id] = NULL;
+            live--;
+        }
+    }
+    // Number of structures currently alive.
+    unsigned int count() const
+    {
+        return live;
+    }
+};
+
 template <typename t>
 class grid
 {
+    template <typename> friend class grid;
+
     unsigned int xgrid, ygrid;
     t *grid_array;
 
+    static bool in_disk(const double x, const double y, const double rr, const int ii, const int i)
+    {
+        return (x - ii)*(x - ii) + (y - i)*(y - i) <= rr;
+    }
+    // Narrows the cells [lo, hi) of row i to those inside the disk, which are always contiguous.
+    static void disk_span(const double x, const double y, const double rr, const int i, int &lo, int &hi)
+    {
+        const double dy2 = (y - i)*(y - i);
+        if (!(dy2 <= rr))
+        {
+            hi = lo;
+            return;
+        }
+        const double s = sqrt(rr - dy2);
+        int a = int(maxv(double(lo), ceil(x - s))), b = int(minv(double(hi), floor(x + s) + 1));
+        // The square root can round either way, so settle both ends on the exact test.
+        while (a > lo && in_disk(x, y, rr, a - 1, i)) a--;
+        while (a < b && !in_disk(x, y, rr, a, i)) a++;
+        while (b < hi && in_disk(x, y, rr, b, i)) b++;
+        while (b > a && !in_disk(x, y, rr, b - 1, i)) b--;
+        lo = a, hi = maxv(a, b);
+    }
+
     public:
-    grid() {}
+    grid(): xgrid(0), ygrid(0), grid_array(NULL) {}
     grid(const unsigned int w, const unsigned int h) {
       ygrid = h; xgrid = w; grid_array = new t[w*h];
     }
     ~grid() {}
 
+    // Clips the region between two corners to the grid, giving the cells [px1, px2) x [py1, py2).
+    bool clip_region(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, int &px1, int &py1, int &px2, int &py2) const
+    {
+       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
+       if (xd <= 0 || yd <= 0)
+           return false;
+       px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
+       return true;
+    }
+    // Clips the bounding box of a disk to the grid, giving the cells [px1, px2) x [py1, py2).
+    bool clip_disk(const double x, const double y, const double r, int &px1, int &py1, int &px2, int &py2) const
+    {
+        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
+        if (tx2 < 0 || ty2 < 0 || tx1 >= int(xgrid) || ty1 >= int(ygrid))
+            return false;
+        px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
+        return true;
+    }
+
     void destroy()
     {
         delete[] grid_array;
+        grid_array = NULL;
+        xgrid = ygrid = 0;
     }
     void clear(const t val)
     {
-        for (unsigned i = 0; i < ygrid; i++)
-            for (unsigned ii = 0; ii < xgrid; ii++)
-                grid_array[i * xgrid + ii] = val;
+        const unsigned int n = xgrid*ygrid;
+        for (unsigned i = 0; i < n; i++)
+            grid_array[i] = val;
     }
-    void resize(unsigned w, unsigned h)
+    // Cells added by growing the grid are left as t() by default.
+    void resize(unsigned w, unsigned h, const t fill = t())
     {
-        grid<variant> temp(w, h);
+        grid temp(w, h);
+        temp.clear(fill);
         const unsigned int wm = minv(xgrid, w), hm = minv(ygrid, h);
         for (unsigned i = 0; i < hm; i++)
             for (unsigned ii = 0; ii < wm; ii++)
@@ -87,21 +190,21 @@ class grid
         delete[] grid_array;
         (*this) = temp;
     }
-    void copy(const grid& copy_id)
+    template <typename s> void copy(const grid<s>& copy_id)
     {
         delete[] grid_array;
         grid_array = new t[copy_id.ygrid*copy_id.xgrid];
         xgrid = copy_id.xgrid;
         ygrid = copy_id.ygrid;
-        for (unsigned i = 0; i < ygrid; i++)
-            for (unsigned ii = 0; ii < xgrid; ii++)
-                grid_array[i * xgrid + ii] = copy_id.grid_array[i * copy_id.xgrid + ii];
+        const unsigned int n = xgrid*ygrid;
+        for (unsigned i = 0; i < n; i++)
+            grid_array[i] = copy_id.grid_array[i];
     }
-    unsigned int width()
+    unsigned int width() const
     {
         return xgrid;
     }
-    unsigned int height()
+    unsigned int height() const
     {
         return ygrid;
     }
@@ -120,79 +223,85 @@ class grid
         if (x < xgrid && y < ygrid)
             grid_array[y * xgrid + x] *= val;
     }
+
+    // The region and disk operations below walk each row of cells as one contiguous run, so that
+    // over a grid of doubles the compiler can vectorize the inner loops.
     void insert_region(const unsigned int x1, const unsigned int y1, unsigned int x2, const unsigned int y2, const t val)
     {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
+       int px1, py1, px2, py2;
+       if (clip_region(x1, y1, x2, y2, px1, py1, px2, py2))
            for (int i = py1; i < py2; i++)
+           {
+               t *const row = grid_array + i * xgrid;
                for (int ii = px1; ii < px2; ii++)
-                   grid_array[i * xgrid + ii] = val;
-       }
+                   row[ii] = val;
+           }
     }
     void add_region(const unsigned int x1, const unsigned int y1, unsigned int x2, const unsigned int y2, const t val)
     {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
+       int px1, py1, px2, py2;
+       if (clip_region(x1, y1, x2, y2, px1, py1, px2, py2))
            for (int i = py1; i < py2; i++)
+           {
+               t *const row = grid_array + i * xgrid;
                for (int ii = px1; ii < px2; ii++)
-                   grid_array[i * xgrid + ii] += val;
-       }
+                   row[ii] += val;
+           }
     }
     void multiply_region(const unsigned int x1, const unsigned int y1, unsigned int x2, const unsigned int y2, const double val)
     {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
+       int px1, py1, px2, py2;
+       if (clip_region(x1, y1, x2, y2, px1, py1, px2, py2))
            for (int i = py1; i < py2; i++)
+           {
+               t *const row = grid_array + i * xgrid;
                for (int ii = px1; ii < px2; ii++)
-                   grid_array[i * xgrid + ii] *= val;
-       }
+                   row[ii] *= val;
+           }
     }
     void insert_disk(const double x, const double y, const double r, const t val)
     {
         const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
+        int px1, py1, px2, py2;
+        if (clip_disk(x, y, r, px1, py1, px2, py2))
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        grid_array[i * xgrid + ii] = val;
-        }
+            {
+                int lo = px1, hi = px2;
+                disk_span(x, y, rr, i, lo, hi);
+                t *const row = grid_array + i * xgrid;
+                for (int ii = lo; ii < hi; ii++)
+                    row[ii] = val;
+            }
     }
     void add_disk(const double x, const double y, const double r, const t val)
     {
         const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
+        int px1, py1, px2, py2;
+        if (clip_disk(x, y, r, px1, py1, px2, py2))
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        grid_array[i * xgrid + ii] += val;
-        }
+            {
+                int lo = px1, hi = px2;
+                disk_span(x, y, rr, i, lo, hi);
+                t *const row = grid_array + i * xgrid;
+                for (int ii = lo; ii < hi; ii++)
+                    row[ii] += val;
+            }
     }
     void multiply_disk(const double x, const double y, const double r, const double val)
     {
         const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
+        int px1, py1, px2, py2;
+        if (clip_disk(x, y, r, px1, py1, px2, py2))
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        grid_array[i * xgrid + ii] *= val;
-        }
+            {
+                int lo = px1, hi = px2;
+                disk_span(x, y, rr, i, lo, hi);
+                t *const row = grid_array + i * xgrid;
+                for (int ii = lo; ii < hi; ii++)
+                    row[ii] *= val;
+            }
     }
-    void insert_grid_region(const grid& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
+    template <typename s> void insert_grid_region(const grid<s>& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
     {
         if (x < xgrid && y < ygrid)
         {
@@ -206,7 +315,7 @@ class grid
             }
         }
     }
-    void add_grid_region(const grid& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
+    template <typename s> void add_grid_region(const grid<s>& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
     {
         if (x < xgrid && y < ygrid)
         {
@@ -220,7 +329,7 @@ class grid
             }
         }
     }
-    void multiply_grid_region(const grid& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
+    template <typename s> void multiply_grid_region(const grid<s>& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
     {
         if (x < xgrid && y < ygrid)
         {
@@ -235,247 +344,657 @@ class grid
         }
     }
 
-    t find(unsigned int x, unsigned int y)
+    t find(unsigned int x, unsigned int y) const
     {
         return (grid_array[y * xgrid + x]);
     }
-    t find_region_sum(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2)
+    t find_region_sum(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2) const
     {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
+       int px1, py1, px2, py2;
+       if (clip_region(x1, y1, x2, y2, px1, py1, px2, py2))
        {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
-           variant sum = 0;
+           t sum = 0;
            for (int i = py1; i < py2; i++)
+           {
+               const t *const row = grid_array + i * xgrid;
                for (int ii = px1; ii < px2; ii++)
-                   sum += grid_array[i * xgrid + ii];
+                   sum += row[ii];
+           }
            return sum;
        }
        return t();
     }
-    t find_region_max(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2)
+    t find_region_max(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2) const
     {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       t val_check;
-       if (xd > 0 && yd > 0)
+       int px1, py1, px2, py2;
+       if (clip_region(x1, y1, x2, y2, px1, py1, px2, py2))
        {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
            t max_check = grid_array[py1 * xgrid + px1];
            for (int i = py1; i < py2; i++)
+           {
+               const t *const row = grid_array + i * xgrid;
                for (int ii = px1; ii < px2; ii++)
-               {
-                   val_check = grid_array[i * xgrid + ii];
-                   if (val_check > max_check)
-                       max_check = val_check;
-               }
+                   if (row[ii] > max_check)
+                       max_check = row[ii];
+           }
            return max_check;
        }
        return t();
     }
-    t find_region_min(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2)
+    t find_region_min(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2) const
     {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       t val_check;
-       if (xd > 0 && yd > 0)
+       int px1, py1, px2, py2;
+       if (clip_region(x1, y1, x2, y2, px1, py1, px2, py2))
        {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
            t min_check = grid_array[py1 * xgrid + px1];
            for (int i = py1; i < py2; i++)
+           {
+               const t *const row = grid_array + i * xgrid;
                for (int ii = px1; ii < px2; ii++)
-               {
-                   val_check = grid_array[i * xgrid + ii];
-                   if (val_check < min_check)
-                       min_check = val_check;
-               }
+                   if (row[ii] < min_check)
+                       min_check = row[ii];
+           }
            return min_check;
        }
        return t();
     }
-    t find_region_mean(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2)
+    t find_region_mean(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2) const
     {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
+       int px1, py1, px2, py2;
+       if (clip_region(x1, y1, x2, y2, px1, py1, px2, py2))
        {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
-           t sum = 0;
-           for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   sum += grid_array[i * xgrid + ii];
            const double region_size = (py2 - py1)*(px2 - px1);
-           return sum/region_size;
+           return find_region_sum(x1, y1, x2, y2)/region_size;
        }
        return t();
     }
-    t find_disk_sum(const double x, const double y, const double r)
+    t find_disk_sum(const double x, const double y, const double r) const
     {
         const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
+        int px1, py1, px2, py2;
+        if (clip_disk(x, y, r, px1, py1, px2, py2))
         {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
             t sum = t();
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        sum += grid_array[i * xgrid + ii];
+            {
+                int lo = px1, hi = px2;
+                disk_span(x, y, rr, i, lo, hi);
+                const t *const row = grid_array + i * xgrid;
+                for (int ii = lo; ii < hi; ii++)
+                    sum += row[ii];
+            }
             return sum;
         }
         return t();
     }
-    t find_disk_max(const double x, const double y, const double r)
+    t find_disk_max(const double x, const double y, const double r) const
     {
         const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
+        int px1, py1, px2, py2;
+        if (clip_disk(x, y, r, px1, py1, px2, py2))
         {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
             t max_check = grid_array[py1 * xgrid + px1];
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                    {
-                        const double val_check = grid_array[i * xgrid + ii];
-                        if (val_check > max_check)
-                            max_check = val_check;
-                    }
+            {
+                int lo = px1, hi = px2;
+                disk_span(x, y, rr, i, lo, hi);
+                const t *const row = grid_array + i * xgrid;
+                for (int ii = lo; ii < hi; ii++)
+                {
+                    const double val_check = row[ii];
+                    if (val_check > max_check)
+                        max_check = val_check;
+                }
+            }
             return max_check;
         }
         return t();
     }
-    t find_disk_min(const double x, const double y, const double r)
+    t find_disk_min(const double x, const double y, const double r) const
     {
         const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
+        int px1, py1, px2, py2;
+        if (clip_disk(x, y, r, px1, py1, px2, py2))
         {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
             t min_check = grid_array[lrint(y) * xgrid + lrint(x)];
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                    {
-                        const double val_check = grid_array[i * xgrid + ii];
-                        if (val_check < min_check)
-                            min_check = val_check;
-                    }
+            {
+                int lo = px1, hi = px2;
+                disk_span(x, y, rr, i, lo, hi);
+                const t *const row = grid_array + i * xgrid;
+                for (int ii = lo; ii < hi; ii++)
+                {
+                    const double val_check = row[ii];
+                    if (val_check < min_check)
+                        min_check = val_check;
+                }
+            }
             return min_check;
         }
         return t();
     }
-    t find_disk_mean(const double x, const double y, const double r)
+    t find_disk_mean(const double x, const double y, const double r) const
     {
         const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
+        int px1, py1, px2, py2;
+        if (clip_disk(x, y, r, px1, py1, px2, py2))
         {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
             t sum = t();
             double region_size = 0;
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                    {
-                        sum += grid_array[i * xgrid + ii];
-                        ++region_size;
-                    }
+            {
+                int lo = px1, hi = px2;
+                disk_span(x, y, rr, i, lo, hi);
+                const t *const row = grid_array + i * xgrid;
+                for (int ii = lo; ii < hi; ii++)
+                    sum += row[ii];
+                region_size += hi - lo;
+            }
            return sum/region_size;
         }
         return t();
     }
-    bool value_region_exists(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, const t val)
+    bool value_region_exists(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, const t val) const
     {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
+       int px1, py1, px2, py2;
+       if (clip_region(x1, y1, x2, y2, px1, py1, px2, py2))
            for (int i = py1; i < py2; i++)
                for (int ii = px1; ii < px2; ii++)
-                   if (tequal(grid_array[i * xgrid + ii], val))
+                   if (cell_equal(grid_array[i * xgrid + ii], val))
                        return true;
-       }
        return false;
     }
-    int value_region_x(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, const t val)
+    int value_region_x(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, const t val) const
     {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
+       int px1, py1, px2, py2;
+       if (clip_region(x1, y1, x2, y2, px1, py1, px2, py2))
            for (int i = py1; i < py2; i++)
                for (int ii = px1; ii < px2; ii++)
-                   if (tequal(grid_array[i * xgrid + ii], val))
+                   if (cell_equal(grid_array[i * xgrid + ii], val))
                       return ii;
-       }
        return 0;
     }
-    int value_region_y(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, const t val)
+    int value_region_y(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, const t val) const
     {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
+       int px1, py1, px2, py2;
+       if (clip_region(x1, y1, x2, y2, px1, py1, px2, py2))
            for (int i = py1; i < py2; i++)
                for (int ii = px1; ii < px2; ii++)
-                   if (tequal(grid_array[i * xgrid + ii], val))
+                   if (cell_equal(grid_array[i * xgrid + ii], val))
                        return i;
-       }
        return 0;
     }
-    bool value_disk_exists(const double x, const double y, const double r, const t val)
+    bool value_disk_exists(const double x, const double y, const double r, const t val) const
     {
         const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
+        int px1, py1, px2, py2;
+        if (clip_disk(x, y, r, px1, py1, px2, py2))
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        if (tequal(grid_array[i * xgrid + ii], val))
-                            return true;
-        }
+            {
+                int lo = px1, hi = px2;
+                disk_span(x, y, rr, i, lo, hi);
+                for (int ii = lo; ii < hi; ii++)
+                    if (cell_equal(grid_array[i * xgrid + ii], val))
+                        return true;
+            }
         return false;
     }
-    int value_disk_x(const double x, const double y, const double r, const t val)
+    int value_disk_x(const double x, const double y, const double r, const t val) const
     {
         const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
+        int px1, py1, px2, py2;
+        if (clip_disk(x, y, r, px1, py1, px2, py2))
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        if (tequal(grid_array[i * xgrid + ii], val))
-                            return i;
-        }
+            {
+                int lo = px1, hi = px2;
+                disk_span(x, y, rr, i, lo, hi);
+                for (int ii = lo; ii < hi; ii++)
+                    if (cell_equal(grid_array[i * xgrid + ii], val))
+                        return i;
+            }
         return 0;
     }
-    int value_disk_y(const double x, const double y, const double r, const t val)
+    int value_disk_y(const double x, const double y, const double r, const t val) const
     {
         const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
+        int px1, py1, px2, py2;
+        if (clip_disk(x, y, r, px1, py1, px2, py2))
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        if (tequal(grid_array[i * xgrid + ii], val))
-                            return ii;
-        }
+            {
+                int lo = px1, hi = px2;
+                disk_span(x, y, rr, i, lo, hi);
+                for (int ii = lo; ii < hi; ii++)
+                    if (cell_equal(grid_array[i * xgrid + ii], val))
+                        return ii;
+            }
         return 0;
     }
     void shuffle()
     {
         random_shuffle(grid_array, grid_array + (xgrid*ygrid - 1));
     }
+
+    // Writes the summed area table of the grid to sums, which gets (width + 1) * (height + 1)
+    // entries; entry (x, y) is the sum of the cells [0, x) x [0, y).
+    // Returns whether differences of its entries give sums exactly. That holds when every cell is a
+    // whole number and their magnitudes add up to no more than 2^53; otherwise, infinities would
+    // cancel into NaN and large entries would swamp the low bits of small regions.
+    bool summed_area(vector<double> &sums) const
+    {
+        const unsigned int stride = xgrid + 1;
+        sums.assign(stride * (ygrid + 1), 0);
+        bool whole = true;
+        double magnitude = 0;
+        for (unsigned i = 0; i < ygrid; i++)
+        {
+            double run = 0;
+            for (unsigned ii = 0; ii < xgrid; ii++)
+            {
+                const double cell = grid_array[i * xgrid + ii];
+                whole = whole && cell == floor(cell);
+                magnitude += fabs(cell);
+                run += cell;
+                sums[(i + 1) * stride + ii + 1] = sums[i * stride + ii + 1] + run;
+            }
+        }
+        return whole && magnitude <= 9007199254740992.0;
+    }
+};
+
+// The grid behind ds_grid. While every cell holds a real, the cells are packed in a grid of
+// doubles; the first value of any other type written to a cell moves the grid over to variant
+// cells, and clearing it to a real packs it again.
+// Packed grids also keep a summed area table, making region sums and means constant time. It is
+// rebuilt lazily, and only once the queries since the last change have cost as much as a rebuild.
+// It is only used while it gives exactly the sums a direct sum would; see grid::summed_area.
+class variant_grid
+{
+    grid<double> reals;
+    grid<variant> cells;
+    bool packed;
+    vector<double> sums;
+    bool sums_valid;
+    double summed_cells; // Cells summed without the table since the last change
+
+    static bool is_real(const variant &val)
+    {
+        return val.type == enigma::vt_real;
+    }
+    void unpack()
+    {
+        if (packed)
+        {
+            cells.copy(reals);
+            reals.destroy();
+            sums.clear();
+            sums_valid = false;
+            packed = false;
+        }
+    }
+    void changed()
+    {
+        sums_valid = false;
+        summed_cells = 0;
+    }
+    // Returns the sum of the cells [px1, px2) x [py1, py2) of a packed grid.
+    double region_sum(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, int px1, int py1, int px2, int py2)
+    {
+        if (!sums_valid)
+        {
+            summed_cells += double(px2 - px1) * (py2 - py1);
+            if (summed_cells < double(reals.width()) * reals.height())
+                return reals.find_region_sum(x1, y1, x2, y2);
+            if (!reals.summed_area(sums))
+            {
+                // Sum directly until the grid changes again.
+                sums.clear();
+                summed_cells = -HUGE_VAL;
+                return reals.find_region_sum(x1, y1, x2, y2);
+            }
+            sums_valid = true;
+        }
+        const unsigned int stride = reals.width() + 1;
+        return sums[py2 * stride + px2] - sums[py1 * stride + px2] - sums[py2 * stride + px1] + sums[py1 * stride + px1];
+    }
+
+    public:
+    variant_grid(): packed(true), sums_valid(false), summed_cells(0) {}
+    variant_grid(const unsigned int w, const unsigned int h): reals(w, h), packed(true), sums_valid(false), summed_cells(0)
+    {
+        reals.clear(0);
+    }
+
+    void destroy()
+    {
+        reals.destroy();
+        cells.destroy();
+        sums.clear();
+    }
+    void clear(const variant val)
+    {
+        if (is_real(val))
+        {
+            if (!packed)
+            {
+                reals = grid<double>(cells.width(), cells.height());
+                cells.destroy();
+                packed = true;
+            }
+            reals.clear(val.rval.d);
+            changed();
+        }
+        else
+        {
+            unpack();
+            cells.clear(val);
+        }
+    }
+    void resize(unsigned w, unsigned h)
+    {
+        // New cells are uninitialized variants, which are only reals if the game treats them as 0.
+        if (packed && variant::default_type != enigma::vt_real && (w > reals.width() || h > reals.height()))
+            unpack();
+        if (packed)
+        {
+            reals.resize(w, h, 0);
+            changed();
+        }
+        else
+            cells.resize(w, h);
+    }
+    void copy(const variant_grid& copy_id)
+    {
+        if (&copy_id == this)
+            return;
+        if (copy_id.packed)
+        {
+            cells.destroy();
+            reals.copy(copy_id.reals);
+            packed = true;
+            changed();
+        }
+        else
+        {
+            reals.destroy();
+            cells.copy(copy_id.cells);
+            packed = false;
+        }
+    }
+    unsigned int width() const
+    {
+        return packed ? reals.width() : cells.width();
+    }
+    unsigned int height() const
+    {
+        return packed ? reals.height() : cells.height();
+    }
+    void insert(const unsigned int x, const unsigned int y, const variant val)
+    {
+        if (packed && is_real(val))
+        {
+            reals.insert(x, y, val.rval.d);
+            changed();
+            return;
+        }
+        unpack();
+        cells.insert(x, y, val);
+    }
+    void add(const unsigned int x, const unsigned int y, const variant val)
+    {
+        if (packed && is_real(val))
+        {
+            reals.add(x, y, val.rval.d);
+            changed();
+            return;
+        }
+        unpack();
+        cells.add(x, y, val);
+    }
+    void multiply(const unsigned int x, const unsigned int y, const double val)
+    {
+        if (packed)
+        {
+            reals.multiply(x, y, val);
+            changed();
+        }
+        else
+            cells.multiply(x, y, val);
+    }
+    void insert_region(const unsigned int x1, const unsigned int y1, unsigned int x2, const unsigned int y2, const variant val)
+    {
+        if (packed && is_real(val))
+        {
+            reals.insert_region(x1, y1, x2, y2, val.rval.d);
+            changed();
+            return;
+        }
+        unpack();
+        cells.insert_region(x1, y1, x2, y2, val);
+    }
+    void add_region(const unsigned int x1, const unsigned int y1, unsigned int x2, const unsigned int y2, const variant val)
+    {
+        if (packed && is_real(val))
+        {
+            reals.add_region(x1, y1, x2, y2, val.rval.d);
+            changed();
+            return;
+        }
+        unpack();
+        cells.add_region(x1, y1, x2, y2, val);
+    }
+    void multiply_region(const unsigned int x1, const unsigned int y1, unsigned int x2, const unsigned int y2, const double val)
+    {
+        if (packed)
+        {
+            reals.multiply_region(x1, y1, x2, y2, val);
+            changed();
+        }
+        else
+            cells.multiply_region(x1, y1, x2, y2, val);
+    }
+    void insert_disk(const double x, const double y, const double r, const variant val)
+    {
+        if (packed && is_real(val))
+        {
+            reals.insert_disk(x, y, r, val.rval.d);
+            changed();
+            return;
+        }
+        unpack();
+        cells.insert_disk(x, y, r, val);
+    }
+    void add_disk(const double x, const double y, const double r, const variant val)
+    {
+        if (packed && is_real(val))
+        {
+            reals.add_disk(x, y, r, val.rval.d);
+            changed();
+            return;
+        }
+        unpack();
+        cells.add_disk(x, y, r, val);
+    }
+    void multiply_disk(const double x, const double y, const double r, const double val)
+    {
+        if (packed)
+        {
+            reals.multiply_disk(x, y, r, val);
+            changed();
+        }
+        else
+            cells.multiply_disk(x, y, r, val);
+    }
+    void insert_grid_region(const variant_grid& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
+    {
+        if (!source_id.packed)
+            unpack();
+        if (!packed)
+        {
+            if (source_id.packed)
+                cells.insert_grid_region(source_id.reals, sx1, sy1, sx2, sy2, x, y);
+            else
+                cells.insert_grid_region(source_id.cells, sx1, sy1, sx2, sy2, x, y);
+            return;
+        }
+        reals.insert_grid_region(source_id.reals, sx1, sy1, sx2, sy2, x, y);
+        changed();
+    }
+    void add_grid_region(const variant_grid& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
+    {
+        if (!source_id.packed)
+            unpack();
+        if (!packed)
+        {
+            if (source_id.packed)
+                cells.add_grid_region(source_id.reals, sx1, sy1, sx2, sy2, x, y);
+            else
+                cells.add_grid_region(source_id.cells, sx1, sy1, sx2, sy2, x, y);
+            return;
+        }
+        reals.add_grid_region(source_id.reals, sx1, sy1, sx2, sy2, x, y);
+        changed();
+    }
+    void multiply_grid_region(const variant_grid& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
+    {
+        if (packed)
+        {
+            // Multiplying by a cell only ever reads its real part, so this never needs variant cells.
+            if (source_id.packed)
+                reals.multiply_grid_region(source_id.reals, sx1, sy1, sx2, sy2, x, y);
+            else
+                reals.multiply_grid_region(source_id.cells, sx1, sy1, sx2, sy2, x, y);
+            changed();
+        }
+        else if (source_id.packed)
+            cells.multiply_grid_region(source_id.reals, sx1, sy1, sx2, sy2, x, y);
+        else
+            cells.multiply_grid_region(source_id.cells, sx1, sy1, sx2, sy2, x, y);
+    }
+
+    variant find(unsigned int x, unsigned int y) const
+    {
+        return packed ? variant(reals.find(x, y)) : cells.find(x, y);
+    }
+    variant find_region_sum(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2)
+    {
+        if (!packed)
+            return cells.find_region_sum(x1, y1, x2, y2);
+        int px1, py1, px2, py2;
+        if (!reals.clip_region(x1, y1, x2, y2, px1, py1, px2, py2))
+            return variant();
+        return region_sum(x1, y1, x2, y2, px1, py1, px2, py2);
+    }
+    variant find_region_max(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2) const
+    {
+        if (!packed)
+            return cells.find_region_max(x1, y1, x2, y2);
+        int px1, py1, px2, py2;
+        return reals.clip_region(x1, y1, x2, y2, px1, py1, px2, py2) ? variant(reals.find_region_max(x1, y1, x2, y2)) : variant();
+    }
+    variant find_region_min(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2) const
+    {
+        if (!packed)
+            return cells.find_region_min(x1, y1, x2, y2);
+        int px1, py1, px2, py2;
+        return reals.clip_region(x1, y1, x2, y2, px1, py1, px2, py2) ? variant(reals.find_region_min(x1, y1, x2, y2)) : variant();
+    }
+    variant find_region_mean(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2)
+    {
+        if (!packed)
+            return cells.find_region_mean(x1, y1, x2, y2);
+        int px1, py1, px2, py2;
+        if (!reals.clip_region(x1, y1, x2, y2, px1, py1, px2, py2))
+            return variant();
+        const double region_size = (py2 - py1)*(px2 - px1);
+        return region_sum(x1, y1, x2, y2, px1, py1, px2, py2)/region_size;
+    }
+    variant find_disk_sum(const double x, const double y, const double r) const
+    {
+        if (!packed)
+            return cells.find_disk_sum(x, y, r);
+        int px1, py1, px2, py2;
+        return reals.clip_disk(x, y, r, px1, py1, px2, py2) ? variant(reals.find_disk_sum(x, y, r)) : variant();
+    }
+    variant find_disk_max(const double x, const double y, const double r) const
+    {
+        if (!packed)
+            return cells.find_disk_max(x, y, r);
+        int px1, py1, px2, py2;
+        return reals.clip_disk(x, y, r, px1, py1, px2, py2) ? variant(reals.find_disk_max(x, y, r)) : variant();
+    }
+    variant find_disk_min(const double x, const double y, const double r) const
+    {
+        if (!packed)
+            return cells.find_disk_min(x, y, r);
+        int px1, py1, px2, py2;
+        return reals.clip_disk(x, y, r, px1, py1, px2, py2) ? variant(reals.find_disk_min(x, y, r)) : variant();
+    }
+    variant find_disk_mean(const double x, const double y, const double r) const
+    {
+        if (!packed)
+            return cells.find_disk_mean(x, y, r);
+        int px1, py1, px2, py2;
+        return reals.clip_disk(x, y, r, px1, py1, px2, py2) ? variant(reals.find_disk_mean(x, y, r)) : variant();
+    }
+
+    // A packed grid holds only reals, which never equal a value of another type.
+    bool value_region_exists(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, const variant val) const
+    {
+        if (!packed)
+            return cells.value_region_exists(x1, y1, x2, y2, val);
+        return is_real(val) && reals.value_region_exists(x1, y1, x2, y2, val.rval.d);
+    }
+    int value_region_x(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, const variant val) const
+    {
+        if (!packed)
+            return cells.value_region_x(x1, y1, x2, y2, val);
+        return is_real(val) ? reals.value_region_x(x1, y1, x2, y2, val.rval.d) : 0;
+    }
+    int value_region_y(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, const variant val) const
+    {
+        if (!packed)
+            return cells.value_region_y(x1, y1, x2, y2, val);
+        return is_real(val) ? reals.value_region_y(x1, y1, x2, y2, val.rval.d) : 0;
+    }
+    bool value_disk_exists(const double x, const double y, const double r, const variant val) const
+    {
+        if (!packed)
+            return cells.value_disk_exists(x, y, r, val);
+        return is_real(val) && reals.value_disk_exists(x, y, r, val.rval.d);
+    }
+    int value_disk_x(const double x, const double y, const double r, const variant val) const
+    {
+        if (!packed)
+            return cells.value_disk_x(x, y, r, val);
+        return is_real(val) ? reals.value_disk_x(x, y, r, val.rval.d) : 0;
+    }
+    int value_disk_y(const double x, const double y, const double r, const variant val) const
+    {
+        if (!packed)
+            return cells.value_disk_y(x, y, r, val);
+        return is_real(val) ? reals.value_disk_y(x, y, r, val.rval.d) : 0;
+    }
+    void shuffle()
+    {
+        if (packed)
+        {
+            reals.shuffle();
+            changed();
+        }
+        else
+            cells.shuffle();
+    }
 };
 
 /* ds_grids */
 
-static map<unsigned int, grid<variant> > ds_grids;
-static unsigned int ds_grids_maxid = 0;
+template<> void ds_reset(variant_grid &val)
+{
+    val.destroy();
+    val = variant_grid();
+}
+
+static ds_table<variant_grid> ds_grids;
 
 namespace enigma_user
 {
@@ -483,16 +1002,14 @@ namespace enigma_user
 unsigned int ds_grid_create(const unsigned int w, const unsigned int h)
 {
   //Creates a new grid. The function returns an integer as an id that must be used in all other functions to access the particular grid.
-  pair<map<unsigned int, grid<variant> >::iterator, bool> ins = ds_grids.insert(pair<unsigned int, grid<variant> >(ds_grids_maxid++, grid<variant>(w, h)));
-  ins.first->second.clear(0);
-  return ds_grids_maxid-1;
+  return ds_grids.add(variant_grid(w, h));
 }
 
 void ds_grid_destroy(const unsigned int id)
 {
   //Destroys the grid
   ds_grids[id].destroy();
-  ds_grids.erase(ds_grids.find(id));
+  ds_grids.erase(id);
 }
 
 void ds_grid_clear(const unsigned int id, const variant val)
@@ -695,15 +1212,21 @@ void ds_grid_shuffle(const unsigned int id)
 bool ds_grid_exists(const unsigned int id)
 {
   //returns whether the grid exists
-  return (ds_grids.find(id) != ds_grids.end());
+  return ds_grids.exists(id);
+}
+
+unsigned int ds_grid_count()
+{
+  //returns the number of grids that currently exist
+  return ds_grids.count();
 }
 
 unsigned int ds_grid_duplicate(const unsigned int source)
 {
   //creates and returns a new grid containing a copy of the source grid
-  ds_grids.insert(pair<unsigned int, grid<variant> >(ds_grids_maxid++, grid<variant>(0, 0)));
-  ds_grids[ds_grids_maxid-1].copy(ds_grids[source]);
-  return ds_grids_maxid-1;
+  const unsigned int id = ds_grids.add();
+  ds_grids[id].copy(ds_grids[source]);
+  return id;
 }
 
 std::string ds_grid_write(const unsigned int id)
@@ -713,7 +1236,7 @@ std::string ds_grid_write(const unsigned int id)
   ss.width(4);
   ss.fill('0');
 
-  grid<variant> dsGrid = ds_grids[id];
+  variant_grid &dsGrid = ds_grids[id];
 
   // Write size
   ss << std::hex << dsGrid.width();
@@ -833,8 +1356,225 @@ void ds_grid_read(const unsigned int id, std::string value)
 
 /* ds_maps */
 
-static map<unsigned int, multimap<variant, variant> > ds_maps;
-static unsigned int ds_maps_maxid = 0;
+// A multimap from variant to variant, hashed for constant time lookup.
+// Entries are kept in insertion order, and an index sorted by key is built only when one of the
+// ordered operations (first, last, next, previous, range delete, write) needs it. Among equal
+// keys, lookups find the earliest added, matching the multimap this replaced.
+class variant_map
+{
+    struct entry
+    {
+        variant key, value;
+        size_t hash;
+        bool live;
+    };
+
+    enum { empty_slot = ~0u, deleted_slot = ~0u - 1 };
+
+    vector<entry> entries;      // Append-only; erased entries are dead until the next rehash
+    vector<unsigned int> slots; // Open addressing table of indices into entries
+    vector<unsigned int> order; // Live entry indices sorted by key, valid when ordered is set
+    size_t live_count;
+    bool ordered;
+
+    static size_t hash_key(const variant &key)
+    {
+        if (key.type == enigma::vt_real)
+        {
+            // 0.0 and -0.0 compare equal, so they must hash alike.
+            const double d = key.rval.d == 0 ? 0.0 : key.rval.d;
+            unsigned long long bits;
+            memcpy(&bits, &d, sizeof bits);
+            bits ^= bits >> 33;
+            bits *= 0xff51afd7ed558ccdULL;
+            bits ^= bits >> 33;
+            return size_t(bits);
+        }
+        return std::hash<string>()(key.sval) ^ size_t(key.type + 1);
+    }
+    static bool same_key(const variant &a, const variant &b)
+    {
+        return a.type == b.type && (a.type == enigma::vt_real ? a.rval.d == b.rval.d : a.sval == b.sval);
+    }
+
+    // Returns the slot holding the earliest entry with this key, or empty_slot.
+    size_t find_slot(const variant &key, size_t hash) const
+    {
+        if (slots.empty())
+            return empty_slot;
+        const size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask)
+        {
+            const unsigned int e = slots[i];
+            if (e == empty_slot)
+                return empty_slot;
+            if (e != deleted_slot && entries[e].hash == hash && same_key(entries[e].key, key))
+                return i;
+        }
+    }
+
+    void place(unsigned int e)
+    {
+        // A deleted slot may only be reused before any entry with the same key is passed, so
+        // that equal keys stay in insertion order along the probe sequence.
+        const size_t mask = slots.size() - 1;
+        size_t reuse = empty_slot;
+        for (size_t i = entries[e].hash & mask; ; i = (i + 1) & mask)
+        {
+            const unsigned int o = slots[i];
+            if (o == empty_slot)
+            {
+                slots[reuse != empty_slot ? reuse : i] = e;
+                return;
+            }
+            if (o == deleted_slot)
+            {
+                if (reuse == empty_slot)
+                    reuse = i;
+            }
+            else if (entries[o].hash == entries[e].hash && same_key(entries[o].key, entries[e].key))
+                reuse = empty_slot;
+        }
+    }
+
+    // Drops dead entries and rebuilds the table with room for at least the given number.
+    void rehash(size_t capacity)
+    {
+        size_t n = 16;
+        while (n < capacity * 2)
+            n <<= 1;
+
+        size_t j = 0;
+        for (size_t i = 0; i < entries.size(); i++)
+            if (entries[i].live)
+            {
+                if (i != j)
+                    swap(entries[j], entries[i]);
+                j++;
+            }
+        entries.resize(j);
+
+        slots.assign(n, empty_slot);
+        for (size_t i = 0; i < entries.size(); i++)
+            place(i);
+        ordered = false;
+    }
+
+    struct key_less
+    {
+        const vector<entry> &entries;
+        key_less(const vector<entry> &e): entries(e) {}
+        bool operator()(unsigned int a, unsigned int b) const { return entries[a].key < entries[b].key; }
+        bool operator()(unsigned int a, const variant &key) const { return entries[a].key < key; }
+        bool operator()(const variant &key, unsigned int b) const { return key < entries[b].key; }
+    };
+
+    const vector<unsigned int> &sorted()
+    {
+        if (!ordered)
+        {
+            order.clear();
+            for (size_t i = 0; i < entries.size(); i++)
+                if (entries[i].live)
+                    order.push_back(i);
+            stable_sort(order.begin(), order.end(), key_less(entries));
+            ordered = true;
+        }
+        return order;
+    }
+
+    void erase_slot(size_t slot)
+    {
+        entries[slots[slot]].live = false;
+        entries[slots[slot]].key = variant();
+        entries[slots[slot]].value = variant();
+        slots[slot] = deleted_slot;
+        live_count--;
+        ordered = false;
+    }
+
+    public:
+    variant_map(): live_count(0), ordered(false) {}
+
+    size_t size() const { return live_count; }
+    bool empty() const { return !live_count; }
+
+    void clear()
+    {
+        entries.clear();
+        slots.clear();
+        order.clear();
+        live_count = 0;
+        ordered = false;
+    }
+
+    void insert(const variant &key, const variant &value)
+    {
+        if ((entries.size() + 1) * 4 > slots.size() * 3)
+            rehash(live_count + 1);
+        const entry ent = { key, value, hash_key(key), true };
+        entries.push_back(ent);
+        place(entries.size() - 1);
+        live_count++;
+        ordered = false;
+    }
+
+    const variant *find(const variant &key) const
+    {
+        const size_t slot = find_slot(key, hash_key(key));
+        return slot == empty_slot ? NULL : &entries[slots[slot]].value;
+    }
+
+    // Removes the earliest entry with this key; returns whether there was one.
+    bool erase(const variant &key)
+    {
+        const size_t slot = find_slot(key, hash_key(key));
+        if (slot == empty_slot)
+            return false;
+        erase_slot(slot);
+        return true;
+    }
+
+    // Removes the entries from the first with key first up to, not including, the first with key last.
+    void erase_range(const variant &first, const variant &last)
+    {
+        if (!find(first) || !find(last))
+            return;
+        const vector<unsigned int> &ord = sorted();
+        const size_t from = lower_bound(ord.begin(), ord.end(), first, key_less(entries)) - ord.begin(),
+                     to = lower_bound(ord.begin(), ord.end(), last, key_less(entries)) - ord.begin();
+        vector<variant> doomed;
+        for (size_t i = from; i < to; i++)
+            doomed.push_back(entries[ord[i]].key);
+        for (size_t i = 0; i < doomed.size(); i++)
+            erase(doomed[i]);
+    }
+
+    const variant *first_key() { return empty() ? NULL : &entries[sorted().front()].key; }
+    const variant *last_key() { return empty() ? NULL : &entries[sorted().back()].key; }
+
+    // The least key greater than the given one, or NULL.
+    const variant *next_key(const variant &key)
+    {
+        const vector<unsigned int> &ord = sorted();
+        vector<unsigned int>::const_iterator it = upper_bound(ord.begin(), ord.end(), key, key_less(entries));
+        return it == ord.end() ? NULL : &entries[*it].key;
+    }
+
+    // The greatest key less than the given one, or NULL.
+    const variant *previous_key(const variant &key)
+    {
+        const vector<unsigned int> &ord = sorted();
+        vector<unsigned int>::const_iterator it = lower_bound(ord.begin(), ord.end(), key, key_less(entries));
+        return it == ord.begin() ? NULL : &entries[*(it - 1)].key;
+    }
+
+    // The i-th entry in key order.
+    const variant &key_at(size_t i) { return entries[sorted()[i]].key; }
+    const variant &value_at(size_t i) { return entries[sorted()[i]].value; }
+};
+
+static ds_table<variant_map> ds_maps;
 
 namespace enigma_user
 {
@@ -842,14 +1582,13 @@ namespace enigma_user
 unsigned int ds_map_create()
 {
   //Creates a new map. The function returns an integer as an id that must be used in all other functions to access the particular map.
-  ds_maps.insert(pair<unsigned int, multimap<variant, variant> >(ds_maps_maxid++, multimap<variant, variant>()));
-  return ds_maps_maxid-1;
+  return ds_maps.add();
 }
 
 void ds_map_destroy(const unsigned int id)
 {
   //Destroys the map
-  ds_maps.erase(ds_maps.find(id));
+  ds_maps.erase(id);
 }
 
 void ds_map_clear(const unsigned int id)
@@ -879,7 +1618,7 @@ bool ds_map_empty(const unsigned int id)
 void ds_map_add(const unsigned int id, const variant key, const variant val)
 {
   //Adds the value and corresponding key to the map.
-  ds_maps[id].insert(pair<variant, variant>(key, val));
+  ds_maps[id].insert(key, val);
 }
 
 void ds_map_replace(const unsigned int id, const variant key, const variant val)
@@ -893,11 +1632,10 @@ void ds_map_replace(const unsigned int id, const variant key, const variant val)
   //extension which had to create a special function to replace a value adding it if it does
   //not exist in the global async_load map.
   //Replaces the value corresponding with the key with a new value
-  multimap<variant, variant>::iterator it = ds_maps[id].find(key);
-  if (it != ds_maps[id].end())
+  variant_map &dsMap = ds_maps[id];
+  if (dsMap.erase(key))
   {
-    ds_maps[id].erase(it);
-    ds_maps[id].insert(pair<variant, variant>(key, val));
+    dsMap.insert(key, val);
   }
 }
 
@@ -905,103 +1643,80 @@ void ds_map_replace(const unsigned int id, const variant key, const variant val)
 void ds_map_replaceanyway(const unsigned int id, const variant key, const variant val)
 {
   //Replaces the value corresponding with the key with a new value, adding it if it was not found in the map.
-  multimap<variant, variant>::iterator it = ds_maps[id].find(key);
-  if (it != ds_maps[id].end())
-  {
-    ds_maps[id].erase(it);
-  }
-  ds_maps[id].insert(pair<variant, variant>(key, val));
+  variant_map &dsMap = ds_maps[id];
+  dsMap.erase(key);
+  dsMap.insert(key, val);
 }
 
 void ds_map_delete(const unsigned int id, const variant key)
 {
   //Deletes the key and the corresponding value from the map
-  multimap<variant, variant>::iterator it = ds_maps[id].find(key);
-  if (it != ds_maps[id].end())
-  {
-    ds_maps[id].erase(it);
-  }
+  ds_maps[id].erase(key);
 }
 
 void ds_map_delete(const unsigned int id, const variant first, const variant last)
 {
   //Deletes the keys and corresponding values in the range between first and last
-  multimap<variant, variant>::iterator itf = ds_maps[id].find(first), itl = ds_maps[id].find(last);
-  if (itf != ds_maps[id].end() && itl != ds_maps[id].end())
-  {
-    ds_maps[id].erase(itf, itl);
-  }
+  ds_maps[id].erase_range(first, last);
 }
 
 bool ds_map_exists(const unsigned int id, const variant key)
 {
   //returns whether the key exists in the map
-  return (ds_maps[id].find(key) != ds_maps[id].end());
+  return ds_maps[id].find(key) != NULL;
 }
 
 variant ds_map_find_value(const unsigned int id, const variant key)
 {
   //Returns the value corresponding to the key in the map
-  multimap<variant, variant>::iterator it = ds_maps[id].find(key);
-  return ((it == ds_maps[id].end()) ? variant() : (*it).second);
+  const variant *val = ds_maps[id].find(key);
+  return val ? *val : variant();
 }
 
 variant ds_map_find_previous(const unsigned int id, const variant key)
 {
   //Returns the largest key in the map smaller than the indicated key
-  multimap<variant, variant>::reverse_iterator rit;
-  variant key_check;
-  for (rit = ds_maps[id].rbegin(); rit != ds_maps[id].rend(); rit++)
-  {
-    if ((key_check = (*rit).first) < key)
-    {
-      return key_check;
-    }
-  }
-  return 0;
+  const variant *prev = ds_maps[id].previous_key(key);
+  return prev ? *prev : variant(0);
 }
 
 variant ds_map_find_next(const unsigned int id, const variant key)
 {
   //Returns the smallest key in the map larger than the indicated key
-  multimap<variant, variant>::iterator it;
-  variant key_check;
-  for (it = ds_maps[id].begin(); it != ds_maps[id].end(); it++)
-  {
-    if ((key_check = (*it).first) > key)
-    {
-      return key_check;
-    }
-  }
-  return 0;
+  const variant *next = ds_maps[id].next_key(key);
+  return next ? *next : variant(0);
 }
 
 variant ds_map_find_first(const unsigned int id)
 {
   //Returns the smallest key in the map
-  multimap<variant, variant>::iterator it = ds_maps[id].begin();
-  return (it == ds_maps[id].end()) ? variant() : (*it).first;
+  const variant *first = ds_maps[id].first_key();
+  return first ? *first : variant();
 }
 
 variant ds_map_find_last(const unsigned int id)
 {
   //Returns the largest key in the map
-  multimap<variant, variant>::reverse_iterator rit = ds_maps[id].rbegin();
-  return ((rit == ds_maps[id].rend()) ? variant() : (*rit).first);
+  const variant *last = ds_maps[id].last_key();
+  return last ? *last : variant();
 }
 
 bool ds_map_exists(const unsigned int id)
 {
   //returns whether the map exists
-  return (ds_maps.find(id) != ds_maps.end());
+  return ds_maps.exists(id);
+}
+
+unsigned int ds_map_count()
+{
+  //returns the number of maps that currently exist
+  return ds_maps.count();
 }
 
 unsigned int ds_map_duplicate(const unsigned int source)
 {
   //creates and returns a new map containing a copy of the source map
-  ds_maps.insert(pair<unsigned int, multimap<variant, variant> >(++ds_maps_maxid, multimap<variant, variant>()));
-  ds_maps[ds_maps_maxid-1] = ds_maps[source];
-  return ds_maps_maxid-1;
+  return ds_maps.add(ds_maps[source]);
 }
 
 std::string ds_map_write(const unsigned int id)
@@ -1011,54 +1726,53 @@ std::string ds_map_write(const unsigned int id)
   ss.width(4);
   ss.fill('0');
 
-  std::multimap<variant, variant> dsMap = ds_maps[id];
+  variant_map &dsMap = ds_maps[id];
 
   // Write size
   ss << std::hex << dsMap.size();
 
-  std::multimap<variant, variant>::iterator it = dsMap.begin();
-  while (it != dsMap.end())
+  for (size_t n = 0; n < dsMap.size(); ++n)
   {
+    const variant &key = dsMap.key_at(n), &val = dsMap.value_at(n);
+
     // Write type
     ss.width(2);
-    ss << (unsigned int)(((*it).first.type == enigma::vt_real) ? 0x00 : 0x01);
+    ss << (unsigned int)((key.type == enigma::vt_real) ? 0x00 : 0x01);
 
     // Write data
-    if ((*it).first.type == enigma::vt_real)
+    if (key.type == enigma::vt_real)
     {
       ss.width(16);
-            char* b = (char*)&(*it).first.rval.d;
+            char* b = (char*)&key.rval.d;
             for (unsigned i = 0; i < sizeof(double); ++i)
             ss << b[i];
     }
     else
     {
-      ss.width(4); ss << (*it).first.sval.length();
+      ss.width(4); ss << key.sval.length();
       ss.width(1);
-      for (size_t j = 0; j < (*it).first.sval.length(); ++j)
-        ss << (*it).first.sval[j];
+      for (size_t j = 0; j < key.sval.length(); ++j)
+        ss << key.sval[j];
     }
 
     // Write type
     ss.width(2);
-    ss << (unsigned int)(((*it).second.type == enigma::vt_real) ? 0x00 : 0x01);
+    ss << (unsigned int)((val.type == enigma::vt_real) ? 0x00 : 0x01);
 
     // Write data
-    if ((*it).second.type == enigma::vt_real)
+    if (val.type == enigma::vt_real)
     {
       ss.width(16);
-      char* b = (char*)&(*it).second.rval.d;
+      char* b = (char*)&val.rval.d;
       for (unsigned i = 0; i < sizeof(double); ++i)
         ss << b[i];    }
     else
     {
-      ss.width(4); ss << (*it).second.sval.length();
+      ss.width(4); ss << val.sval.length();
       ss.width(1);
-      for (size_t j = 0; j < (*it).second.sval.length(); ++j)
-        ss << (*it).second.sval[j];
+      for (size_t j = 0; j < val.sval.length(); ++j)
+        ss << val.sval[j];
     }
-
-    ++it;
   }
 
   return ss.str();
@@ -1149,7 +1863,7 @@ void ds_map_read(const unsigned int id, std::string value)
     }
 
     // Push value
-    ds_maps[id].insert(std::pair<variant, variant>(variKey, variValue));
+    ds_maps[id].insert(variKey, variValue);
   }
 }
 
@@ -1157,8 +1871,7 @@ void ds_map_read(const unsigned int id, std::string value)
 
 /* ds_lists */
 
-static map<unsigned int, vector<variant> > ds_lists;
-static unsigned int ds_lists_maxid = 0;
+static ds_table<vector<variant> > ds_lists;
 
 namespace enigma_user
 {
@@ -1166,14 +1879,13 @@ namespace enigma_user
 unsigned int ds_list_create()
 {
   //Creates a new list. The function returns an integer as an id that must be used in all other functions to access the particular list.
-  ds_lists.insert(pair<unsigned int, vector<variant> >(ds_lists_maxid++, vector<variant>()));
-  return ds_lists_maxid-1;
+  return ds_lists.add();
 }
 
 void ds_list_destroy(const unsigned int id)
 {
   //Destroys the list
-  ds_lists.erase(ds_lists.find(id));
+  ds_lists.erase(id);
 }
 
 void ds_list_clear(const unsigned int id)
@@ -1286,15 +1998,19 @@ void ds_list_shuffle(const unsigned int id)
 bool ds_list_exists(const unsigned int id)
 {
   //returns whether the list exists
-  return (ds_lists.find(id) != ds_lists.end());
+  return ds_lists.exists(id);
+}
+
+unsigned int ds_list_count()
+{
+  //returns the number of lists that currently exist
+  return ds_lists.count();
 }
 
 unsigned int ds_list_duplicate(const unsigned int source)
 {
   //creates and returns a new list containing a copy of the source list
-  ds_lists.insert(pair<unsigned int, vector<variant> >(++ds_lists_maxid, vector<variant>()));
-  ds_lists[ds_lists_maxid-1] = ds_lists[source];
-  return ds_lists_maxid-1;
+  return ds_lists.add(ds_lists[source]);
 }
 
 std::string ds_list_write(const unsigned int id)
@@ -1395,8 +2111,227 @@ void ds_list_read(const unsigned int id, std::string value)
 
 /* ds_prioritys */
 
-static map<unsigned int, multimap<variant, variant> > ds_prioritys;
-static unsigned int ds_prioritys_maxid = 0;
+// A priority queue that can also look values up.
+// Entries sit in two binary heaps over the same storage, one ordered for extracting the minimum
+// priority and one for the maximum, and each entry records its position in both, so any entry
+// can be removed or re-prioritized in O(log n). A multimap from value to entry finds entries by
+// value and gives the value order used when writing. Among equal priorities, the least value
+// comes out first from either end, and equal values in the order they were queued, as they did
+// when the queue was scanned in value order.
+class variant_priority
+{
+    struct entry
+    {
+        variant value, prio;
+        unsigned int minpos, maxpos;
+        size_t order; // When the entry was last queued, to break ties between equal values
+    };
+
+    typedef multimap<variant, unsigned int> value_index;
+
+    vector<entry> entries;
+    vector<unsigned int> minheap, maxheap;
+    value_index index;
+    size_t queued;
+
+    bool min_before(unsigned int a, unsigned int b) const
+    {
+        const entry &ea = entries[a], &eb = entries[b];
+        if (ea.prio < eb.prio) return true;
+        if (eb.prio < ea.prio) return false;
+        return ea.value < eb.value || (!(eb.value < ea.value) && ea.order < eb.order);
+    }
+    bool max_before(unsigned int a, unsigned int b) const
+    {
+        const entry &ea = entries[a], &eb = entries[b];
+        if (eb.prio < ea.prio) return true;
+        if (ea.prio < eb.prio) return false;
+        return ea.value < eb.value || (!(eb.value < ea.value) && ea.order < eb.order);
+    }
+
+    void min_set(unsigned int pos, unsigned int e) { minheap[pos] = e; entries[e].minpos = pos; }
+    void max_set(unsigned int pos, unsigned int e) { maxheap[pos] = e; entries[e].maxpos = pos; }
+
+    void min_up(unsigned int pos)
+    {
+        const unsigned int e = minheap[pos];
+        while (pos > 0 && min_before(e, minheap[(pos - 1) / 2]))
+        {
+            min_set(pos, minheap[(pos - 1) / 2]);
+            pos = (pos - 1) / 2;
+        }
+        min_set(pos, e);
+    }
+    void min_down(unsigned int pos)
+    {
+        const unsigned int e = minheap[pos], n = minheap.size();
+        for (unsigned int child; (child = 2 * pos + 1) < n; pos = child)
+        {
+            if (child + 1 < n && min_before(minheap[child + 1], minheap[child]))
+                child++;
+            if (!min_before(minheap[child], e))
+                break;
+            min_set(pos, minheap[child]);
+        }
+        min_set(pos, e);
+    }
+    void max_up(unsigned int pos)
+    {
+        const unsigned int e = maxheap[pos];
+        while (pos > 0 && max_before(e, maxheap[(pos - 1) / 2]))
+        {
+            max_set(pos, maxheap[(pos - 1) / 2]);
+            pos = (pos - 1) / 2;
+        }
+        max_set(pos, e);
+    }
+    void max_down(unsigned int pos)
+    {
+        const unsigned int e = maxheap[pos], n = maxheap.size();
+        for (unsigned int child; (child = 2 * pos + 1) < n; pos = child)
+        {
+            if (child + 1 < n && max_before(maxheap[child + 1], maxheap[child]))
+                child++;
+            if (!max_before(maxheap[child], e))
+                break;
+            max_set(pos, maxheap[child]);
+        }
+        max_set(pos, e);
+    }
+
+    // Restores both heaps after the priority of entry e changed.
+    void reposition(unsigned int e)
+    {
+        min_up(entries[e].minpos);
+        min_down(entries[e].minpos);
+        max_up(entries[e].maxpos);
+        max_down(entries[e].maxpos);
+    }
+
+    void remove(value_index::iterator it)
+    {
+        const unsigned int e = it->second;
+        index.erase(it);
+
+        // Take the entry out of both heaps, filling its place with the last heap element.
+        const unsigned int mp = entries[e].minpos, xp = entries[e].maxpos;
+        const unsigned int mlast = minheap.back(), xlast = maxheap.back();
+        minheap.pop_back();
+        maxheap.pop_back();
+        if (mlast != e)
+        {
+            min_set(mp, mlast);
+            min_up(mp);
+            min_down(entries[mlast].minpos);
+        }
+        if (xlast != e)
+        {
+            max_set(xp, xlast);
+            max_up(xp);
+            max_down(entries[xlast].maxpos);
+        }
+
+        // Move the last entry into the vacated storage slot.
+        const unsigned int last = entries.size() - 1;
+        if (e != last)
+        {
+            pair<value_index::iterator, value_index::iterator> range = index.equal_range(entries[last].value);
+            for (value_index::iterator r = range.first; r != range.second; ++r)
+                if (r->second == last)
+                {
+                    r->second = e;
+                    break;
+                }
+            swap(entries[e], entries[last]);
+            minheap[entries[e].minpos] = e;
+            maxheap[entries[e].maxpos] = e;
+        }
+        entries.pop_back();
+    }
+
+    public:
+    typedef value_index::const_iterator const_iterator;
+
+    variant_priority(): queued(0) {}
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    void clear()
+    {
+        entries.clear();
+        minheap.clear();
+        maxheap.clear();
+        index.clear();
+    }
+
+    void insert(const variant &val, const variant &prio)
+    {
+        const unsigned int e = entries.size();
+        const entry ent = { val, prio, e, e, queued++ };
+        entries.push_back(ent);
+        minheap.push_back(e);
+        maxheap.push_back(e);
+        index.insert(pair<variant, unsigned int>(val, e));
+        min_up(e);
+        max_up(e);
+    }
+
+    // Returns the priority of the given value, or NULL if it is not queued.
+    const variant *priority(const variant &val) const
+    {
+        const_iterator it = index.find(val);
+        return it == index.end() ? NULL : &entries[it->second].prio;
+    }
+
+    void change_priority(const variant &val, const variant &prio)
+    {
+        value_index::iterator it = index.find(val);
+        if (it != index.end())
+        {
+            // Requeue the entry behind any others with the same value, as removing and re-adding it would.
+            const unsigned int e = it->second;
+            index.erase(it);
+            index.insert(pair<variant, unsigned int>(entries[e].value, e));
+            entries[e].prio = prio;
+            entries[e].order = queued++;
+            reposition(e);
+        }
+    }
+
+    void erase(const variant &val)
+    {
+        value_index::iterator it = index.find(val);
+        if (it != index.end())
+            remove(it);
+    }
+
+    const variant *find_min() const { return empty() ? NULL : &entries[minheap[0]].value; }
+    const variant *find_max() const { return empty() ? NULL : &entries[maxheap[0]].value; }
+
+    // Removes the value with the least (greatest) priority and returns it; the queue must not be empty.
+    variant delete_min() { const variant val = entries[minheap[0]].value; erase_entry(minheap[0]); return val; }
+    variant delete_max() { const variant val = entries[maxheap[0]].value; erase_entry(maxheap[0]); return val; }
+
+    // Walks the queue in value order.
+    const_iterator begin() const { return index.begin(); }
+    const_iterator end() const { return index.end(); }
+    const variant &priority(const_iterator it) const { return entries[it->second].prio; }
+
+    private:
+    void erase_entry(unsigned int e)
+    {
+        pair<value_index::iterator, value_index::iterator> range = index.equal_range(entries[e].value);
+        for (value_index::iterator r = range.first; r != range.second; ++r)
+            if (r->second == e)
+            {
+                remove(r);
+                return;
+            }
+    }
+};
+
+static ds_table<variant_priority> ds_prioritys;
 
 namespace enigma_user
 {
@@ -1404,14 +2339,13 @@ namespace enigma_user
 unsigned int ds_priority_create()
 {
   //Creates a new priority queue. The function returns an integer as an id that must be used in all other functions to access the particular priority queue.
-  ds_prioritys.insert(pair<unsigned int, multimap<variant, variant> >(ds_prioritys_maxid++, multimap<variant, variant>()));
-  return ds_prioritys_maxid-1;
+  return ds_prioritys.add();
 }
 
 void ds_priority_destroy(const unsigned int id)
 {
   //Destroys the priority queue
-  ds_prioritys.erase(ds_prioritys.find(id));
+  ds_prioritys.erase(id);
 }
 
 void ds_priority_clear(const unsigned int id)
@@ -1441,115 +2375,78 @@ bool ds_priority_empty(const unsigned int id)
 void ds_priority_add(const unsigned int id, const variant val, const variant prio)
 {
   //Adds the value with the given priority to the priority queue
-  ds_prioritys[id].insert(pair<variant, variant>(val, prio));
+  ds_prioritys[id].insert(val, prio);
 }
 
 void ds_priority_change_priority(const unsigned int id, const variant val, const variant prio)
 {
   //Changes the priority of the given value in the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].find(val);
-  if (it != ds_prioritys[id].end())
-  {
-    ds_prioritys[id].erase(it);
-    ds_prioritys[id].insert(pair<variant, variant>(val, prio));
-  }
+  ds_prioritys[id].change_priority(val, prio);
 }
 
 variant ds_priority_find_priority(const unsigned int id, const variant val)
 {
   //Returns the priority of the given value in the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].find(val);
-  return ((it == ds_prioritys[id].end()) ? variant() : (*it).second);
+  const variant *prio = ds_prioritys[id].priority(val);
+  return prio ? *prio : variant();
 }
 
 void ds_priority_delete_value(const unsigned int id, const variant val)
 {
   //Deletes the given value (with its priority) from the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].find(val);
-  if (it != ds_prioritys[id].end())
-  {
-    ds_prioritys[id].erase(it);
-  }
+  ds_prioritys[id].erase(val);
 }
 
 bool ds_priority_value_exists(const unsigned int id, const variant val)
 {
   //returns whether the value exists in the priority queue
-  return (ds_prioritys[id].find(val) != ds_prioritys[id].end());
+  return ds_prioritys[id].priority(val) != NULL;
 }
 
 variant ds_priority_delete_min(const unsigned int id)
 {
-  //Returns the value with the smallest priority but does not delete it from the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].begin(), it_check;
-  if (it == ds_prioritys[id].end()) {return 0;}
-  it_check = it++;
-  while (it != ds_prioritys[id].end())
-  {
-    if ((*it).second < (*it_check).second) {it_check = it;}
-    it++;
-  }
-  const variant val = (*it_check).first;
-  ds_prioritys[id].erase(it_check);
-  return val;
+  //Returns the value with the smallest priority and deletes it from the priority queue
+  variant_priority &dsPriority = ds_prioritys[id];
+  return dsPriority.empty() ? variant(0) : dsPriority.delete_min();
 }
 
 variant ds_priority_find_min(const unsigned int id)
 {
   //Returns the value with the smallest priority but does not delete it from the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].begin(), it_check;
-  if (it == ds_prioritys[id].end()) {return 0;}
-  it_check = it++;
-  while (it != ds_prioritys[id].end())
-  {
-    if ((*it).second < (*it_check).second) {it_check = it;}
-    it++;
-  }
-  return ((*it_check).first);
+  const variant *val = ds_prioritys[id].find_min();
+  return val ? *val : variant(0);
 }
 
 variant ds_priority_delete_max(const unsigned int id)
 {
-  //Returns the value with the smallest priority but does not delete it from the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].begin(), it_check;
-  if (it == ds_prioritys[id].end()) {return 0;}
-  it_check = it++;
-  while (it != ds_prioritys[id].end())
-  {
-    if ((*it).second > (*it_check).second) {it_check = it;}
-    it++;
-  }
-  const variant val = (*it_check).first;
-  ds_prioritys[id].erase(it_check);
-  return val;
+  //Returns the value with the largest priority and deletes it from the priority queue
+  variant_priority &dsPriority = ds_prioritys[id];
+  return dsPriority.empty() ? variant(0) : dsPriority.delete_max();
 }
 
 variant ds_priority_find_max(const unsigned int id)
 {
-  //Returns the value with the smallest priority but does not delete it from the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].begin(), it_check;
-  if (it == ds_prioritys[id].end()) {return 0;}
-  it_check = it++;
-  while (it != ds_prioritys[id].end())
-  {
-    if ((*it).second > (*it_check).second) {it_check = it;}
-    it++;
-  }
-  return ((*it_check).first);
+  //Returns the value with the largest priority but does not delete it from the priority queue
+  const variant *val = ds_prioritys[id].find_max();
+  return val ? *val : variant(0);
 }
 
 bool ds_priority_exists(const unsigned int id)
 {
   //returns whether the priority queue exists
-  return (ds_prioritys.find(id) != ds_prioritys.end());
+  return ds_prioritys.exists(id);
+}
+
+unsigned int ds_priority_count()
+{
+  //returns the number of priority queues that currently exist
+  return ds_prioritys.count();
 }
 
 unsigned int ds_priority_duplicate(const unsigned int source)
 {
   //creates and returns a new priority queue containing a copy of the source priority queue
-  ds_prioritys.insert(pair<unsigned int, multimap<variant, variant> >(++ds_prioritys_maxid, multimap<variant, variant>()));
-  ds_prioritys[ds_prioritys_maxid-1] = ds_prioritys[source];
-  return ds_prioritys_maxid-1;
+  return ds_prioritys.add(ds_prioritys[source]);
 }
 
 std::string ds_priority_write(const unsigned int id)
@@ -1559,19 +2456,18 @@ std::string ds_priority_write(const unsigned int id)
   ss.width(4);
   ss.fill('0');
 
-  std::multimap<variant, variant> dsPriority = ds_prioritys[id];
+  variant_priority &dsPriority = ds_prioritys[id];
 
   // Write size
   ss << std::hex << dsPriority.size();
 
-  std::multimap<variant, variant>::iterator it = dsPriority.begin();
-  while (it != dsPriority.end())
+  for (variant_priority::const_iterator it = dsPriority.begin(); it != dsPriority.end(); ++it)
   {
     // Write type
     ss.width(2);
     ss << (unsigned int)(((*it).first.type == enigma::vt_real) ? 0x00 : 0x01);
     ss.width(16);
-    char* b = (char*)&(*it).second.rval.d;
+    const char* b = (const char*)&dsPriority.priority(it).rval.d;
     for (unsigned i = 0; i < sizeof(double); ++i)
         ss << b[i];
 
@@ -1579,7 +2475,7 @@ std::string ds_priority_write(const unsigned int id)
     if ((*it).first.type == enigma::vt_real)
     {
       ss.width(16);
-      char* b = (char*)&(*it).first.rval.d;
+      const char* b = (const char*)&(*it).first.rval.d;
       for (unsigned i = 0; i < sizeof(double); ++i)
           ss << b[i];
     }
@@ -1590,8 +2486,6 @@ std::string ds_priority_write(const unsigned int id)
       for (size_t j = 0; j < (*it).first.sval.length(); ++j)
         ss << (*it).first.sval[j];
     }
-
-    ++it;
   }
 
   return ss.str();
@@ -1660,7 +2554,7 @@ void ds_priority_read(const unsigned int id, std::string value)
     }
 
     // Push value
-    ds_prioritys[id].insert(std::pair<variant, variant>(vari, prio));
+    ds_prioritys[id].insert(vari, prio);
   }
 }
 
@@ -1668,8 +2562,7 @@ void ds_priority_read(const unsigned int id, std::string value)
 
 /* ds_queues */
 
-static map<unsigned int, deque<variant> > ds_queues;
-static unsigned int ds_queues_maxid = 0;
+static ds_table<deque<variant> > ds_queues;
 
 namespace enigma_user
 {
@@ -1677,14 +2570,13 @@ namespace enigma_user
 unsigned int ds_queue_create()
 {
   //Creates a new queue. The function returns an integer as an id that must be used in all other functions to access the particular queue.
-  ds_queues.insert(pair<unsigned int, deque<variant> >(ds_queues_maxid++, deque<variant>()));
-  return ds_queues_maxid-1;
+  return ds_queues.add();
 }
 
 void ds_queue_destroy(const unsigned int id)
 {
   //Destroys the queue
-  ds_queues.erase(ds_queues.find(id));
+  ds_queues.erase(id);
 }
 
 void ds_queue_clear(const unsigned int id)
@@ -1745,15 +2637,19 @@ variant ds_queue_tail(const unsigned int id)
 bool ds_queue_exists(const unsigned int id)
 {
   //returns whether the queue exists
-  return (ds_queues.find(id) != ds_queues.end());
+  return ds_queues.exists(id);
+}
+
+unsigned int ds_queue_count()
+{
+  //returns the number of queues that currently exist
+  return ds_queues.count();
 }
 
 unsigned int ds_queue_duplicate(const unsigned int source)
 {
   //creates and returns a new queue containing a copy of the source queue
-  ds_queues.insert(pair<unsigned int, deque<variant> >(++ds_queues_maxid, deque<variant>()));
-  ds_queues[ds_queues_maxid-1] = ds_queues[source];
-  return ds_queues_maxid-1;
+  return ds_queues.add(ds_queues[source]);
 }
 
 std::string ds_queue_write(const unsigned int id)
@@ -1853,8 +2749,7 @@ void ds_queue_read(const unsigned int id, std::string value)
 
 /* ds_stacks */
 
-static map<unsigned int, deque<variant> > ds_stacks;
-static unsigned int ds_stacks_maxid = 0;
+static ds_table<deque<variant> > ds_stacks;
 
 namespace enigma_user
 {
@@ -1862,14 +2757,13 @@ namespace enigma_user
 unsigned int ds_stack_create()
 {
   //Creates a new stack. The function returns an integer as an id that must be used in all other functions to access the particular stack.
-  ds_stacks.insert(pair<unsigned int, deque<variant> >(ds_stacks_maxid++, deque<variant>()));
-  return ds_stacks_maxid-1;
+  return ds_stacks.add();
 }
 
 void ds_stack_destroy(const unsigned int id)
 {
   //Destroys the stack
-  ds_stacks.erase(ds_stacks.find(id));
+  ds_stacks.erase(id);
 }
 
 void ds_stack_clear(const unsigned int id)
@@ -1923,15 +2817,19 @@ variant ds_stack_top(const unsigned int id)
 bool ds_stack_exists(const unsigned int id)
 {
   //returns whether the stack exists
-  return (ds_stacks.find(id) != ds_stacks.end());
+  return ds_stacks.exists(id);
+}
+
+unsigned int ds_stack_count()
+{
+  //returns the number of stacks that currently exist
+  return ds_stacks.count();
 }
 
 unsigned int ds_stack_duplicate(const unsigned int source)
 {
   //creates and returns a new stack containing a copy of the source stack
-  ds_stacks.insert(pair<unsigned int, deque<variant> >(++ds_stacks_maxid, deque<variant>()));
-  ds_stacks[ds_stacks_maxid-1] = ds_stacks[source];
-  return ds_stacks_maxid-1;
+  return ds_stacks.add(ds_stacks[source]);
 }
 
 std::string ds_stack_write(const unsigned int id)
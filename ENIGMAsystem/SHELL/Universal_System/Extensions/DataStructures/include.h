@@ -64,6 +64,7 @@ bool ds_grid_value_disk_x(const unsigned int id, const double x, const double y,
 bool ds_grid_value_disk_y(const unsigned int id, const double x, const double y, const double r, const variant val);
 void ds_grid_shuffle(const unsigned int id);
 bool ds_grid_exists(const unsigned int id);
+unsigned int ds_grid_count();
 unsigned int ds_grid_duplicate(const unsigned int source);
 std::string ds_grid_write(const unsigned int id);
 void ds_grid_read(const unsigned int id, std::string value);
@@ -86,6 +87,7 @@ variant ds_map_find_next(const unsigned int id, const variant key);
 variant ds_map_find_first(const unsigned int id);
 variant ds_map_find_last(const unsigned int id);
 bool ds_map_exists(const unsigned int id);
+unsigned int ds_map_count();
 unsigned int ds_map_duplicate(const unsigned int source);
 std::string ds_map_write(const unsigned int source);
 void ds_map_read(const unsigned int id, std::string value);
@@ -106,6 +108,7 @@ variant ds_list_find_value(const unsigned int id, const unsigned int pos);
 void ds_list_sort(const unsigned int id, const bool ascend);
 void ds_list_shuffle(const unsigned int id);
 bool ds_list_exists(const unsigned int id);
+unsigned int ds_list_count();
 unsigned int ds_list_duplicate(const unsigned int source);
 std::string ds_list_write(const unsigned int id);
 void ds_list_read(const unsigned int id, std::string value);
@@ -126,6 +129,7 @@ variant ds_priority_find_min(const unsigned int id);
 variant ds_priority_delete_max(const unsigned int id);
 variant ds_priority_find_max(const unsigned int id);
 bool ds_priority_exists(const unsigned int id);
+unsigned int ds_priority_count();
 unsigned int ds_priority_duplicate(const unsigned int source);
 std::string ds_priority_write(const unsigned int id);
 void ds_priority_read(const unsigned int id, std::string value);
@@ -141,6 +145,7 @@ variant ds_queue_dequeue(const unsigned int id);
 variant ds_queue_head(const unsigned int id);
 variant ds_queue_tail(const unsigned int id);
 bool ds_queue_exists(const unsigned int id);
+unsigned int ds_queue_count();
 unsigned int ds_queue_duplicate(const unsigned int source);
 std::string ds_queue_write(const unsigned int id);
 void ds_queue_read(const unsigned int id, std::string value);
@@ -155,6 +160,7 @@ void ds_stack_push(const unsigned int id, const enigma::varargs &values);
 variant ds_stack_pop(const unsigned int id);
 variant ds_stack_top(const unsigned int id);
 bool ds_stack_exists(const unsigned int id);
+unsigned int ds_stack_count();
 unsigned int ds_stack_duplicate(const unsigned int source);
 std::string ds_stack_write(const unsigned int id);
 void ds_stack_read(const unsigned int id, std::string value);
@@ -59,6 +59,7 @@ unsigned mp_grid_create(int left,int top,int hcells,int vcells,int cellwidth,int
 
 void mp_grid_destroy(unsigned id)
 {
+    enigma::async_forget_grid(id);
     delete enigma::gridstructarray[id];
 }
 
@@ -84,35 +85,10 @@ void mp_grid_copy(unsigned id, unsigned srcid)
     grid->threshold = sgrid->threshold;
     grid->left = sgrid->left;
     grid->top = sgrid->top;
+    grid->jump_points = sgrid->jump_points;
+    grid->revision++;
     for (unsigned int i = 0; i < sgrid->hcells*sgrid->vcells; i++)
-    {
-        enigma::node node(floor(i / sgrid->vcells),i % sgrid->vcells,0,0,0,sgrid->nodearray[i].cost);
-        grid->nodearray.push_back(node);
-    }
-
-    for (unsigned int i = 0; i < grid->hcells; i++){
-        for (unsigned int c = 0; c < grid->vcells; c++){
-        if (i>0){
-            grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[(i-1)*grid->vcells+c]); //left
-            if (c>0)
-                grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[(i-1)*grid->vcells+c-1]); //top-left
-            if (c<grid->vcells-1)
-                grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[(i-1)*grid->vcells+c+1]); //bottom-left
-        }
-        if (c>0)
-            grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[i*grid->vcells+c-1]); //top
-        if (i<grid->hcells-1){
-            grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[(i+1)*grid->vcells+c]); //right
-            if (c>0)
-                grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[(i+1)*grid->vcells+c-1]); //top-right
-            if (c<grid->vcells-1)
-                grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[(i+1)*grid->vcells+c+1]); //bottom-bottom
-        }
-        if (c<grid->vcells-1)
-            grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[i*grid->vcells+c+1]); //bottom
-
-        }
-    }
+        grid->nodearray.push_back(enigma::node(i / sgrid->vcells,i % sgrid->vcells,sgrid->nodearray[i].cost));
 }
 
 void mp_grid_clear_all(unsigned id, unsigned cost)
@@ -120,6 +96,7 @@ void mp_grid_clear_all(unsigned id, unsigned cost)
     for (vector<enigma::node>::iterator it = enigma::gridstructarray[id]->nodearray.begin(); it!=enigma::gridstructarray[id]->nodearray.end(); ++it)
         (*it).cost = cost;
     enigma::gridstructarray[id]->threshold = cost;
+    enigma::gridstructarray[id]->revision++;
 }
 
 void mp_grid_add_rectangle(unsigned id,double x1,double y1,double x2,double y2, unsigned cost)
@@ -138,6 +115,7 @@ void mp_grid_add_rectangle(unsigned id,double x1,double y1,double x2,double y2,
     }
     if (cost>max_cost){max_cost=cost;}
     if (grid->threshold<max_cost){grid->threshold=max_cost;}
+    grid->revision++;
     //std::cout << "mp_grid_add_rectangle(grid," << floor(x1/grid->cellwidth)*grid->cellwidth << "," << floor(y1/grid->cellheight)*grid->cellheight << "," << ceil(x2/grid->cellwidth)*grid->cellwidth << "," << ceil(y2/grid->cellheight)*grid->cellheight<< ");" << std::endl;
 }
 
@@ -157,6 +135,7 @@ void mp_grid_add_instances(unsigned id,int obj,bool prec,unsigned cost)
     }
     if (cost>max_cost){max_cost=cost;}
     if (grid->threshold<max_cost){grid->threshold=max_cost;}
+    grid->revision++;
 }
 
 void mp_grid_reset_threshold(unsigned id)
@@ -166,6 +145,7 @@ void mp_grid_reset_threshold(unsigned id)
     for (vector<enigma::node>::iterator it = grid->nodearray.begin(); it!=grid->nodearray.end(); ++it)
         if ((*it).cost>max_cost){max_cost=(*it).cost;}
     grid->threshold=max_cost;
+    grid->revision++;
 }
 
 void mp_grid_clear_rectangle(unsigned id,double x1,double y1,double x2,double y2, unsigned cost)
@@ -179,6 +159,12 @@ void mp_grid_add_cell(unsigned id,int h,int v, unsigned cost)
     enigma::gridstructarray[id]->nodearray[h*enigma::gridstructarray[id]->vcells+v].cost = cost;
     if (cost>max_cost){max_cost=cost;}
     if (enigma::gridstructarray[id]->threshold<max_cost){enigma::gridstructarray[id]->threshold=max_cost;}
+    enigma::gridstructarray[id]->revision++;
+}
+
+void mp_grid_clear_cell(unsigned id,int h,int v, unsigned cost)
+{
+    mp_grid_add_cell(id,h,v,cost);
 }
 
 unsigned mp_grid_get_cell(unsigned id,int h,int v)
@@ -194,6 +180,7 @@ unsigned mp_grid_get_threshold(unsigned id)
 void mp_grid_set_threshold(unsigned id, unsigned value)
 {
     enigma::gridstructarray[id]->threshold = value;
+    enigma::gridstructarray[id]->revision++;
 }
 
 double mp_grid_get_speed_modifier(unsigned id)
@@ -204,45 +191,73 @@ double mp_grid_get_speed_modifier(unsigned id)
 void mp_grid_set_speed_modifier(unsigned id, double value)
 {
     enigma::gridstructarray[id]->speed_modifier = value;
+    enigma::gridstructarray[id]->revision++;
+}
+
+void mp_grid_set_jump_points(unsigned id, bool enable)
+{
+    enigma::gridstructarray[id]->jump_points = enable;
+    enigma::gridstructarray[id]->revision++;
 }
 
 bool mp_grid_path(unsigned id,unsigned pathid,double xstart,double ystart,double xgoal,double ygoal,bool allowdiag)
 {
     enigma::grid *gr = enigma::gridstructarray[id];
-    int vc = int(enigma::gridstructarray[id]->vcells),
+    unsigned start, goal;
+    if (!enigma::find_path_cells(gr, xstart, ystart, xgoal, ygoal, start, goal)) return false;
+    //if (xstart==xgoal && ystart==ygoal) return;
+
+    vector<unsigned> nodelist;
+    bool status = enigma::find_path(gr, gr->search, start, goal, allowdiag, nodelist); //status to check if we can reach the destination
+    enigma::build_path(gr, pathid, xstart, ystart, xgoal, ygoal, nodelist, status);
+    return true;
+}
+
+}
+
+namespace enigma
+{
+
+bool find_path_cells(const grid *gr, double xstart, double ystart, double xgoal, double ygoal, unsigned &start, unsigned &goal)
+{
+    int vc = int(gr->vcells),
     xs = floor((xstart-gr->left)/int(gr->cellwidth)), ys = floor((ystart-gr->top)/int(gr->cellheight)),
     xg = floor((xgoal-gr->left)/int(gr->cellwidth)), yg = floor((ygoal-gr->top)/int(gr->cellheight));
     if (xs<0 or xg<0) return false;
     if (xs>int(gr->hcells)-1 or xg>int(gr->hcells)-1) return false;
     if (ys<0 or yg<0) return false;
     if (ys>int(gr->vcells)-1 or yg>int(gr->vcells)-1) return false;
-    //if (xstart==xgoal && ystart==ygoal) return;
+    start = xs*vc+ys;
+    goal = xg*vc+yg;
+    return true;
+}
 
-    bool status = true; //status to check if we can reach the destination
-    multimap<unsigned,enigma::node*> nodelist = enigma::find_path(id, &gr->nodearray[xs*vc+ys], &gr->nodearray[xg*vc+yg], allowdiag, status);
+void build_path(const grid *gr, unsigned pathid, double xstart, double ystart, double xgoal, double ygoal, const vector<unsigned> &nodelist, bool status)
+{
+    unsigned start, goal;
+    find_path_cells(gr, xstart, ystart, xgoal, ygoal, start, goal);
     enigma::path *path = enigma::pathstructarray[pathid];
     path->pointarray.clear();
 
     //push the very first point
-    enigma::path_point point(xstart,ystart,gr->speed_modifier/double(gr->nodearray[xs*vc+ys].cost));
+    enigma::path_point point(xstart,ystart,gr->speed_modifier/double(gr->nodearray[start].cost));
     path->pointarray.push_back(point);
-    multimap<unsigned,enigma::node*>::reverse_iterator it;
-    for (it=nodelist.rbegin(); it != nodelist.rend(); it++)
+    for (vector<unsigned>::const_iterator it = nodelist.begin(); it != nodelist.end(); it++)
     {
-            point = enigma::path_point(gr->left+((*it).second->x+0.5)*gr->cellwidth,gr->top+((*it).second->y+0.5)*gr->cellheight,gr->speed_modifier/double((*it).second->cost));
+            const enigma::node &nd = gr->nodearray[*it];
+            point = enigma::path_point(gr->left+(nd.x+0.5)*gr->cellwidth,gr->top+(nd.y+0.5)*gr->cellheight,gr->speed_modifier/double(nd.cost));
             path->pointarray.push_back(point);
     }
 
     //push the very last point if we can reach the destination
     if (status == true){
-        point = enigma::path_point(xgoal,ygoal,gr->speed_modifier/double(gr->nodearray[xg*vc+yg].cost));
+        point = enigma::path_point(xgoal,ygoal,gr->speed_modifier/double(gr->nodearray[goal].cost));
         path->pointarray.push_back(point);
     } else if (path->pointarray.size()==1) {
-        point = enigma::path_point(path->pointarray.back().x,path->pointarray.back().y,gr->speed_modifier/double(gr->nodearray[xg*vc+yg].cost));
+        point = enigma::path_point(path->pointarray.back().x,path->pointarray.back().y,gr->speed_modifier/double(gr->nodearray[goal].cost));
         path->pointarray.push_back(point);
     }
     enigma::path_recalculate(pathid);
-    return true;
 }
 
 }
@@ -271,18 +286,22 @@ void mp_grid_draw_neighbours(unsigned int id, unsigned int h, unsigned int v, un
     if (v>grid->vcells-1) return;
     draw_primitive_begin(8);
     unsigned int vc = enigma::gridstructarray[id]->vcells;
-    for (vector<enigma::node*>::iterator it = enigma::gridstructarray[id]->nodearray[h*vc+v].neighbor_nodes.begin(); it!=enigma::gridstructarray[id]->nodearray[h*vc+v].neighbor_nodes.end(); ++it){
-        draw_vertex_color(grid->left+(*it)->x*grid->cellwidth,grid->top+(*it)->y*grid->cellheight,0x0000FF,(mode==0?0.5:1.0));
-        draw_vertex_color(grid->left+((*it)->x+1)*grid->cellwidth,grid->top+(*it)->y*grid->cellheight,0x0000FF,(mode==0?0.5:1.0));
-        draw_vertex_color(grid->left+((*it)->x+1)*grid->cellwidth,grid->top+((*it)->y+1)*grid->cellheight,0x0000FF,(mode==0?0.5:1.0));
-        draw_vertex_color(grid->left+(*it)->x*grid->cellwidth,grid->top+((*it)->y+1)*grid->cellheight,0x0000FF,(mode==0?0.5:1.0));
+    unsigned neighbors[8];
+    const unsigned count = grid->neighbors(h*vc+v, neighbors);
+    for (unsigned i = 0; i < count; i++){
+        const enigma::node *it = &grid->nodearray[neighbors[i]];
+        draw_vertex_color(grid->left+it->x*grid->cellwidth,grid->top+it->y*grid->cellheight,0x0000FF,(mode==0?0.5:1.0));
+        draw_vertex_color(grid->left+(it->x+1)*grid->cellwidth,grid->top+it->y*grid->cellheight,0x0000FF,(mode==0?0.5:1.0));
+        draw_vertex_color(grid->left+(it->x+1)*grid->cellwidth,grid->top+(it->y+1)*grid->cellheight,0x0000FF,(mode==0?0.5:1.0));
+        draw_vertex_color(grid->left+it->x*grid->cellwidth,grid->top+(it->y+1)*grid->cellheight,0x0000FF,(mode==0?0.5:1.0));
     }
     draw_primitive_end();
     if (mode==1){
         int tc = draw_get_color();
         draw_set_color_rgba(255,255,255,1);
-        for (vector<enigma::node*>::iterator it = enigma::gridstructarray[id]->nodearray[h*vc+v].neighbor_nodes.begin(); it!=enigma::gridstructarray[id]->nodearray[h*vc+v].neighbor_nodes.end(); ++it){
-            draw_text(((*it)->x+0.5)*grid->cellwidth,((*it)->y+0.5)*grid->cellheight,(*it)->x*grid->vcells+(*it)->y);
+        for (unsigned i = 0; i < count; i++){
+            const enigma::node *it = &grid->nodearray[neighbors[i]];
+            draw_text((it->x+0.5)*grid->cellwidth,(it->y+0.5)*grid->cellheight,it->x*grid->vcells+it->y);
         }
         draw_set_color(tc);
     }
@@ -45,5 +45,29 @@ void mp_grid_set_threshold(unsigned id, unsigned threshold = 1);
 void mp_grid_reset_threshold(unsigned id);
 double mp_grid_get_speed_modifier(unsigned id);
 void mp_grid_set_speed_modifier(unsigned id, double value);
+void mp_grid_set_jump_points(unsigned id, bool enable);
+
+// Asynchronous paths: mp_grid_path_async returns a ticket, or -1 if either position is off the grid.
+// The search runs against the grid as it is now, on a worker thread or, without workers, within a
+// per step time budget; once ready, mp_grid_path_async_get fills the path and frees the ticket.
+int mp_grid_path_async(unsigned id, double xstart, double ystart, double xgoal, double ygoal, bool allowdiag);
+bool mp_grid_path_async_ready(int ticket);
+bool mp_grid_path_async_get(int ticket, unsigned path);
+void mp_grid_path_async_cancel(int ticket);
+void mp_grid_path_async_threads(int number);
+void mp_grid_path_async_budget(double milliseconds);
+
+// Flow fields lead every cell of a grid toward the nearest of a set of goals, and follow changes
+// to the grid's costs. The direction is -1, and the next cell is the position itself, at a goal
+// or where no goal can be reached; the distance is then 0 or -1 respectively.
+unsigned mp_grid_flow_create(unsigned id, bool allowdiag);
+void mp_grid_flow_destroy(unsigned id);
+void mp_grid_flow_add_goal(unsigned id, double x, double y);
+void mp_grid_flow_clear_goals(unsigned id);
+void mp_grid_flow_update(unsigned id);
+double mp_grid_flow_distance(unsigned id, double x, double y);
+double mp_grid_flow_direction(unsigned id, double x, double y);
+double mp_grid_flow_next_x(unsigned id, double x, double y);
+double mp_grid_flow_next_y(unsigned id, double x, double y);
 }
 
@@ -27,16 +27,10 @@
 \********************************************************************************/
 
 #include <vector>
-#include <map>
-#include <list>
 #include "motion_planning_struct.h"
 #include <cmath>
 #include <algorithm>
 #include <cstdlib>
-//#include <iostream>
-using std::multimap;
-using std::pair;
-using std::list;
 
 namespace enigma
 {
@@ -47,46 +41,43 @@ namespace enigma
 namespace enigma
 {
     grid::grid(unsigned int idp,int leftp,int topp,unsigned int hcellsp,unsigned int vcellsp,unsigned int cellwidthp,unsigned int cellheightp,unsigned thresholdp,double speed_modifierp):
-        id(idp), left(leftp), top(topp), hcells(hcellsp), vcells(vcellsp), cellwidth(cellwidthp), cellheight(cellheightp), threshold(thresholdp), speed_modifier(speed_modifierp), nodearray()
+        id(idp), left(leftp), top(topp), hcells(hcellsp), vcells(vcellsp), cellwidth(cellwidthp), cellheight(cellheightp), threshold(thresholdp), speed_modifier(speed_modifierp),
+        jump_points(false), nodearray(), revision(0), search()
     {
         gridstructarray[id] = this;
-        gridstructarray[id]->nodearray.reserve(hcells*vcells);
+        nodearray.reserve(hcells*vcells);
         for (unsigned int i = 0; i < hcells*vcells; i++)
-        {
-            node nnode(floor(i / vcells),i % vcells,0,0,0,1);
-            gridstructarray[id]->nodearray.push_back(nnode);
-        }
+            nodearray.push_back(node(i / vcells, i % vcells, 1));
 
-        grid *gr = gridstructarray[id];
+        if (enigma::grid_idmax < id+1)
+          enigma::grid_idmax = id+1;
+    }
+    grid::~grid() { if (gridstructarray[id] == this) gridstructarray[id] = NULL; }
 
-        for (unsigned int i = 0; i < hcells; i++){
-            for (unsigned int c = 0; c < vcells; c++){
-            if (i>0){
-                gr->nodearray[i*vcells+c].neighbor_nodes.push_back(&gr->nodearray[(i-1)*vcells+c]); //left
-                if (c>0)
-                    gr->nodearray[i*vcells+c].neighbor_nodes.push_back(&gr->nodearray[(i-1)*vcells+c-1]); //top-left
-                if (c<vcells-1)
-                    gr->nodearray[i*vcells+c].neighbor_nodes.push_back(&gr->nodearray[(i-1)*vcells+c+1]); //bottom-left
-            }
+    unsigned grid::neighbors(unsigned index, unsigned out[8]) const
+    {
+        const unsigned i = index / vcells, c = index % vcells;
+        unsigned n = 0;
+        if (i>0){
+            out[n++] = (i-1)*vcells+c; //left
             if (c>0)
-                gr->nodearray[i*vcells+c].neighbor_nodes.push_back(&gr->nodearray[i*vcells+c-1]); //top
-            if (i<hcells-1){
-                gr->nodearray[i*vcells+c].neighbor_nodes.push_back(&gr->nodearray[(i+1)*vcells+c]); //right
-                if (c>0)
-                    gr->nodearray[i*vcells+c].neighbor_nodes.push_back(&gr->nodearray[(i+1)*vcells+c-1]); //top-right
-                if (c<vcells-1)
-                    gr->nodearray[i*vcells+c].neighbor_nodes.push_back(&gr->nodearray[(i+1)*vcells+c+1]); //bottom-bottom
-            }
+                out[n++] = (i-1)*vcells+c-1; //top-left
             if (c<vcells-1)
-                gr->nodearray[i*vcells+c].neighbor_nodes.push_back(&gr->nodearray[i*vcells+c+1]); //bottom
-
-            }
+                out[n++] = (i-1)*vcells+c+1; //bottom-left
         }
-
-        if (enigma::grid_idmax < id+1)
-          enigma::grid_idmax = id+1;
+        if (c>0)
+            out[n++] = i*vcells+c-1; //top
+        if (i<hcells-1){
+            out[n++] = (i+1)*vcells+c; //right
+            if (c>0)
+                out[n++] = (i+1)*vcells+c-1; //top-right
+            if (c<vcells-1)
+                out[n++] = (i+1)*vcells+c+1; //bottom-right
+        }
+        if (c<vcells-1)
+            out[n++] = i*vcells+c+1; //bottom
+        return n;
     }
-    grid::~grid() { gridstructarray[id] = NULL; }
 
     void gridstructarray_reallocate()
     {
@@ -96,154 +87,258 @@ namespace enigma
     }
 
     //Helper functions
-    static inline unsigned find_heuristic(const node* n0, const node* n1, bool allow_diag) //Distance from n0 to n1
+    static inline unsigned find_heuristic(int x0, int y0, int x1, int y1, bool allow_diag) //Distance from (x0,y0) to (x1,y1)
     {
-        if (!allow_diag){
-            //std::cout << "Straight " << " H = " << fabs((int)n0->x-(int)n1->x) + fabs((int)n0->y-(int)n1->y) << std::endl;
-            return fabs((int)n0->x-(int)n1->x) + fabs((int)n0->y-(int)n1->y);
-        } else {
-            //std::cout << "Diagn " << " H = " << fmax(fabs((int)n0->x-(int)n1->x) , fabs((int)n0->y-(int)n1->y)) << std::endl;
-            return fmax(fabs((int)n0->x-(int)n1->x) , fabs((int)n0->y-(int)n1->y));
+        const unsigned dx = abs(x0 - x1), dy = abs(y0 - y1);
+        return allow_diag ? std::max(dx, dy) : dx + dy;
+    }
+
+    //A lower bound on the cost of a path from (x0,y0) to (x1,y1) over nodes costing at least 1.
+    //Each straight move covers one row or column and costs at least 1, and each diagonal move
+    //covers one of each and costs at least 2, so even with diagonals this is the Manhattan distance.
+    static inline unsigned find_estimate(int x0, int y0, int x1, int y1)
+    {
+        return abs(x0 - x1) + abs(y0 - y1);
+    }
+
+    //The open list is a binary heap of node indices, ordered on F and then on the larger G, each
+    //node keeping its place in the heap so that a better path to it can move it up
+    static inline bool open_before(const vector<search_node> &sn, unsigned a, unsigned b)
+    {
+        return sn[a].F < sn[b].F || (sn[a].F == sn[b].F && sn[a].G > sn[b].G);
+    }
+
+    static void open_sift_up(path_search &ps, unsigned pos)
+    {
+        vector<unsigned> &heap = ps.open_heap;
+        vector<search_node> &sn = ps.searcharray;
+        const unsigned n = heap[pos];
+        while (pos > 0)
+        {
+            const unsigned parent = (pos - 1) / 2;
+            if (!open_before(sn, n, heap[parent]))
+                break;
+            heap[pos] = heap[parent];
+            sn[heap[pos]].heap_index = pos;
+            pos = parent;
         }
+        heap[pos] = n;
+        sn[n].heap_index = pos;
     }
 
-    static inline int find_priority(multimap<unsigned,node*> &m, node* value){
-        multimap<unsigned,node*>::iterator it;
-        for (it = m.begin(); it != m.end(); it++)
-            if (it->second == value) return (int)it->first;
-        return -1;
+    static void open_push(path_search &ps, unsigned n)
+    {
+        ps.open_heap.push_back(n);
+        open_sift_up(ps, ps.open_heap.size() - 1);
     }
 
-    static inline bool check_corners(unsigned id, node* n0, node* n1) //There must be a better way to do this
+    static unsigned open_pop(path_search &ps)
     {
-        //std::cout << "Searching..." << std::endl;
-        for (vector<enigma::node*>::iterator it0 = n0->neighbor_nodes.begin(); it0!=n0->neighbor_nodes.end(); ++it0)
+        vector<unsigned> &heap = ps.open_heap;
+        vector<search_node> &sn = ps.searcharray;
+        const unsigned top = heap[0], n = heap.back();
+        heap.pop_back();
+        const unsigned size = heap.size();
+        if (size)
         {
-            for (vector<enigma::node*>::iterator it1 = n1->neighbor_nodes.begin(); it1!=n1->neighbor_nodes.end(); ++it1)
+            unsigned pos = 0;
+            for (;;)
             {
-               // std::cout << (*it0) << " == " << (*it1) << " && it0.cost=" << (*it0)->cost << std::endl;
-                if ((*it0)==(*it1) && (*it0)->cost >= gridstructarray[id]->threshold)
-                return true;
+                unsigned child = 2*pos + 1;
+                if (child >= size)
+                    break;
+                if (child + 1 < size && open_before(sn, heap[child + 1], heap[child]))
+                    child++;
+                if (!open_before(sn, heap[child], n))
+                    break;
+                heap[pos] = heap[child];
+                sn[heap[pos]].heap_index = pos;
+                pos = child;
             }
+            heap[pos] = n;
+            sn[n].heap_index = pos;
         }
-        return false;
+        return top;
     }
 
-    multimap<unsigned,node*> find_path(unsigned id, node* n0, node* n1, bool allow_diag, bool &status)
+    //Reaches node n from node from with the given G, unless it is closed or already reached as cheaply
+    static inline void reach(path_search &ps, unsigned from, unsigned n, unsigned G, unsigned H)
     {
-        node* current;
-        for (unsigned int i = 0; i < gridstructarray[id]->hcells*gridstructarray[id]->vcells; i++)
-        {
-            gridstructarray[id]->nodearray[i].F=0;
-            gridstructarray[id]->nodearray[i].G=0;
-            gridstructarray[id]->nodearray[i].H=0;
-            gridstructarray[id]->nodearray[i].came_from=NULL;
+        search_node &s = ps.searcharray[n];
+        if (s.stamp != ps.stamp) {
+            s.stamp = ps.stamp;
+            s.closed = false;
+            s.G = G;
+            s.F = G + H;
+            s.parent = from;
+            open_push(ps, n);
+        } else if (!s.closed && G < s.G) {
+            s.G = G;
+            s.F = G + H;
+            s.parent = from;
+            open_sift_up(ps, s.heap_index);
         }
+    }
 
-        node* start = n0;
-        node* destination = n1;
-        multimap<unsigned,node*> OPEN;
-        list<node*> CLOSED;
-        multimap<unsigned,node*> mm_ret;
-
-        if (start == destination)
-            return mm_ret;
-        start->H = find_heuristic(start,destination,allow_diag);
-        start->F = start->H;
-        OPEN.insert(pair<unsigned,node*>(start->F,start));
-
-        while (find(CLOSED.begin(), CLOSED.end(), destination) == CLOSED.end() && !OPEN.empty())
-        //loop until destination is in the closed list or the open multimap is empty
+    static void expand_neighbors(const grid *gr, path_search &ps, unsigned current, int x, int y, int gx, int gy, bool allow_diag)
+    {
+        const unsigned vc = gr->vcells, G = ps.searcharray[current].G;
+        for (int dx = -1; dx <= 1; dx++)
         {
-            //if (OPEN.empty()){break;}
-            //multimap<unsigned,node*>::iterator tit;
-            /*std::cout << "Begin" << std::endl;
-            for ( tit=OPEN.begin() ; tit != OPEN.end(); tit++ )
-                std::cout << (*tit).first << " => " << (*tit).second << std::endl;*/
-
-            //this is basically ds_priority_delete_min
+            for (int dy = -1; dy <= 1; dy++)
             {
-              multimap<unsigned,node*>::iterator it = OPEN.begin(), it_check;
-              it_check = it++;
-              while (it != OPEN.end())
-              {
-                  if ((*it).first < (*it_check).first) {it_check = it;}
-                  it++;
-              }
-              current = (*it_check).second;
-              OPEN.erase(it_check);
-            }
-            //std::cout << OPEN.size() << std::endl;
-            //std::cout << "End" << std::endl;
-            //multimap<unsigned,node*>::iterator tit;
-            /*for ( tit=OPEN.begin() ; tit != OPEN.end(); tit++ )
-                std::cout << (*tit).first << " => " << (*tit).second << std::endl;*/
-            //std::cout << "Ended" << std::endl;
-
-            CLOSED.push_front(current);
-            for (vector<enigma::node*>::iterator it = current->neighbor_nodes.begin(); it!=current->neighbor_nodes.end(); ++it)
-            { //go trough all the neighbors (should be faster then 8 if cycles like in the init)
-                if (!allow_diag && (*it)->x != current->x && (*it)->y != current->y)
+                const bool diagonal = dx && dy;
+                if ((!dx && !dy) || (diagonal && !allow_diag) || !passable(gr, x+dx, y+dy))
                     continue;
+                if (diagonal && (!passable(gr, x+dx, y) || !passable(gr, x, y+dy)))
+                    continue; //don't cut the corner of a blocked node
+                const unsigned n = (x+dx)*vc + y+dy;
+                reach(ps, current, n, G + move_cost(gr->nodearray[n].cost, diagonal), find_estimate(x+dx, y+dy, gx, gy));
+            }
+        }
+    }
 
-                bool cutting = false;
-                if (allow_diag == true  && (*it)->x != current->x && (*it)->y != current->y)
-                        cutting = check_corners(id, current, (*it));
-
-                if (find(CLOSED.begin(), CLOSED.end(), (*it)) == CLOSED.end() && (*it)->cost<gridstructarray[id]->threshold && cutting == false){
-                    if (find_priority(OPEN,(*it)) == -1){ //if the node isn't on the open list
-                        (*it)->came_from = current;
-                        (*it)->G = current->G + (*it)->cost;
-                        if ((*it)->x != current->x && (*it)->y != current->y)
-                            (*it)->G += ceil((*it)->cost/2.5); //if it is diagonal increase the move cost
-                        (*it)->H = find_heuristic(*it,destination,allow_diag);
-                        (*it)->F = (*it)->G + (*it)->H;
-                        //std::cout << "Node: " << (*it)->x*gridstructarray[id]->vcells+(*it)->y << " F = " << (*it)->F << " H = " << (*it)->H << " G = " << (*it)->G << std::endl;
-                        OPEN.insert(pair<unsigned,node*>((*it)->F,(*it)));
-
-                    }else{ //if the node is already on the open list we just have to see if it is a better path
-                        unsigned temp_G = current->G + (*it)->cost;
-                        if (temp_G < (*it)->G) {
-                            (*it)->came_from = current;
-                            (*it)->G = current->G + (*it)->cost;
-                            if ((*it)->x != current->x && (*it)->y != current->y)
-                                (*it)->G += ceil((*it)->cost/2.5);
-                            (*it)->H = find_heuristic(*it,destination,allow_diag);
-                            (*it)->F = (*it)->G + (*it)->H;
-                        }
-                    }
+    //Walks from (x,y) in direction (dx,dy) until reaching the goal or a node with a forced neighbor,
+    //which is returned as a jump point, or a blocked node, in which case -1 is returned
+    static int jump(const grid *gr, int x, int y, int dx, int dy, int gx, int gy, bool allow_diag)
+    {
+        for (;;)
+        {
+            if (!passable(gr, x, y))
+                return -1;
+            if (x == gx && y == gy)
+                return x*gr->vcells + y;
+            if (dx && dy) {
+                if (jump(gr, x+dx, y, dx, 0, gx, gy, allow_diag) != -1 || jump(gr, x, y+dy, 0, dy, gx, gy, allow_diag) != -1)
+                    return x*gr->vcells + y;
+            } else if (dx) {
+                if ((passable(gr, x, y-1) && !passable(gr, x-dx, y-1)) || (passable(gr, x, y+1) && !passable(gr, x-dx, y+1)))
+                    return x*gr->vcells + y;
+            } else {
+                if ((passable(gr, x-1, y) && !passable(gr, x-1, y-dy)) || (passable(gr, x+1, y) && !passable(gr, x+1, y-dy)))
+                    return x*gr->vcells + y;
+                if (!allow_diag && (jump(gr, x+1, y, 1, 0, gx, gy, allow_diag) != -1 || jump(gr, x-1, y, -1, 0, gx, gy, allow_diag) != -1))
+                    return x*gr->vcells + y;
+            }
+            if (allow_diag && (!passable(gr, x+dx, y) || !passable(gr, x, y+dy)))
+                return -1; //the next diagonal step would cut a corner
+            x += dx, y += dy;
+        }
+    }
+
+    static void expand_jump_points(const grid *gr, path_search &ps, unsigned current, int x, int y, int gx, int gy, bool allow_diag)
+    {
+        const unsigned vc = gr->vcells;
+        const search_node cs = ps.searcharray[current];
+        int dirs[8][2], count = 0;
+        if (cs.parent == current) { //the start node; every direction
+            for (int dx = -1; dx <= 1; dx++)
+                for (int dy = -1; dy <= 1; dy++)
+                    if ((dx || dy) && (!(dx && dy) || (allow_diag && passable(gr, x+dx, y) && passable(gr, x, y+dy))))
+                        dirs[count][0] = dx, dirs[count][1] = dy, count++;
+        } else {
+            const int px = cs.parent / vc, py = cs.parent % vc;
+            const int dx = (x > px) - (x < px), dy = (y > py) - (y < py);
+            if (dx && dy) {
+                const bool walk_x = passable(gr, x+dx, y), walk_y = passable(gr, x, y+dy);
+                if (walk_y) dirs[count][0] = 0, dirs[count][1] = dy, count++;
+                if (walk_x) dirs[count][0] = dx, dirs[count][1] = 0, count++;
+                if (walk_x && walk_y) dirs[count][0] = dx, dirs[count][1] = dy, count++;
+            } else if (!allow_diag) {
+                dirs[count][0] = dx, dirs[count][1] = dy, count++;
+                dirs[count][0] = dy, dirs[count][1] = dx, count++;
+                dirs[count][0] = -dy, dirs[count][1] = -dx, count++;
+            } else {
+                //(sx,sy) is a step to either side of the direction of travel
+                const int sx = dy, sy = dx;
+                const bool next = passable(gr, x+dx, y+dy), side1 = passable(gr, x+sx, y+sy), side2 = passable(gr, x-sx, y-sy);
+                if (next) {
+                    dirs[count][0] = dx, dirs[count][1] = dy, count++;
+                    if (side1) dirs[count][0] = dx+sx, dirs[count][1] = dy+sy, count++;
+                    if (side2) dirs[count][0] = dx-sx, dirs[count][1] = dy-sy, count++;
                 }
+                if (side1) dirs[count][0] = sx, dirs[count][1] = sy, count++;
+                if (side2) dirs[count][0] = -sx, dirs[count][1] = -sy, count++;
             }
         }
-        node *last, *nearest;
-        unsigned i = 0;
-        status = true;
-        if (find(CLOSED.begin(), CLOSED.end(), destination) == CLOSED.end())
-        {   //this is for if the destionation can't be found if
-            status = false;
-            nearest = start;
-
-            list<node*>::iterator it;
-            for (it=CLOSED.begin(); it != CLOSED.end(); it++){
-                (*it)->H = find_heuristic(*it,destination,allow_diag);
-                if ((*it)->H < nearest->H)
-                    nearest = *it;
+
+        for (int i = 0; i < count; i++)
+        {
+            const int dx = dirs[i][0], dy = dirs[i][1];
+            const int j = jump(gr, x+dx, y+dy, dx, dy, gx, gy, allow_diag);
+            if (j == -1)
+                continue;
+            //Every node walked over on the way to the jump point adds its cost
+            unsigned G = cs.G;
+            for (int wx = x, wy = y; unsigned(wx*vc + wy) != unsigned(j); )
+            {
+                wx += dx, wy += dy;
+                G += move_cost(gr->nodearray[wx*vc + wy].cost, dx && dy);
             }
-            destination = nearest;
-            if (start == destination)
-                return mm_ret;
+            reach(ps, current, j, G, find_estimate(j / vc, j % vc, gx, gy));
         }
+    }
+
+    bool find_path(const grid *gr, path_search &ps, unsigned start, unsigned goal, bool allow_diag, vector<unsigned> &path)
+    {
+        const unsigned vc = gr->vcells;
+        path.clear();
+        if (start == goal)
+            return true;
 
-        //mm_ret.insert(pair<unsigned,node*>(i,destination));
-        last = destination;
-        while (last->came_from != start){
-            i += 1;
-            mm_ret.insert(pair<unsigned,node*>(i,last->came_from));
-            last = last->came_from;
+        if (ps.searcharray.size() != gr->nodearray.size() || ++ps.stamp == 0)
+        {   //stamps are new or have wrapped around, so forget them all
+            ps.searcharray.assign(gr->nodearray.size(), search_node());
+            ps.stamp = 1;
         }
+        ps.open_heap.clear();
+
+        const int gx = goal / vc, gy = goal % vc;
+        search_node &ss = ps.searcharray[start];
+        ss.stamp = ps.stamp;
+        ss.closed = false;
+        ss.G = 0;
+        ss.F = find_estimate(start / vc, start % vc, gx, gy);
+        ss.parent = start;
+        open_push(ps, start);
 
-        //delete CLOSED;
-        //delete OPEN;
-        return mm_ret; //return the multimap containing a list of all the nodes that are in the path.
+        //if the destination can't be reached, the path leads to the closed node nearest to it instead
+        unsigned nearest = start, nearest_H = find_heuristic(start / vc, start % vc, gx, gy, allow_diag);
+        bool status = false;
+        while (!ps.open_heap.empty())
+        {
+            const unsigned current = open_pop(ps);
+            ps.searcharray[current].closed = true;
+            if (current == goal) {
+                status = true;
+                break;
+            }
+            const int x = current / vc, y = current % vc;
+            const unsigned H = find_heuristic(x, y, gx, gy, allow_diag);
+            if (H < nearest_H || (H == nearest_H && nearest != start))
+                nearest = current, nearest_H = H;
+
+            if (gr->jump_points)
+                expand_jump_points(gr, ps, current, x, y, gx, gy, allow_diag);
+            else
+                expand_neighbors(gr, ps, current, x, y, gx, gy, allow_diag);
+        }
+
+        //walk back from the end of the path, filling in the nodes a jump passed over
+        const unsigned last = status ? goal : nearest;
+        for (unsigned n = last; n != start; )
+        {
+            const unsigned from = ps.searcharray[n].parent;
+            int x = n / vc, y = n % vc;
+            const int fx = from / vc, fy = from % vc;
+            const int dx = (fx > x) - (fx < x), dy = (fy > y) - (fy < y);
+            for (x += dx, y += dy; x != fx || y != fy; x += dx, y += dy)
+                path.push_back(x*vc + y);
+            if (from != start)
+                path.push_back(from);
+            n = from;
+        }
+        std::reverse(path.begin(), path.end());
+        return status;
     }
 }
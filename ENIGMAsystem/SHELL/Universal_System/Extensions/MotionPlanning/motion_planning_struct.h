@@ -27,9 +27,7 @@
 \********************************************************************************/
 #include <vector>
 #include <cstdlib>
-#include <map>
 using std::vector;
-using std::multimap;
 
 #ifdef INCLUDED_FROM_SHELLMAIN
 #  error This file includes non-ENIGMA STL headers and should not be included from SHELLmain.
@@ -39,11 +37,25 @@ namespace enigma
 {
   struct node
   {
-    unsigned x, y, F, H, G, cost;
-    node* came_from;
-    vector<node*> neighbor_nodes;
-    node(unsigned X = 0, unsigned Y = 0, unsigned f = 0, unsigned h = 0, unsigned g = 0, unsigned Cost = 0, node* CameFrom = NULL):
-      x(X), y(Y), F(f), H(h), G(g), cost(Cost), came_from(CameFrom) {}
+    unsigned x, y, cost;
+    node(unsigned X = 0, unsigned Y = 0, unsigned Cost = 0): x(X), y(Y), cost(Cost) {}
+  };
+  // Per node state of a path search. Only valid while stamp equals the search's stamp, so
+  // nothing has to be cleared between searches.
+  struct search_node
+  {
+    unsigned stamp, G, F, parent, heap_index;
+    bool closed;
+    search_node(): stamp(0), G(0), F(0), parent(0), heap_index(0), closed(false) {}
+  };
+  // Working storage for path searches, kept between them. Searches running at the same time need
+  // one each.
+  struct path_search
+  {
+    vector<search_node> searcharray;
+    vector<unsigned> open_heap; // Open nodes, a binary heap on F
+    unsigned stamp;
+    path_search(): stamp(0) {}
   };
   struct grid
   {
@@ -52,11 +64,39 @@ namespace enigma
     unsigned int hcells, vcells, cellwidth, cellheight;
     unsigned threshold;
     double speed_modifier;
-    vector<node> nodearray;
+    bool jump_points; // Search with jump point search; only optimal where all passable cells cost the same
+    vector<node> nodearray; // Column by column: cell (x, y) is at x*vcells + y
+    unsigned revision; // Changed along with anything a search, or the path built from one, reads
+    path_search search; // For searches made on the game thread
     grid(unsigned int id,int left,int top,unsigned int hcells,unsigned int vcells,unsigned int cellwidth,unsigned int cellheight, unsigned int threshold, double speed_modifier);
     ~grid();
+    // Fills out with the cells next to the given one, in the order left, top-left, bottom-left,
+    // top, right, top-right, bottom-right, bottom, skipping those off the grid; returns how many.
+    unsigned neighbors(unsigned index, unsigned out[8]) const;
   };
   extern grid** gridstructarray;
   void gridstructarray_reallocate();
-  multimap<unsigned,node*> find_path(unsigned id, node* n0, node* n1, bool allow_diag, bool &status);
+  static inline bool passable(const grid *gr, int x, int y)
+  {
+    return x >= 0 && y >= 0 && unsigned(x) < gr->hcells && unsigned(y) < gr->vcells && gr->nodearray[x*gr->vcells+y].cost < gr->threshold;
+  }
+  // The cost of moving onto a node of the given cost; diagonal moves cost ceil(cost/2.5) more.
+  // Nodes costing 0 are moved onto as if they cost 1, which the search's estimate relies on.
+  static inline unsigned move_cost(unsigned cost, bool diagonal)
+  {
+    if (cost < 1) cost = 1;
+    return diagonal ? cost + (2*cost + 4)/5 : cost;
+  }
+  // Searches gr for a path from node start to node goal, both indices into its nodearray.
+  // Fills path with the nodes strictly between start and the end of the path, from the start on,
+  // and returns whether goal was reached; if not, the path ends at the searched node nearest it.
+  // The grid is only read, so searches of one grid may run at once, each with its own search.
+  bool find_path(const grid *gr, path_search &search, unsigned start, unsigned goal, bool allow_diag, vector<unsigned> &path);
+  // Finds the nodes holding the start and goal positions; returns false if either is off the grid.
+  bool find_path_cells(const grid *gr, double xstart, double ystart, double xgoal, double ygoal, unsigned &start, unsigned &goal);
+  // Fills path pathid with the points of a path found by find_path between the given positions.
+  void build_path(const grid *gr, unsigned pathid, double xstart, double ystart, double xgoal, double ygoal, const vector<unsigned> &nodelist, bool status);
+  // Drops the snapshot asynchronous searches keep of a grid being destroyed; searches already
+  // submitted on it still finish.
+  void async_forget_grid(unsigned id);
 }
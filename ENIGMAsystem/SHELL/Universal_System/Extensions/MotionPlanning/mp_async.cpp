@@ -0,0 +1,398 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2026 The ENIGMA Team                                          **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+// Path searches submitted now and collected later. Each search runs against a snapshot of its
+// grid taken when it was submitted, so the grid may change meanwhile, and the search may run on a
+// worker thread. Searches from one snapshot between the same cells share a single job.
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64) || defined(__WIN64__)
+#include <windows.h>
+#else
+#include <pthread.h> // use POSIX threads
+#include <time.h>
+#endif
+
+#include <deque>
+#include <map>
+#include <vector>
+using namespace std;
+
+#include "Universal_System/callbacks_events.h"
+#include "motion_planning_struct.h"
+#include "motion_planning.h"
+
+namespace enigma
+{
+  // A copy of a grid as it was at some revision. Guarded by async_lock.
+  struct grid_snapshot
+  {
+    grid copy;
+    unsigned id, revision;
+    unsigned jobs;  // Jobs searching it
+    bool cached;    // Still the newest snapshot of its grid
+    grid_snapshot(const grid &gr, unsigned gid): copy(gr), id(gid), revision(gr.revision), jobs(0), cached(true) {
+      copy.search = path_search();
+    }
+  };
+
+  struct path_job_key
+  {
+    grid_snapshot *snapshot;
+    unsigned start, goal;
+    bool allow_diag;
+    bool operator<(const path_job_key &o) const {
+      if (snapshot != o.snapshot) return snapshot < o.snapshot;
+      if (start != o.start) return start < o.start;
+      if (goal != o.goal) return goal < o.goal;
+      return allow_diag < o.allow_diag;
+    }
+  };
+
+  // One search, shared by every ticket waiting on it. Whoever drops the last use of it frees it.
+  struct path_job
+  {
+    path_job_key key;
+    enum { queued, running, done } state;
+    unsigned tickets;
+    bool reached;
+    vector<unsigned> nodes;
+  };
+
+  struct path_ticket
+  {
+    path_job *job;
+    double xstart, ystart, xgoal, ygoal;
+  };
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64) || defined(__WIN64__)
+  typedef HANDLE async_worker_handle;
+  static CRITICAL_SECTION async_lock;
+  static CONDITION_VARIABLE async_wake;
+  static void async_init() {
+    InitializeCriticalSection(&async_lock);
+    InitializeConditionVariable(&async_wake);
+  }
+  static inline void async_acquire() { EnterCriticalSection(&async_lock); }
+  static inline void async_release() { LeaveCriticalSection(&async_lock); }
+  static inline void async_wait() { SleepConditionVariableCS(&async_wake, &async_lock, INFINITE); }
+  static inline void async_broadcast() { WakeAllConditionVariable(&async_wake); }
+  static double async_clock() // In milliseconds
+  {
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return count.QuadPart * 1000.0 / frequency.QuadPart;
+  }
+#else
+  typedef pthread_t async_worker_handle;
+  static pthread_mutex_t async_lock;
+  static pthread_cond_t async_wake;
+  static void async_init() {
+    pthread_mutex_init(&async_lock, NULL);
+    pthread_cond_init(&async_wake, NULL);
+  }
+  static inline void async_acquire() { pthread_mutex_lock(&async_lock); }
+  static inline void async_release() { pthread_mutex_unlock(&async_lock); }
+  static inline void async_wait() { pthread_cond_wait(&async_wake, &async_lock); }
+  static inline void async_broadcast() { pthread_cond_broadcast(&async_wake); }
+  static double async_clock() // In milliseconds
+  {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+  }
+#endif
+
+  static bool async_initialized = false;
+  static vector<async_worker_handle> async_workers;
+  static bool async_quit = false;
+  static double async_budget = 2; // Milliseconds of searching per step when there are no workers
+
+  // Everything below is guarded by async_lock.
+  static map<unsigned, grid_snapshot*> async_snapshots; // The newest snapshot of each grid
+  static map<path_job_key, path_job*> async_jobs;       // Every job still in use
+  static deque<path_job*> async_queue;                  // Jobs waiting to run, oldest first
+  static map<int, path_ticket> async_tickets;
+  static int async_next_ticket = 0;
+
+  static void async_initialize()
+  {
+    if (!async_initialized) {
+      async_init();
+      async_initialized = true;
+    }
+  }
+
+  static void release_snapshot(grid_snapshot *snap)
+  {
+    if (--snap->jobs == 0 && !snap->cached)
+      delete snap;
+  }
+
+  static void free_job(path_job *job)
+  {
+    async_jobs.erase(job->key);
+    release_snapshot(job->key.snapshot);
+    delete job;
+  }
+
+  static void release_job(path_job *job)
+  {
+    if (--job->tickets)
+      return;
+    if (job->state == path_job::done)
+      free_job(job);
+    // Queued or running jobs are freed by whoever runs them, once they see nobody wants them.
+  }
+
+  // Runs the oldest queued job, if any, with the given search storage. Returns false if there was
+  // nothing to run. Called with async_lock held; releases it while searching.
+  static bool run_queued_job(path_search &search)
+  {
+    path_job *job = NULL;
+    while (!async_queue.empty() && !job)
+    {
+      job = async_queue.front();
+      async_queue.pop_front();
+      if (!job->tickets) {
+        free_job(job);
+        job = NULL;
+      }
+    }
+    if (!job)
+      return false;
+
+    job->state = path_job::running;
+    async_release();
+    const path_job_key &key = job->key;
+    job->reached = find_path(&key.snapshot->copy, search, key.start, key.goal, key.allow_diag, job->nodes);
+    async_acquire();
+    job->state = path_job::done;
+    if (!job->tickets)
+      free_job(job);
+    return true;
+  }
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64) || defined(__WIN64__)
+  static DWORD WINAPI async_worker(LPVOID)
+#else
+  static void* async_worker(void*)
+#endif
+  {
+    path_search search;
+    async_acquire();
+    while (!async_quit)
+      if (!run_queued_job(search))
+        async_wait();
+    async_release();
+    return 0;
+  }
+
+  static void async_stop()
+  {
+    async_acquire();
+    async_quit = true;
+    async_broadcast();
+    async_release();
+    for (size_t i = 0; i < async_workers.size(); i++)
+    {
+#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64) || defined(__WIN64__)
+      WaitForSingleObject(async_workers[i], INFINITE);
+      CloseHandle(async_workers[i]);
+#else
+      pthread_join(async_workers[i], NULL);
+#endif
+    }
+    async_workers.clear();
+    async_quit = false;
+  }
+
+  static void async_start(int count)
+  {
+    for (int i = 0; i < count; i++)
+    {
+#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64) || defined(__WIN64__)
+      const async_worker_handle handle = CreateThread(NULL, 0, async_worker, NULL, 0, NULL);
+      if (handle == NULL) break;
+#else
+      async_worker_handle handle;
+      if (pthread_create(&handle, NULL, async_worker, NULL)) break;
+#endif
+      async_workers.push_back(handle);
+    }
+  }
+
+  // Without workers, queued searches run on the game thread each step until the budget is spent,
+  // though at least one always runs so that a small budget still makes progress.
+  static void async_step()
+  {
+    if (!async_workers.empty())
+      return;
+    static path_search search;
+    const double until = async_clock() + async_budget;
+    async_acquire();
+    while (run_queued_job(search) && async_clock() < until);
+    async_release();
+  }
+
+  // Stops reusing a grid's snapshot for new searches; it is freed once its last job is.
+  static void uncache_snapshot(map<unsigned, grid_snapshot*>::iterator it)
+  {
+    grid_snapshot *snap = it->second;
+    snap->cached = false;
+    async_snapshots.erase(it);
+    if (!snap->jobs)
+      delete snap;
+  }
+
+  static grid_snapshot *snapshot_grid(unsigned id)
+  {
+    const grid *gr = gridstructarray[id];
+    map<unsigned, grid_snapshot*>::iterator it = async_snapshots.find(id);
+    if (it != async_snapshots.end())
+    {
+      if (it->second->revision == gr->revision)
+        return it->second;
+      uncache_snapshot(it);
+    }
+    grid_snapshot *snap = new grid_snapshot(*gr, id);
+    async_snapshots[id] = snap;
+    return snap;
+  }
+
+  void async_forget_grid(unsigned id)
+  {
+    if (!async_initialized)
+      return;
+    async_acquire();
+    map<unsigned, grid_snapshot*>::iterator it = async_snapshots.find(id);
+    if (it != async_snapshots.end())
+      uncache_snapshot(it);
+    async_release();
+  }
+
+  static path_job *find_ticket_job(int ticket)
+  {
+    map<int, path_ticket>::iterator it = async_tickets.find(ticket);
+    return it == async_tickets.end() ? NULL : it->second.job;
+  }
+}
+
+namespace enigma_user
+{
+
+int mp_grid_path_async(unsigned id, double xstart, double ystart, double xgoal, double ygoal, bool allowdiag)
+{
+    enigma::grid *gr = enigma::gridstructarray[id];
+    unsigned start, goal;
+    if (!enigma::find_path_cells(gr, xstart, ystart, xgoal, ygoal, start, goal)) return -1;
+
+    static bool registered = false;
+    if (!registered) {
+        enigma::async_initialize();
+        enigma::register_callback_before_collision_event(enigma::async_step);
+        registered = true;
+    }
+
+    enigma::async_acquire();
+    enigma::grid_snapshot *snap = enigma::snapshot_grid(id);
+    const enigma::path_job_key key = { snap, start, goal, allowdiag };
+    enigma::path_job *&job = enigma::async_jobs[key];
+    if (!job) {
+        job = new enigma::path_job();
+        job->key = key;
+        job->state = enigma::path_job::queued;
+        job->tickets = 0;
+        job->reached = false;
+        snap->jobs++;
+        enigma::async_queue.push_back(job);
+        enigma::async_broadcast();
+    }
+    job->tickets++;
+    const enigma::path_ticket ticket = { job, xstart, ystart, xgoal, ygoal };
+    const int t = enigma::async_next_ticket++;
+    enigma::async_tickets[t] = ticket;
+    enigma::async_release();
+    return t;
+}
+
+bool mp_grid_path_async_ready(int ticket)
+{
+    if (!enigma::async_initialized) return false;
+    enigma::async_acquire();
+    const enigma::path_job *job = enigma::find_ticket_job(ticket);
+    const bool ready = job && job->state == enigma::path_job::done;
+    enigma::async_release();
+    return ready;
+}
+
+bool mp_grid_path_async_get(int ticket, unsigned pathid)
+{
+    if (!enigma::async_initialized) return false;
+    enigma::async_acquire();
+    map<int, enigma::path_ticket>::iterator it = enigma::async_tickets.find(ticket);
+    if (it == enigma::async_tickets.end() || it->second.job->state != enigma::path_job::done) {
+        enigma::async_release();
+        return false;
+    }
+    // Done jobs are no longer touched by workers, and only freed here, on the game thread.
+    const enigma::path_ticket t = it->second;
+    enigma::async_tickets.erase(it);
+    enigma::async_release();
+
+    enigma::build_path(&t.job->key.snapshot->copy, pathid, t.xstart, t.ystart, t.xgoal, t.ygoal, t.job->nodes, t.job->reached);
+    enigma::async_acquire();
+    enigma::release_job(t.job);
+    enigma::async_release();
+    return true;
+}
+
+void mp_grid_path_async_cancel(int ticket)
+{
+    if (!enigma::async_initialized) return;
+    enigma::async_acquire();
+    map<int, enigma::path_ticket>::iterator it = enigma::async_tickets.find(ticket);
+    if (it != enigma::async_tickets.end()) {
+        enigma::release_job(it->second.job);
+        enigma::async_tickets.erase(it);
+    }
+    enigma::async_release();
+}
+
+void mp_grid_path_async_threads(int number)
+{
+    enigma::async_initialize();
+    enigma::async_stop();
+    enigma::async_start(number);
+}
+
+void mp_grid_path_async_budget(double milliseconds)
+{
+    enigma::async_budget = milliseconds;
+}
+
+}
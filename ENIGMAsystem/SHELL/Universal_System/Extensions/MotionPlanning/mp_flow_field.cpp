@@ -0,0 +1,367 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2026 The ENIGMA Team                                          **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+// Flow fields: the cost of the cheapest route from every cell of a grid to the nearest of a set of
+// goal cells, with the neighbor each cell should move to next, so that any number of instances
+// heading for the same goals can find their way with a lookup instead of a search each.
+// A field follows its grid: when the grid changes, only the cells whose routes were affected
+// are searched again.
+
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <vector>
+using namespace std;
+
+#include "motion_planning_struct.h"
+#include "motion_planning.h"
+
+namespace enigma
+{
+  extern size_t grid_idmax;
+
+  static const unsigned flow_unreached = ~0u, flow_none = ~0u;
+
+  struct flow_field
+  {
+    unsigned grid_id;
+    bool allow_diag;
+    vector<unsigned> goals;
+    bool stale;                // Goals or settings changed; recompute from scratch
+    unsigned revision;         // Of the grid when last brought up to date
+    unsigned threshold;        // Of the grid, likewise
+    vector<unsigned> costs;    // The grid's costs, likewise
+    vector<unsigned> distance; // The cost of reaching a goal from each cell
+    vector<unsigned> next;     // The neighbor to move to from each cell, or flow_none
+  };
+
+  static vector<flow_field*> flow_fields;
+
+  typedef pair<unsigned, unsigned> flow_entry; // Distance and cell
+  typedef priority_queue<flow_entry, vector<flow_entry>, greater<flow_entry> > flow_queue;
+
+  // Whether a move from cell (x,y) by (dx,dy) is allowed: the target must be passable, and a
+  // diagonal move may not cut the corner of a blocked cell. The cell moved from need not be
+  // passable, so that instances pushed into a wall are led back out.
+  static inline bool flow_move(const grid *gr, int x, int y, int dx, int dy, bool allow_diag)
+  {
+    if (!passable(gr, x+dx, y+dy))
+      return false;
+    if (dx && dy)
+      return allow_diag && passable(gr, x+dx, y) && passable(gr, x, y+dy);
+    return true;
+  }
+
+  // Relaxes every neighbor of each cell taken from the queue, until it is empty.
+  static void flow_propagate(flow_field *ff, const grid *gr, flow_queue &queue)
+  {
+    const int vc = gr->vcells;
+    while (!queue.empty())
+    {
+      const flow_entry top = queue.top();
+      queue.pop();
+      const unsigned u = top.second;
+      if (top.first != ff->distance[u])
+        continue; // Reached more cheaply since it was queued
+      const int ux = u / vc, uy = u % vc;
+      for (int dx = -1; dx <= 1; dx++)
+        for (int dy = -1; dy <= 1; dy++)
+        {
+          const int vx = ux - dx, vy = uy - dy;
+          if ((!dx && !dy) || vx < 0 || vy < 0 || unsigned(vx) >= gr->hcells || vy >= vc)
+            continue;
+          if (!flow_move(gr, vx, vy, dx, dy, ff->allow_diag))
+            continue;
+          const unsigned v = vx*vc + vy, d = top.first + move_cost(gr->nodearray[u].cost, dx && dy);
+          if (d < ff->distance[v]) {
+            ff->distance[v] = d;
+            ff->next[v] = u;
+            queue.push(flow_entry(d, v));
+          }
+        }
+    }
+  }
+
+  // Sets cell v to the best route through any of its neighbors, or to zero if it is a
+  // passable goal, and queues it if that is better than what it had.
+  static void flow_reseed(flow_field *ff, const grid *gr, unsigned v, const vector<bool> &is_goal, flow_queue &queue)
+  {
+    const int vc = gr->vcells, vx = v / vc, vy = v % vc;
+    if (is_goal[v] && passable(gr, vx, vy)) {
+      if (ff->distance[v] != 0) {
+        ff->distance[v] = 0;
+        ff->next[v] = flow_none;
+        queue.push(flow_entry(0, v));
+      }
+      return;
+    }
+    for (int dx = -1; dx <= 1; dx++)
+      for (int dy = -1; dy <= 1; dy++)
+      {
+        if ((!dx && !dy) || !flow_move(gr, vx, vy, dx, dy, ff->allow_diag))
+          continue;
+        const unsigned u = (vx+dx)*vc + vy+dy;
+        if (ff->distance[u] == flow_unreached)
+          continue;
+        const unsigned d = ff->distance[u] + move_cost(gr->nodearray[u].cost, dx && dy);
+        if (d < ff->distance[v]) {
+          ff->distance[v] = d;
+          ff->next[v] = u;
+          queue.push(flow_entry(d, v));
+        }
+      }
+  }
+
+  static vector<bool> flow_goal_cells(const flow_field *ff, const grid *gr)
+  {
+    vector<bool> is_goal(gr->nodearray.size(), false);
+    for (size_t i = 0; i < ff->goals.size(); i++)
+      if (ff->goals[i] < is_goal.size())
+        is_goal[ff->goals[i]] = true;
+    return is_goal;
+  }
+
+  static void flow_snapshot(flow_field *ff, const grid *gr)
+  {
+    ff->revision = gr->revision;
+    ff->threshold = gr->threshold;
+    ff->costs.resize(gr->nodearray.size());
+    for (size_t i = 0; i < gr->nodearray.size(); i++)
+      ff->costs[i] = gr->nodearray[i].cost;
+  }
+
+  static void flow_compute(flow_field *ff, const grid *gr)
+  {
+    ff->distance.assign(gr->nodearray.size(), flow_unreached);
+    ff->next.assign(gr->nodearray.size(), flow_none);
+    flow_queue queue;
+    const int vc = gr->vcells;
+    for (size_t i = 0; i < ff->goals.size(); i++)
+    {
+      const unsigned g = ff->goals[i];
+      if (g < ff->distance.size() && passable(gr, g / vc, g % vc) && ff->distance[g]) {
+        ff->distance[g] = 0;
+        queue.push(flow_entry(0, g));
+      }
+    }
+    flow_propagate(ff, gr, queue);
+    flow_snapshot(ff, gr);
+    ff->stale = false;
+  }
+
+  // Whether the move from cell v to its neighbor u depends on cell c, as the target or a corner.
+  static inline bool flow_move_uses(unsigned vc, unsigned v, unsigned u, unsigned c)
+  {
+    if (u == c)
+      return true;
+    const unsigned vx = v / vc, vy = v % vc, ux = u / vc, uy = u % vc;
+    return vx != ux && vy != uy && (c == vx*vc + uy || c == ux*vc + vy);
+  }
+
+  // Repairs the field after some costs changed. Cells whose route got dearer, and every cell
+  // routed through them, are forgotten and reached again from their neighbors; cells next to one
+  // that got cheaper are given the chance of a route through it.
+  static void flow_repair(flow_field *ff, const grid *gr, const vector<unsigned> &changed)
+  {
+    const unsigned vc = gr->vcells;
+    vector<unsigned> forgotten;
+    vector<bool> lost(gr->nodearray.size(), false);
+    for (size_t i = 0; i < changed.size(); i++)
+    {
+      const unsigned c = changed[i], old_cost = ff->costs[c], cost = gr->nodearray[c].cost;
+      const bool blocked = old_cost < ff->threshold && cost >= gr->threshold;
+      if (cost <= old_cost && !blocked)
+        continue;
+      unsigned around[9];
+      const unsigned n = gr->neighbors(c, around);
+      around[n] = c;
+      for (unsigned k = 0; k <= n; k++)
+      {
+        const unsigned v = around[k], u = ff->next[v];
+        if (!lost[v] && (v == c || (u != flow_none && flow_move_uses(vc, v, u, c) && (u == c || blocked)))) {
+          lost[v] = true;
+          forgotten.push_back(v);
+        }
+      }
+    }
+
+    // Everything routed through a forgotten cell goes too
+    for (size_t i = 0; i < forgotten.size(); i++)
+    {
+      unsigned around[8];
+      const unsigned n = gr->neighbors(forgotten[i], around);
+      for (unsigned k = 0; k < n; k++)
+        if (!lost[around[k]] && ff->next[around[k]] == forgotten[i]) {
+          lost[around[k]] = true;
+          forgotten.push_back(around[k]);
+        }
+    }
+    for (size_t i = 0; i < forgotten.size(); i++) {
+      ff->distance[forgotten[i]] = flow_unreached;
+      ff->next[forgotten[i]] = flow_none;
+    }
+
+    const vector<bool> is_goal = flow_goal_cells(ff, gr);
+    flow_queue queue;
+    for (size_t i = 0; i < forgotten.size(); i++)
+      flow_reseed(ff, gr, forgotten[i], is_goal, queue);
+    for (size_t i = 0; i < changed.size(); i++)
+    {
+      unsigned around[9];
+      const unsigned n = gr->neighbors(changed[i], around);
+      around[n] = changed[i];
+      for (unsigned k = 0; k <= n; k++)
+        flow_reseed(ff, gr, around[k], is_goal, queue);
+    }
+    flow_propagate(ff, gr, queue);
+    flow_snapshot(ff, gr);
+  }
+
+  // Brings the field up to date with its grid, returning the grid, or NULL if it is gone.
+  static const grid *flow_update(flow_field *ff)
+  {
+    const grid *gr = ff->grid_id < grid_idmax ? gridstructarray[ff->grid_id] : NULL;
+    if (!gr)
+      return NULL;
+    if (ff->stale || ff->costs.size() != gr->nodearray.size() || ff->threshold != gr->threshold)
+      flow_compute(ff, gr);
+    else if (ff->revision != gr->revision)
+    {
+      vector<unsigned> changed;
+      for (size_t i = 0; i < ff->costs.size(); i++)
+        if (ff->costs[i] != gr->nodearray[i].cost)
+          changed.push_back(i);
+      // Past a point, repairing costs more than starting over
+      if (changed.size() > ff->costs.size() / 8)
+        flow_compute(ff, gr);
+      else
+        flow_repair(ff, gr, changed);
+    }
+    return gr;
+  }
+
+  // Finds the field and the cell holding the given position, brought up to date; returns the
+  // cell, or flow_none if the position is off the grid.
+  static unsigned flow_cell(unsigned id, double x, double y, flow_field *&ff, const grid *&gr)
+  {
+    ff = id < flow_fields.size() ? flow_fields[id] : NULL;
+    gr = ff ? flow_update(ff) : NULL;
+    if (!gr)
+      return flow_none;
+    const int h = floor((x - gr->left) / int(gr->cellwidth)), v = floor((y - gr->top) / int(gr->cellheight));
+    if (h < 0 || v < 0 || unsigned(h) >= gr->hcells || unsigned(v) >= gr->vcells)
+      return flow_none;
+    return h*gr->vcells + v;
+  }
+}
+
+namespace enigma_user
+{
+
+unsigned mp_grid_flow_create(unsigned id, bool allowdiag)
+{
+    enigma::flow_field *ff = new enigma::flow_field();
+    ff->grid_id = id;
+    ff->allow_diag = allowdiag;
+    ff->stale = true;
+    ff->revision = 0;
+    ff->threshold = 0;
+    enigma::flow_fields.push_back(ff);
+    return enigma::flow_fields.size() - 1;
+}
+
+void mp_grid_flow_destroy(unsigned id)
+{
+    if (id >= enigma::flow_fields.size()) return;
+    delete enigma::flow_fields[id];
+    enigma::flow_fields[id] = NULL;
+}
+
+void mp_grid_flow_add_goal(unsigned id, double x, double y)
+{
+    enigma::flow_field *ff = id < enigma::flow_fields.size() ? enigma::flow_fields[id] : NULL;
+    if (!ff || ff->grid_id >= enigma::grid_idmax || !enigma::gridstructarray[ff->grid_id]) return;
+    const enigma::grid *gr = enigma::gridstructarray[ff->grid_id];
+    const int h = floor((x - gr->left) / int(gr->cellwidth)), v = floor((y - gr->top) / int(gr->cellheight));
+    if (h < 0 || v < 0 || unsigned(h) >= gr->hcells || unsigned(v) >= gr->vcells) return;
+    ff->goals.push_back(h*gr->vcells + v);
+    ff->stale = true;
+}
+
+void mp_grid_flow_clear_goals(unsigned id)
+{
+    if (id >= enigma::flow_fields.size() || !enigma::flow_fields[id]) return;
+    enigma::flow_fields[id]->goals.clear();
+    enigma::flow_fields[id]->stale = true;
+}
+
+void mp_grid_flow_update(unsigned id)
+{
+    if (id < enigma::flow_fields.size() && enigma::flow_fields[id])
+        enigma::flow_update(enigma::flow_fields[id]);
+}
+
+double mp_grid_flow_distance(unsigned id, double x, double y)
+{
+    enigma::flow_field *ff;
+    const enigma::grid *gr;
+    const unsigned cell = enigma::flow_cell(id, x, y, ff, gr);
+    if (cell == enigma::flow_none || ff->distance[cell] == enigma::flow_unreached) return -1;
+    return ff->distance[cell];
+}
+
+double mp_grid_flow_next_x(unsigned id, double x, double y)
+{
+    enigma::flow_field *ff;
+    const enigma::grid *gr;
+    const unsigned cell = enigma::flow_cell(id, x, y, ff, gr);
+    if (cell == enigma::flow_none || ff->next[cell] == enigma::flow_none) return x;
+    return gr->left + (ff->next[cell] / gr->vcells + 0.5) * gr->cellwidth;
+}
+
+double mp_grid_flow_next_y(unsigned id, double x, double y)
+{
+    enigma::flow_field *ff;
+    const enigma::grid *gr;
+    const unsigned cell = enigma::flow_cell(id, x, y, ff, gr);
+    if (cell == enigma::flow_none || ff->next[cell] == enigma::flow_none) return y;
+    return gr->top + (ff->next[cell] % gr->vcells + 0.5) * gr->cellheight;
+}
+
+double mp_grid_flow_direction(unsigned id, double x, double y)
+{
+    enigma::flow_field *ff;
+    const enigma::grid *gr;
+    const unsigned cell = enigma::flow_cell(id, x, y, ff, gr);
+    if (cell == enigma::flow_none || ff->next[cell] == enigma::flow_none) return -1;
+    const int dx = int(ff->next[cell] / gr->vcells) - int(cell / gr->vcells),
+              dy = int(ff->next[cell] % gr->vcells) - int(cell % gr->vcells);
+    const double dir = atan2(-double(dy) * gr->cellheight, double(dx) * gr->cellwidth) * 180 / M_PI;
+    return dir < 0 ? dir + 360 : dir;
+}
+
+}
@@ -47,6 +47,8 @@ namespace enigma_user {
   void part_system_automatic_draw(int id, bool automatic);
   void part_system_update(int id);
   void part_system_drawit(int id);
+  // Number of threads, the game thread included, sharing the update of each system's particles.
+  void part_update_threads(int number);
   // Particles.
   void part_particles_create(int id, double x, double y, int particle_type_id, int number);
   void part_particles_create_color(int id, double x, double y, int particle_type_id, int color, int number);
@@ -26,9 +26,9 @@
 #include "Graphics_Systems/General/GSd3d.h"
 #include "PS_particle_instance.h"
 #include "PS_particle_sprites.h"
+#include "PS_particle_quads.h"
 #include <vector>
-#include <deque>
-#include <cmath>
+#include <cstddef>
 #include <algorithm>
 #ifndef __APPLE__
 #include <GL/gl.h>
@@ -64,6 +64,12 @@ namespace enigma {
     }
     GLuint vao;
     GLuint shader_program;
+    // Kept from frame to frame; each only grows, and the indices never change.
+    GLuint vbo, eab;
+    size_t vbo_vertices = 0; // Capacity of vbo.
+    particle_quad_stream quad_stream;
+    std::vector<unsigned int> quad_indices;
+    size_t eab_quads = 0; // Quads indexed in eab.
     void initialize_particle_bridge() {
 
       int major_version;
@@ -127,281 +133,61 @@ namespace enigma {
       // Link and use the program.
       glLinkProgram(shader_program);
       glUseProgram(shader_program);
+
+      // The buffers and their layout are part of the vertex array's state, so they are set up once.
+      glGenBuffers(1, &vbo);
+      glBindBuffer(GL_ARRAY_BUFFER, vbo);
+      glGenBuffers(1, &eab);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eab);
+
+      GLint position_attribute = glGetAttribLocation(shader_program, "position");
+      glVertexAttribPointer(position_attribute, 2, GL_FLOAT, GL_FALSE, sizeof(particle_vertex), (GLvoid*)offsetof(particle_vertex, x));
+      glEnableVertexAttribArray(position_attribute);
+
+      GLint color_attribute = glGetAttribLocation(shader_program, "input_color");
+      glVertexAttribPointer(color_attribute, 4, GL_FLOAT, GL_FALSE, sizeof(particle_vertex), (GLvoid*)offsetof(particle_vertex, r));
+      glEnableVertexAttribArray(color_attribute);
+
+      GLint texcoord_attribute = glGetAttribLocation(shader_program, "tex_coord");
+      glVertexAttribPointer(texcoord_attribute, 2, GL_FLOAT, GL_FALSE, sizeof(particle_vertex), (GLvoid*)offsetof(particle_vertex, u));
+      glEnableVertexAttribArray(texcoord_attribute);
+
+      glBindVertexArray(0);
+      glUseProgram(0);
     }
-    inline int __GETR(int x) {return x & 0x0000FF;}
-    inline int __GETG(int x) {return (x & 0x00FF00) >> 8;}
-    inline int __GETB(int x) {return (x & 0xFF0000) >> 16;}
-    double wiggle;
-    int subimage_index;
-    double x_offset;
-    double y_offset;
-
-  void draw_particles(std::vector<particle_instance>& pi_list, bool oldtonew, double a_wiggle, int a_subimage_index,
-      double a_x_offset, double a_y_offset) {
+
+  void draw_particles(particle_store& pi_list, bool oldtonew, double wiggle, int subimage_index,
+      double x_offset, double y_offset) {
       using namespace enigma::particle_bridge;
-      wiggle = a_wiggle;
-      subimage_index = a_subimage_index;
-      x_offset = a_x_offset;
-      y_offset = a_y_offset;
 
       glPushAttrib(GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT); // Attrib push 1.
 
-      if (pi_list.size() > 0) {
+      if (pi_list.count() > 0) {
+        quad_stream.build(pi_list, oldtonew, wiggle, subimage_index, x_offset, y_offset);
+      }
+
+      // Without quads there is nothing to upload, and the vertex stream may not hold a single one.
+      if (pi_list.count() > 0 && quad_stream.quads > 0) {
         glBindVertexArray(vao); // Bind vertex array.
         glUseProgram(shader_program); // Bind shader program.
 
         // Transfer data to shaders.
 
-        const unsigned int pi_list_size = pi_list.size();
-
-        std::vector<GLfloat> points;
-        points.reserve(pi_list_size*2);
-
-        std::vector<GLfloat> colors;
-        colors.reserve(pi_list_size*3);
-
-        std::vector<GLfloat> texcoords;
-        texcoords.reserve(pi_list_size*2);
-
-        std::vector<GLuint> indices;
-        indices.reserve(pi_list_size*6);
-
-        std::vector<int> texture_indices;
-        std::deque<bool> blend_adds;
-
-        for (unsigned int i = 0; i < pi_list_size; i++) {
-
-          particle_instance& pi = pi_list[i];
-          double x, y;
-          int color = pi.color;
-          int alpha = pi.alpha;
-          double xscale, yscale;
-          double rot;
-          double width, height;
-          double pi_x_offset, pi_y_offset;
-          double tbx, tby;
-          if (pi.pt->alive) {
-            particle_type* pt = pi.pt;
-            x = pi.x;
-            y = pi.y;
-            double size = std::max(0.0, pi.size + pt->size_wiggle*particle_system::get_wiggle_result(pi.size_wiggle_offset, wiggle));
-            xscale = pt->xscale*size;
-            yscale = pt->yscale*size;
-            double rot_degrees = pi.angle + pt->ang_wiggle*particle_system::get_wiggle_result(pi.ang_wiggle_offset, wiggle);
-            if (pt->ang_relative) {
-              rot_degrees += pi.direction;
-            }
-            rot = rot_degrees*M_PI/180.0;
-            blend_adds.push_back(pt->blend_additive);
-
-            if (!pt->is_particle_sprite && enigma_user::sprite_exists(pt->sprite_id)) {
-              int sprite_id = pt->sprite_id;
-              int subimg;
-              if (!pt->sprite_animated) {
-                subimg = pi.sprite_subimageindex_initial;
-              }
-              else {
-                const sprite *const spr = spritestructarray[pt->sprite_id];
-                const int subimage_count = spr->subcount;
-                if (pt->sprite_stretched) {
-                  subimg = int(subimage_count*(1.0 - 1.0*pi.life_current/pi.life_start));
-                  subimg = subimg >= subimage_count ? subimage_count - 1 : subimg;
-                  subimg = subimg % subimage_count;
-                }
-                else {
-                  subimg = (subimage_index + pi.sprite_subimageindex_initial) % subimage_count;
-                }
-              }
-              const enigma::sprite *const spr2d = enigma::spritestructarray[sprite_id];
-              const int usi = subimg % spr2d->subcount;
-              width = spr2d->width;
-              height = spr2d->height;
-              pi_x_offset = spr2d->xoffset;
-              pi_y_offset = spr2d->yoffset;
-              tbx = spr2d->texbordxarray[usi];
-              tby = spr2d->texbordyarray[usi];
-              texture_indices.push_back(spr2d->texturearray[usi]);
-            }
-            else {
-              particle_sprite* ps;
-              if (!pt->is_particle_sprite) {
-                ps = get_particle_sprite(pt_sh_pixel);
-              }
-              else {
-                ps = pt->part_sprite;
-              }
-              width = ps->width;
-              height = ps->height;
-              pi_x_offset = ps->width/2.0;
-              pi_y_offset = ps->height/2.0;
-              tbx = 1.0;
-              tby = 1.0;
-              texture_indices.push_back(ps->texture);
-            }
-          }
-          else {
-            double size = pi.size;
-            if (size <= 0) size = 0;
-
-            particle_sprite* ps = get_particle_sprite(pt_sh_pixel);
-            texture_indices.push_back(ps->texture);
-            blend_adds.push_back(false);
-
-            rot = pi.angle*M_PI/180.0;
+        const size_t vertex_count = 4*quad_stream.quads;
 
-            x = round(pi.x), y = round(pi.y);
-            xscale = size, yscale = size;
-            pi_x_offset = ps->width/2.0;
-            pi_y_offset = ps->height/2.0;
-            width = ps->width, height = ps->height;
-            tbx = 1, tby = 1;
-          }
-
-          const double
-          w = width*xscale, h = height*yscale,
-          wsinrot = w*sin(rot), wcosrot = w*cos(rot);
-
-          // Particle system offset.
-          x += x_offset;
-          y += y_offset;
-
-          double ulcx = x - xscale * pi_x_offset * cos(rot) + yscale * pi_y_offset * cos(M_PI/2+rot);
-          double ulcy = y + xscale * pi_x_offset * sin(rot) - yscale * pi_y_offset * sin(M_PI/2+rot);
-
-          double t1x = 0, t1y = 0;
-          double v1x = ulcx, v1y = ulcy;
-          double t2x = tbx, t2y = 0;
-          double v2x = ulcx + wcosrot, v2y = ulcy - wsinrot;
-
-          const double mpr = 3*M_PI/2 + rot;
-          ulcx += h * cos(mpr);
-          ulcy -= h * sin(mpr);
-
-          double t3x = 0, t3y = tby;
-          double v3x = ulcx, v3y = ulcy;
-          double t4x = tbx, t4y = tby;
-          double v4x = ulcx + wcosrot, v4y = ulcy - wsinrot;
-
-          points.push_back(v1x);
-          points.push_back(v1y);
-          points.push_back(v2x);
-          points.push_back(v2y);
-          points.push_back(v3x);
-          points.push_back(v3y);
-          points.push_back(v4x);
-          points.push_back(v4y);
-          const GLfloat r = __GETR(color)/255.0, g = __GETG(color)/255.0, b = __GETB(color)/255.0;
-          const GLfloat a = alpha/255.0;
-          colors.push_back(r);
-          colors.push_back(g);
-          colors.push_back(b);
-          colors.push_back(a);
-          colors.push_back(r);
-          colors.push_back(g);
-          colors.push_back(b);
-          colors.push_back(a);
-          colors.push_back(r);
-          colors.push_back(g);
-          colors.push_back(b);
-          colors.push_back(a);
-          colors.push_back(r);
-          colors.push_back(g);
-          colors.push_back(b);
-          colors.push_back(a);
-          texcoords.push_back(t1x);
-          texcoords.push_back(t1y);
-          texcoords.push_back(t2x);
-          texcoords.push_back(t2y);
-          texcoords.push_back(t3x);
-          texcoords.push_back(t3y);
-          texcoords.push_back(t4x);
-          texcoords.push_back(t4y);
-          unsigned int i4 = i*4;
-          if (!oldtonew) {
-            i4 = (pi_list_size - 1 - i)*4;
-          }
-          indices.push_back(i4 + 0);
-          indices.push_back(i4 + 1);
-          indices.push_back(i4 + 2);
-          indices.push_back(i4 + 1);
-          indices.push_back(i4 + 2);
-          indices.push_back(i4 + 3);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (vertex_count > vbo_vertices) {
+          vbo_vertices = std::max(vertex_count, 2*vbo_vertices);
+          glBufferData(GL_ARRAY_BUFFER, sizeof(particle_vertex)*vbo_vertices, NULL, GL_STREAM_DRAW);
         }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(particle_vertex)*vertex_count, &quad_stream.vertices[0]);
 
-        std::vector<std::pair<int,int> > switch_offset_instcount;
-        {
-          bool init = true;
-          int prev_texture_index = -1;
-          bool prev_blend_add = false;
-          int curr_texture_index = -1;
-          bool curr_blend_add = false;
-          int switch_offset = 0;
-          int switch_count = 0;
-          for (unsigned int loop_i = 0; loop_i  < pi_list.size(); loop_i ++) {
-            unsigned int i = loop_i;
-            if (!oldtonew) {
-              i = pi_list_size - 1 - loop_i;
-            }
-
-            curr_texture_index = texture_indices[i];
-            curr_blend_add = blend_adds[i];
-
-            if (init) {
-              init = false;
-            }
-            else {
-              if (prev_blend_add != curr_blend_add || prev_texture_index != curr_texture_index) {
-                int new_offset = switch_offset;
-                if (!oldtonew) {
-                  new_offset = pi_list_size - switch_offset - 1;
-                }
-                switch_offset_instcount.push_back(std::pair<int,int>(new_offset, switch_count));
-                switch_offset = i;
-                switch_count = 0;
-              }
-            }
-            switch_count++;
-            prev_texture_index = curr_texture_index;
-            prev_blend_add = curr_blend_add;
-          }
-          int new_offset = switch_offset;
-          if (!oldtonew) {
-            new_offset = pi_list_size - switch_offset - 1;
-          }
-          switch_offset_instcount.push_back(std::pair<int,int>(new_offset, switch_count));
+        if (quad_stream.quads > eab_quads) {
+          eab_quads = std::max(quad_stream.quads, 2*eab_quads);
+          particle_quad_indices(quad_indices, eab_quads);
+          glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*quad_indices.size(), &quad_indices[0], GL_STATIC_DRAW);
         }
 
-        const unsigned int points_bsize = sizeof(GLfloat)*points.size();
-        const unsigned int colors_bsize = sizeof(GLfloat)*colors.size();
-        const unsigned int texcoords_bsize = sizeof(GLfloat)*texcoords.size();
-        const unsigned int total_bsize = points_bsize + colors_bsize + texcoords_bsize;
-
-        GLuint vbo;
-        glGenBuffers(1, &vbo); // Allocate vertex buffer array 1.
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, total_bsize, NULL, GL_STATIC_DRAW);
-
-        glBufferSubData(GL_ARRAY_BUFFER, 0, points_bsize, points.data());
-        glBufferSubData(GL_ARRAY_BUFFER, points_bsize, colors_bsize, colors.data());
-        glBufferSubData(GL_ARRAY_BUFFER, points_bsize + colors_bsize, texcoords_bsize, texcoords.data());
-
-        GLint position_attribute = glGetAttribLocation(shader_program, "position");
-        glVertexAttribPointer(position_attribute, 2, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(position_attribute);
-
-        GLint color_attribute = glGetAttribLocation(shader_program, "input_color");
-        glVertexAttribPointer(color_attribute, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*)points_bsize);
-        glEnableVertexAttribArray(color_attribute);
-
-        GLint texcoord_attribute = glGetAttribLocation(shader_program, "tex_coord");
-        glVertexAttribPointer(texcoord_attribute, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(points_bsize + colors_bsize));
-        glEnableVertexAttribArray(texcoord_attribute);
-
-        GLuint eab;
-        glGenBuffers(1, &eab); // Allocate element array buffer 1.
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eab);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*indices.size(), indices.data(), GL_STATIC_DRAW);
-
         GLint transform_matrix_location = glGetUniformLocation(shader_program, "trans_mat");
         glUniformMatrix4fv(transform_matrix_location, 1, GL_FALSE, mv_matrix.Transpose());
 
@@ -410,30 +196,19 @@ namespace enigma {
 
         // Draw.
 
-        for (unsigned i = 0; i < switch_offset_instcount.size(); i++) {
-          int switch_offset = switch_offset_instcount[i].first;
-          int switch_count = switch_offset_instcount[i].second;
-
-          int actual_index = switch_offset;
-          if (!oldtonew) {
-            actual_index = pi_list_size - switch_offset - 1;
-          }
-          enigma_user::texture_set(textureStructs[texture_indices[actual_index]]->gltex);
-          if (blend_adds[actual_index]) {
+        for (size_t i = 0; i < quad_stream.batches.size(); i++) {
+          const particle_batch& batch = quad_stream.batches[i];
+          enigma_user::texture_set(textureStructs[batch.texture]->gltex);
+          if (batch.blend_additive) {
             glBlendFunc(GL_SRC_ALPHA,GL_ONE);
           }
           else {
             glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
           }
 
-          glDrawElements(GL_TRIANGLES, switch_count*6, GL_UNSIGNED_INT, (GLvoid*)(0 + switch_offset*6*sizeof(GLuint))); // 6 vertices per particle instance.
+          glDrawElements(GL_TRIANGLES, batch.count*6, GL_UNSIGNED_INT, (GLvoid*)(batch.first*6*sizeof(GLuint))); // 6 vertices per particle instance.
         }
 
-        // Cleanup.
-
-        glDeleteBuffers(1, &eab); // Deallocate element array buffer 1.
-        glDeleteBuffers(1, &vbo); // Deallocate vertex buffer array 1.
-
         glBindVertexArray(0); // Unbind vertex array.
         glUseProgram(0); // Unbind shader program.
       }
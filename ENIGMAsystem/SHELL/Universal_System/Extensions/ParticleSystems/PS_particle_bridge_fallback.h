@@ -132,7 +132,7 @@ namespace enigma {
         enigma_user::draw_sprite_ext(sprite_id, 0, x + x_offset, y + y_offset, xscale, yscale, rot_degrees, color, (double)alpha/255.0);
       }
     }
-    void draw_particles(std::vector<particle_instance>& pi_list, bool oldtonew, double a_wiggle, int a_subimage_index,
+    void draw_particles(particle_store& pi_list, bool oldtonew, double a_wiggle, int a_subimage_index,
       double a_x_offset, double a_y_offset)
     {
         using namespace enigma::particle_bridge;
@@ -147,16 +147,17 @@ namespace enigma {
         int blend_dest = enigma::currentblendmode[1];
 
         if (oldtonew) {
-          const std::vector<particle_instance>::iterator end = pi_list.end();
-          for (std::vector<particle_instance>::iterator it = pi_list.begin(); it != end; it++)
+          const size_t count = pi_list.count();
+          for (size_t i = 0; i < count; i++)
           {
-            draw_particle(&(*it));
+            particle_instance pi = pi_list.get(i);
+            draw_particle(&pi);
           }
         } else {
-          const std::vector<particle_instance>::reverse_iterator rend = pi_list.rend();
-          for (std::vector<particle_instance>::reverse_iterator it = pi_list.rbegin(); it != rend; it++)
+          for (size_t i = pi_list.count(); i-- > 0; )
           {
-            draw_particle(&(*it));
+            particle_instance pi = pi_list.get(i);
+            draw_particle(&pi);
           }
         }
 
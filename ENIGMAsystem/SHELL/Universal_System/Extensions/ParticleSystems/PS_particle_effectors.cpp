@@ -0,0 +1,150 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2026 The ENIGMA Team                                          **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#include "PS_particle_effectors.h"
+
+namespace enigma
+{
+  // Cells along each axis are bounded so that filing a large effector stays cheap.
+  static const int effector_grid_max_cells = 16;
+
+  static const std::vector<unsigned> no_effectors;
+
+  particle_effector_grid::particle_effector_grid(): x0(0), y0(0), x1(0), y1(0),
+      cell_width(1), cell_height(1), columns(0), rows(0), unbounded(false)
+  {
+  }
+
+  void particle_effector_grid::clear()
+  {
+    boxes.clear();
+    for (size_t i = 0; i < cells.size(); i++)
+    {
+      cells[i].clear();
+    }
+    everywhere.clear();
+    columns = rows = 0;
+    unbounded = false;
+  }
+
+  void particle_effector_grid::add(double xmin, double ymin, double xmax, double ymax)
+  {
+    const box b = {xmin, ymin, xmax, ymax};
+    boxes.push_back(b);
+  }
+
+  int particle_effector_grid::column(double x) const {
+    return std::min(columns - 1, std::max(0, int((x - x0)/cell_width)));
+  }
+
+  int particle_effector_grid::row(double y) const {
+    return std::min(rows - 1, std::max(0, int((y - y0)/cell_height)));
+  }
+
+  void particle_effector_grid::build()
+  {
+    size_t filed = 0;
+    for (size_t i = 0; i < boxes.size(); i++)
+    {
+      const box& b = boxes[i];
+      if (!(b.xmin < b.xmax && b.ymin < b.ymax)) {
+        continue;
+      }
+      if (!filed) {
+        x0 = b.xmin, y0 = b.ymin, x1 = b.xmax, y1 = b.ymax;
+      }
+      else {
+        x0 = std::min(x0, b.xmin), y0 = std::min(y0, b.ymin);
+        x1 = std::max(x1, b.xmax), y1 = std::max(y1, b.ymax);
+      }
+      filed++;
+    }
+    if (!filed) {
+      return;
+    }
+
+    if (!(std::isfinite(x0) && std::isfinite(y0) && std::isfinite(x1) && std::isfinite(y1) &&
+          std::isfinite(x1 - x0) && std::isfinite(y1 - y0))) {
+      // Cells cannot be laid over an infinite extent; test every effector everywhere.
+      unbounded = true;
+      for (size_t i = 0; i < boxes.size(); i++)
+      {
+        const box& b = boxes[i];
+        if (b.xmin < b.xmax && b.ymin < b.ymax) {
+          everywhere.push_back(i);
+        }
+      }
+      return;
+    }
+
+    // About four effectors to a cell when they are spread out.
+    const int cells_per_axis = std::min(effector_grid_max_cells, std::max(1, int(std::ceil(std::sqrt(filed/4.0)))));
+    columns = rows = cells_per_axis;
+    cell_width = (x1 - x0)/columns;
+    cell_height = (y1 - y0)/rows;
+    if (!(cell_width > 0.0 && cell_height > 0.0)) {
+      // Too thin to divide.
+      columns = rows = 1;
+      cell_width = cell_height = 1.0;
+    }
+    if (cells.size() < size_t(columns*rows)) {
+      cells.resize(columns*rows);
+    }
+
+    for (size_t i = 0; i < boxes.size(); i++)
+    {
+      const box& b = boxes[i];
+      if (!(b.xmin < b.xmax && b.ymin < b.ymax)) {
+        continue;
+      }
+      const int c1 = column(b.xmin), c2 = column(b.xmax), r1 = row(b.ymin), r2 = row(b.ymax);
+      for (int r = r1; r <= r2; r++)
+      {
+        for (int c = c1; c <= c2; c++)
+        {
+          cells[r*columns + c].push_back(i);
+        }
+      }
+    }
+  }
+
+  const std::vector<unsigned>& particle_effector_grid::candidates(double x, double y) const
+  {
+    if (unbounded) {
+      return everywhere;
+    }
+    // Points outside the grid, or not a number, are inside no box.
+    if (!columns || !(x >= x0 && x <= x1 && y >= y0 && y <= y1)) {
+      return no_effectors;
+    }
+    return cells[row(y)*columns + column(x)];
+  }
+}
+
@@ -0,0 +1,72 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2026 The ENIGMA Team                                          **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#ifndef ENIGMA_PS_PARTICLEEFFECTORS
+#define ENIGMA_PS_PARTICLEEFFECTORS
+
+#include <cstddef>
+#include <vector>
+
+namespace enigma
+{
+  // A coarse uniform grid over the bounding boxes of a system's attractors, destroyers, deflectors
+  // or changers, so that each particle only tests the effectors whose box its cell overlaps.
+  // Effectors are numbered in the order they are added, which is the order they must act in, and
+  // the candidates of each cell are kept in that order.
+  class particle_effector_grid
+  {
+    struct box
+    {
+      double xmin, ymin, xmax, ymax;
+    };
+    std::vector<box> boxes;
+    std::vector<std::vector<unsigned> > cells;
+    std::vector<unsigned> everywhere; // Every effector, when the boxes are not all finite
+    double x0, y0, x1, y1;
+    double cell_width, cell_height;
+    int columns, rows;
+    bool unbounded;
+
+    int column(double x) const;
+    int row(double y) const;
+
+    public:
+    particle_effector_grid();
+
+    // Forgets all effectors, keeping the storage for the next build.
+    void clear();
+    // Adds the next effector. An empty box, with xmin >= xmax or ymin >= ymax, contains no point.
+    void add(double xmin, double ymin, double xmax, double ymax);
+    // Files the effectors added since clear into the grid.
+    void build();
+
+    // The effectors whose box may contain the given point, in the order they were added.
+    const std::vector<unsigned>& candidates(double x, double y) const;
+  };
+}
+
+#endif // ENIGMA_PS_PARTICLEEFFECTORS
@@ -29,6 +29,8 @@
 #define ENIGMA_PS_PARTICLEINSTANCE
 
 #include "PS_particle_type.h"
+#include <cstddef>
+#include <vector>
 
 namespace enigma
 {
@@ -49,6 +51,124 @@ namespace enigma
     double speed_wiggle_offset; // [-1;1].
     double dir_wiggle_offset; // [-1;1].
   };
+
+  // The particles of a system, stored as one array per field of particle_instance so that each
+  // pass of the update only streams through the fields it uses.
+  struct particle_store
+  {
+    std::vector<particle_type*> pt;
+
+    std::vector<int> sprite_subimageindex_initial;
+    std::vector<double> size;
+    std::vector<double> size_wiggle_offset;
+    std::vector<double> angle;
+    std::vector<double> ang_wiggle_offset;
+    std::vector<int> color;
+    std::vector<int> alpha;
+    std::vector<int> life_current, life_start;
+    std::vector<double> x, y;
+    std::vector<double> speed, direction;
+    std::vector<double> speed_wiggle_offset;
+    std::vector<double> dir_wiggle_offset;
+
+    size_t count() const { return pt.size(); }
+    bool empty() const { return pt.empty(); }
+
+    void push_back(const particle_instance& pi)
+    {
+      pt.push_back(pi.pt);
+      sprite_subimageindex_initial.push_back(pi.sprite_subimageindex_initial);
+      size.push_back(pi.size);
+      size_wiggle_offset.push_back(pi.size_wiggle_offset);
+      angle.push_back(pi.angle);
+      ang_wiggle_offset.push_back(pi.ang_wiggle_offset);
+      color.push_back(pi.color);
+      alpha.push_back(pi.alpha);
+      life_current.push_back(pi.life_current);
+      life_start.push_back(pi.life_start);
+      x.push_back(pi.x);
+      y.push_back(pi.y);
+      speed.push_back(pi.speed);
+      direction.push_back(pi.direction);
+      speed_wiggle_offset.push_back(pi.speed_wiggle_offset);
+      dir_wiggle_offset.push_back(pi.dir_wiggle_offset);
+    }
+    particle_instance get(size_t i) const
+    {
+      particle_instance pi;
+      pi.pt = pt[i];
+      pi.sprite_subimageindex_initial = sprite_subimageindex_initial[i];
+      pi.size = size[i];
+      pi.size_wiggle_offset = size_wiggle_offset[i];
+      pi.angle = angle[i];
+      pi.ang_wiggle_offset = ang_wiggle_offset[i];
+      pi.color = color[i];
+      pi.alpha = alpha[i];
+      pi.life_current = life_current[i];
+      pi.life_start = life_start[i];
+      pi.x = x[i];
+      pi.y = y[i];
+      pi.speed = speed[i];
+      pi.direction = direction[i];
+      pi.speed_wiggle_offset = speed_wiggle_offset[i];
+      pi.dir_wiggle_offset = dir_wiggle_offset[i];
+      return pi;
+    }
+    // Copies particle from over particle to, for compacting the store.
+    void move(size_t from, size_t to)
+    {
+      pt[to] = pt[from];
+      sprite_subimageindex_initial[to] = sprite_subimageindex_initial[from];
+      size[to] = size[from];
+      size_wiggle_offset[to] = size_wiggle_offset[from];
+      angle[to] = angle[from];
+      ang_wiggle_offset[to] = ang_wiggle_offset[from];
+      color[to] = color[from];
+      alpha[to] = alpha[from];
+      life_current[to] = life_current[from];
+      life_start[to] = life_start[from];
+      x[to] = x[from];
+      y[to] = y[from];
+      speed[to] = speed[from];
+      direction[to] = direction[from];
+      speed_wiggle_offset[to] = speed_wiggle_offset[from];
+      dir_wiggle_offset[to] = dir_wiggle_offset[from];
+    }
+    // Keeps only the first n particles.
+    void truncate(size_t n)
+    {
+      pt.resize(n);
+      sprite_subimageindex_initial.resize(n);
+      size.resize(n);
+      size_wiggle_offset.resize(n);
+      angle.resize(n);
+      ang_wiggle_offset.resize(n);
+      color.resize(n);
+      alpha.resize(n);
+      life_current.resize(n);
+      life_start.resize(n);
+      x.resize(n);
+      y.resize(n);
+      speed.resize(n);
+      direction.resize(n);
+      speed_wiggle_offset.resize(n);
+      dir_wiggle_offset.resize(n);
+    }
+    void clear() { truncate(0); }
+    // Removes the particles with life_current <= 0, keeping the rest in order.
+    void remove_dead()
+    {
+      const size_t n = count();
+      size_t kept = 0;
+      for (size_t i = 0; i < n; i++) {
+        if (life_current[i] > 0) {
+          if (kept != i) move(i, kept);
+          kept++;
+        }
+      }
+      truncate(kept);
+    }
+  };
 }
 
 #endif // ENIGMA_PS_PARTICLEINSTANCE
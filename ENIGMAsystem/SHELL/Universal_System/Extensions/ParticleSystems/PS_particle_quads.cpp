@@ -0,0 +1,187 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2013 forthevin                                                **
+**  Copyright (C) 2026 The ENIGMA Team                                          **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#include <cmath>
+#include <algorithm>
+
+#include "PS_particle_quads.h"
+#include "PS_particle_system.h"
+#include "PS_particle_sprites.h"
+#include "Universal_System/spritestruct.h"
+#include "Universal_System/math_consts.h"
+
+namespace enigma
+{
+  void particle_quad_stream::build(const particle_store& pi_list, bool oldtonew, double wiggle, int subimage_index,
+      double x_offset, double y_offset)
+  {
+    const size_t count = pi_list.count();
+    if (vertices.size() < 4*count) {
+      if (vertices.capacity() < 4*count) {
+        growths++;
+      }
+      vertices.resize(4*count);
+    }
+    batches.clear();
+    quads = count;
+
+    for (size_t q = 0; q < count; q++)
+    {
+      const size_t i = oldtonew ? q : count - 1 - q;
+      const particle_type* pt = pi_list.pt[i];
+      double x, y;
+      double xscale, yscale;
+      double rot;
+      double width, height;
+      double pi_x_offset, pi_y_offset;
+      double tbl, tbt, tbr, tbb;
+      int texture;
+      bool blend_additive;
+      if (pt->alive) {
+        x = pi_list.x[i];
+        y = pi_list.y[i];
+        const double size = std::max(0.0, pi_list.size[i] + pt->size_wiggle*particle_system::get_wiggle_result(pi_list.size_wiggle_offset[i], wiggle));
+        xscale = pt->xscale*size;
+        yscale = pt->yscale*size;
+        double rot_degrees = pi_list.angle[i] + pt->ang_wiggle*particle_system::get_wiggle_result(pi_list.ang_wiggle_offset[i], wiggle);
+        if (pt->ang_relative) {
+          rot_degrees += pi_list.direction[i];
+        }
+        rot = rot_degrees*M_PI/180.0;
+        blend_additive = pt->blend_additive;
+
+        if (!pt->is_particle_sprite && enigma_user::sprite_exists(pt->sprite_id)) {
+          const sprite *const spr = spritestructarray[pt->sprite_id];
+          const int subimage_count = spr->subcount;
+          int subimg;
+          if (!pt->sprite_animated) {
+            subimg = pi_list.sprite_subimageindex_initial[i];
+          }
+          else if (pt->sprite_stretched) {
+            subimg = int(subimage_count*(1.0 - 1.0*pi_list.life_current[i]/pi_list.life_start[i]));
+            subimg = subimg >= subimage_count ? subimage_count - 1 : subimg;
+            subimg = subimg % subimage_count;
+          }
+          else {
+            subimg = (subimage_index + pi_list.sprite_subimageindex_initial[i]) % subimage_count;
+          }
+          const int usi = subimg % subimage_count;
+          width = spr->width;
+          height = spr->height;
+          pi_x_offset = spr->xoffset;
+          pi_y_offset = spr->yoffset;
+          tbl = spr->texrectarray[usi].left, tbt = spr->texrectarray[usi].top;
+          tbr = spr->texrectarray[usi].right, tbb = spr->texrectarray[usi].bottom;
+          texture = spr->texturearray[usi];
+        }
+        else {
+          const particle_sprite* ps = pt->is_particle_sprite ? pt->part_sprite : get_particle_sprite(pt_sh_pixel);
+          width = ps->width;
+          height = ps->height;
+          pi_x_offset = ps->width/2.0;
+          pi_y_offset = ps->height/2.0;
+          tbl = 0.0, tbt = 0.0;
+          tbr = 1.0, tbb = 1.0;
+          texture = ps->texture;
+        }
+      }
+      else {
+        const double size = std::max(0.0, pi_list.size[i]);
+        const particle_sprite* ps = get_particle_sprite(pt_sh_pixel);
+        texture = ps->texture;
+        blend_additive = false;
+
+        rot = pi_list.angle[i]*M_PI/180.0;
+
+        x = round(pi_list.x[i]), y = round(pi_list.y[i]);
+        xscale = size, yscale = size;
+        pi_x_offset = ps->width/2.0;
+        pi_y_offset = ps->height/2.0;
+        width = ps->width, height = ps->height;
+        tbl = 0, tbt = 0, tbr = 1, tbb = 1;
+      }
+
+      // Start a new batch whenever the texture or blending changes; no sorting, so the drawing order is kept.
+      if (batches.empty() || batches.back().texture != texture || batches.back().blend_additive != blend_additive) {
+        if (batches.size() == batches.capacity()) {
+          growths++;
+        }
+        const particle_batch batch = {texture, blend_additive, q, 0};
+        batches.push_back(batch);
+      }
+      batches.back().count++;
+
+      const double
+      w = width*xscale, h = height*yscale,
+      wsinrot = w*sin(rot), wcosrot = w*cos(rot);
+
+      // Particle system offset.
+      x += x_offset;
+      y += y_offset;
+
+      double ulcx = x - xscale * pi_x_offset * cos(rot) + yscale * pi_y_offset * cos(M_PI/2+rot);
+      double ulcy = y + xscale * pi_x_offset * sin(rot) - yscale * pi_y_offset * sin(M_PI/2+rot);
+      const double v1x = ulcx, v1y = ulcy;
+      const double v2x = ulcx + wcosrot, v2y = ulcy - wsinrot;
+
+      const double mpr = 3*M_PI/2 + rot;
+      ulcx += h * cos(mpr);
+      ulcy -= h * sin(mpr);
+      const double v3x = ulcx, v3y = ulcy;
+      const double v4x = ulcx + wcosrot, v4y = ulcy - wsinrot;
+
+      const int color = pi_list.color[i];
+      const float r = (color & 0x0000FF)/255.0, g = ((color & 0x00FF00) >> 8)/255.0, b = ((color & 0xFF0000) >> 16)/255.0;
+      const float a = pi_list.alpha[i]/255.0;
+
+      particle_vertex* v = &vertices[4*q];
+      const particle_vertex corners[4] = {
+        {float(v1x), float(v1y), r, g, b, a, float(tbl), float(tbt)},
+        {float(v2x), float(v2y), r, g, b, a, float(tbr), float(tbt)},
+        {float(v3x), float(v3y), r, g, b, a, float(tbl), float(tbb)},
+        {float(v4x), float(v4y), r, g, b, a, float(tbr), float(tbb)}
+      };
+      std::copy(corners, corners + 4, v);
+    }
+  }
+
+  void particle_quad_indices(std::vector<unsigned int>& indices, size_t quads)
+  {
+    for (size_t q = indices.size()/6; q < quads; q++)
+    {
+      const unsigned int i4 = q*4;
+      indices.push_back(i4 + 0);
+      indices.push_back(i4 + 1);
+      indices.push_back(i4 + 2);
+      indices.push_back(i4 + 1);
+      indices.push_back(i4 + 2);
+      indices.push_back(i4 + 3);
+    }
+  }
+}
+
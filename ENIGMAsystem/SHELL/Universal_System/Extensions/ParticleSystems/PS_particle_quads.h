@@ -0,0 +1,74 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2026 The ENIGMA Team                                          **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#ifndef ENIGMA_PS_PARTICLEQUADS
+#define ENIGMA_PS_PARTICLEQUADS
+
+#include "PS_particle_instance.h"
+#include <cstddef>
+#include <vector>
+
+namespace enigma
+{
+  // A corner of a particle's quad, laid out as the vertex buffer of the shader based bridges reads it.
+  struct particle_vertex
+  {
+    float x, y;
+    float r, g, b, a;
+    float u, v;
+  };
+
+  // A run of consecutive quads drawn with the same texture and blending.
+  struct particle_batch
+  {
+    int texture;
+    bool blend_additive;
+    size_t first, count; // In quads.
+  };
+
+  // The quads of a particle system in drawing order, four vertices each, split into batches.
+  // Storage only ever grows, so after the first few frames building the stream allocates nothing.
+  struct particle_quad_stream
+  {
+    std::vector<particle_vertex> vertices; // Only the first 4*quads are in use.
+    std::vector<particle_batch> batches;
+    size_t quads;
+    size_t growths; // Number of times the vertex or batch storage had to grow.
+
+    particle_quad_stream(): quads(0), growths(0) {}
+
+    void build(const particle_store& pi_list, bool oldtonew, double wiggle, int subimage_index,
+        double x_offset, double y_offset);
+  };
+
+  // Fills indices with two triangles for each of the given number of quads, the four vertices of
+  // quad q being 4*q to 4*q + 3. Quads already indexed are kept, so the indices only need
+  // uploading again when the count grows.
+  void particle_quad_indices(std::vector<unsigned int>& indices, size_t quads);
+}
+
+#endif // ENIGMA_PS_PARTICLEQUADS
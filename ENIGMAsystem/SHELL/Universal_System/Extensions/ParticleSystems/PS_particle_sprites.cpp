@@ -960,9 +960,9 @@ namespace enigma
     sprite_new_empty(sprid, 1, ps->width, ps->height, ps->width/2.0, ps->height/2.0, 0, ps->height, 0, ps->width, true, false);
 
     sprite* sprstr = enigma::spritestructarray[sprid];
+    const enigma::texture_rect tr = {0, 0, 1.0, 1.0}; // Assumes multiple of 2.
     sprstr->texturearray.push_back(ps->texture);
-    sprstr->texbordxarray.push_back(1.0); // Assumes multiple of 2.
-    sprstr->texbordyarray.push_back(1.0); // Assumes multiple of 2.
+    sprstr->texrectarray.push_back(tr);
     sprstr->colldata.push_back(get_collision_mask(sprstr,0,ct_bbox));
 
     shape_to_actual_sprite.insert(std::pair<pt_shape,int>(particle_shape,sprid));
@@ -29,6 +29,7 @@
 #include <cstdlib>
 #include <vector>
 #include <algorithm>
+#include <set>
 #include <floatcomp.h>
 
 #include "PS_particle.h"
@@ -48,6 +49,7 @@ inline int bounds(int value, int low, int high)
 
 #include "PS_particle_instance.h"
 #include "PS_particle_sprites.h"
+#include "PS_particle_workers.h"
 
 using enigma::pt_manager;
 
@@ -79,7 +81,7 @@ namespace enigma
     oldtonew = true;
     auto_update = true, auto_draw = true;
     depth = 0.0;
-    pi_list = std::vector<particle_instance>();
+    pi_list = particle_store();
     id_to_emitter = std::map<int,particle_emitter*>();
     emitter_max_id = 0;
     id_to_attractor = std::map<int,particle_attractor*>();
@@ -93,8 +95,246 @@ namespace enigma
     hidden = false;
   }
 
-  static inline bool is_dead_from_old_age(particle_instance& pi) {
-    return pi.life_current <= 0;
+  // Shape, color and blending, and motion of the particles [begin, end) of a system.
+  static void update_particles_range(size_t begin, size_t end, void* data)
+  {
+    particle_system* ps = (particle_system*)data;
+    particle_store& pi_list = ps->pi_list;
+    for (size_t i = begin; i < end; i++)
+    {
+      particle_type* pt = pi_list.pt[i];
+      const int life_current = pi_list.life_current[i], life_start = pi_list.life_start[i];
+
+      // Shape.
+      if (pt->alive) {
+        pi_list.size[i] = std::max(pi_list.size[i] + pt->size_incr, 0.0);
+        pi_list.angle[i] = fmod(pi_list.angle[i] + pt->ang_incr, 360.0);
+      }
+
+      // Color.
+      switch(pt->c_mode) {
+      default:
+      case one_color : {break;}
+      case two_color : {
+        if (pt->alive) {
+          const int r1 = color_get_red(pt->color1),
+              g1 = color_get_green(pt->color1),
+              b1 = color_get_blue(pt->color1);
+          const int r2 = color_get_red(pt->color2),
+              g2 = color_get_green(pt->color2),
+              b2 = color_get_blue(pt->color2);
+          const double part = 1.0 - 1.0*life_current/life_start;
+          pi_list.color[i] = make_color_rgb(int((1-part)*r1 + part*r2),int((1-part)*g1 + part*g2),int((1-part)*b1 + part*b2));
+        }
+        break;
+      }
+      case three_color : {
+        if (pt->alive) {
+          double part = 1.0 - 1.0*life_current/life_start;
+          int first_color, second_color;
+          if (part <= 0.5) {
+            part = 2.0*part;
+            first_color = pt->color1;
+            second_color = pt->color2;
+          }
+          else {
+            part = 2.0*(part - 0.5);
+            first_color = pt->color2;
+            second_color = pt->color3;
+          }
+          const int r1 = color_get_red(first_color),
+              g1 = color_get_green(first_color),
+              b1 = color_get_blue(first_color);
+          const int r2 = color_get_red(second_color),
+              g2 = color_get_green(second_color),
+              b2 = color_get_blue(second_color);
+          pi_list.color[i] = make_color_rgb(int((1-part)*r1 + part*r2),int((1-part)*g1 + part*g2),int((1-part)*b1 + part*b2));
+        }
+        break;
+      }
+      case mix_color : {break;}
+      case rgb_color : {break;}
+      case hsv_color : {break;}
+      }
+      // Alpha.
+      switch(pt->a_mode) {
+      default:
+      case one_alpha : {break;}
+      case two_alpha : {
+        if (pt->alive) {
+          const int alpha1 = pt->alpha1;
+          const int alpha2 = pt->alpha2;
+          const double part = 1.0 - 1.0*life_current/life_start;
+          pi_list.alpha[i] = bounds(int((1-part)*alpha1 + part*alpha2), 0, 255);
+        }
+        break;
+      }
+      case three_alpha : {
+        if (pt->alive) {
+          const int alpha1 = pt->alpha1;
+          const int alpha2 = pt->alpha2;
+          const int alpha3 = pt->alpha3;
+          double part = 1.0 - 1.0*life_current/life_start;
+          int first_alpha, second_alpha;
+          if (part <= 0.5) {
+            part = 2.0*part;
+            first_alpha = alpha1;
+            second_alpha = alpha2;
+          }
+          else {
+            part = 2.0*(part - 0.5);
+            first_alpha = alpha2;
+            second_alpha = alpha3;
+          }
+          pi_list.alpha[i] = bounds(int((1-part)*first_alpha + part*second_alpha), 0, 255);
+        }
+        break;
+      }
+      }
+
+      // Move particle.
+      if (pt->alive) {
+        double& p_speed = pi_list.speed[i];
+        double& p_direction = pi_list.direction[i];
+        p_speed += pt->speed_incr;
+        p_direction += pt->dir_incr;
+        if (p_speed < 0) {
+          p_speed = -p_speed;
+          p_direction += 180.0;
+        }
+        p_direction = fmod(p_direction, 360.0);
+        const double speed = p_speed, direction = p_direction;
+        const double grav_amount = pt->grav_amount, grav_dir = pt->grav_dir;
+        const double vx = speed*cos(direction*M_PI/180.0) + grav_amount*cos(grav_dir*M_PI/180.0);
+        const double vy = -(speed*sin(direction*M_PI/180.0) + grav_amount*sin(grav_dir*M_PI/180.0));
+        p_speed = sqrt(vx*vx + vy*vy);
+        p_direction = fzero(vx) && fzero(vy) ? direction : -atan2(vy,vx)*180.0/M_PI;
+      }
+      double speed = pi_list.speed[i], direction = pi_list.direction[i];
+      if (pt->alive) {
+        speed += pt->speed_wiggle*ps->get_wiggle_result(pi_list.speed_wiggle_offset[i]);
+        direction += pt->dir_wiggle*ps->get_wiggle_result(pi_list.dir_wiggle_offset[i]);
+      }
+      pi_list.x[i] += speed*cos(direction*M_PI/180.0);
+      pi_list.y[i] += -speed*sin(direction*M_PI/180.0);
+    }
+  }
+
+  // The particles of a system along with the attractors or deflectors acting on them.
+  template <typename effector>
+  struct effector_range_job
+  {
+    particle_store* pi_list;
+    const std::vector<effector*>* effectors;
+    const particle_effector_grid* grid;
+  };
+
+  static void attract_particles_range(size_t begin, size_t end, void* data)
+  {
+    const effector_range_job<particle_attractor>& job = *(effector_range_job<particle_attractor>*)data;
+    particle_store& pi_list = *job.pi_list;
+    for (size_t i = begin; i < end; i++)
+    {
+      const std::vector<unsigned>* candidates = &job.grid->candidates(pi_list.x[i], pi_list.y[i]);
+      size_t c = 0;
+      while (c < candidates->size())
+      {
+        const unsigned k = (*candidates)[c++];
+        particle_attractor* p_a = (*job.effectors)[k];
+        // If the particle is not inside the attractor range of influence,
+        // or is at the attractor's exact position,
+        // skip to the next attractor.
+        const double dx = pi_list.x[i] - p_a->x;
+        const double dy = pi_list.y[i] - p_a->y;
+        const double relative_distance = sqrt(dx*dx + dy*dy)/std::max(1.0, p_a->dist_effect);
+        if (relative_distance > 1.0 || (fzero(dx) && fzero(dy))) {
+          continue;
+        }
+        const double direction_radians = atan2(-(p_a->y - pi_list.y[i]), p_a->x - pi_list.x[i]);
+        // Determine force.
+        double force_effective_strength;
+        switch (p_a->force_kind)  {
+        case ps_fo_constant : force_effective_strength = p_a->force_strength; break;
+        case ps_fo_linear : force_effective_strength = (1.0 - relative_distance)*p_a->force_strength; break;
+        case ps_fo_quadratic : force_effective_strength = (1.0 - relative_distance)*(1.0 - relative_distance)*p_a->force_strength; break;
+        default : force_effective_strength = p_a->force_strength; break;
+        }
+        // Apply force.
+        if (p_a->additive) {
+          const double vx = pi_list.speed[i]*cos(pi_list.direction[i]*M_PI/180.0) + force_effective_strength*cos(direction_radians);
+          const double vy = -pi_list.speed[i]*sin(pi_list.direction[i]*M_PI/180.0) - force_effective_strength*sin(direction_radians);
+          pi_list.speed[i] = sqrt(vx*vx + vy*vy);
+          const double direction = pi_list.direction[i];
+          pi_list.direction[i] = fzero(vx) && fzero(vy) ? direction : -atan2(vy,vx)*180.0/M_PI;
+        }
+        else {
+          pi_list.x[i] += force_effective_strength*cos(direction_radians);
+          pi_list.y[i] += -force_effective_strength*sin(direction_radians);
+          // Carry on with the later attractors near where the particle now is.
+          candidates = &job.grid->candidates(pi_list.x[i], pi_list.y[i]);
+          c = std::upper_bound(candidates->begin(), candidates->end(), k) - candidates->begin();
+        }
+      }
+    }
+  }
+
+  static void deflect_particles_range(size_t begin, size_t end, void* data)
+  {
+    const effector_range_job<particle_deflector>& job = *(effector_range_job<particle_deflector>*)data;
+    particle_store& pi_list = *job.pi_list;
+    for (size_t i = begin; i < end; i++)
+    {
+      const std::vector<unsigned>* candidates = &job.grid->candidates(pi_list.x[i], pi_list.y[i]);
+      size_t c = 0;
+      while (c < candidates->size())
+      {
+        const unsigned k = (*candidates)[c++];
+        particle_deflector* p_df = (*job.effectors)[k];
+        if (p_df->is_inside(pi_list.x[i], pi_list.y[i])) {
+          double& direction = pi_list.direction[i];
+          // Direction changing.
+          direction = fmod(direction + 360.0, 360.0);
+          switch (p_df->deflection_kind) {
+          case ps_de_horizontal : {
+            direction = direction <= 180.0 ? 180.0 - direction : 540.0 - direction;
+            break;
+          }
+          case ps_de_vertical : {
+            direction = 360.0 - direction;
+            break;
+          }
+          default : {
+            break;
+          }
+          }
+          // Friction handling.
+          const double new_speed = std::max(0.0, pi_list.speed[i] - p_df->friction);
+          const double friction_effect = pi_list.speed[i] - new_speed;
+          pi_list.speed[i] = new_speed;
+          // Move one step.
+          pi_list.x[i] += friction_effect*cos(direction*M_PI/180.0);
+          pi_list.y[i] += -friction_effect*sin(direction*M_PI/180.0);
+          // Carry on with the later deflectors near where the particle now is.
+          candidates = &job.grid->candidates(pi_list.x[i], pi_list.y[i]);
+          c = std::upper_bound(candidates->begin(), candidates->end(), k) - candidates->begin();
+        }
+      }
+    }
+  }
+
+  // The first of the changers from the given one on that changes particle i, or changers.size() if none do.
+  static unsigned first_changer(const std::vector<particle_changer*>& changers, const particle_effector_grid& grid,
+      const particle_store& pi_list, size_t i, unsigned from)
+  {
+    const std::vector<unsigned>& candidates = grid.candidates(pi_list.x[i], pi_list.y[i]);
+    for (std::vector<unsigned>::const_iterator it = std::lower_bound(candidates.begin(), candidates.end(), from); it != candidates.end(); it++)
+    {
+      particle_changer* p_ch = changers[*it];
+      if (pi_list.pt[i]->id == p_ch->parttypeid1 && p_ch->is_inside(pi_list.x[i], pi_list.y[i])) {
+        return *it;
+      }
+    }
+    return changers.size();
   }
 
   void particle_system::update_particlesystem()
@@ -108,22 +348,28 @@ namespace enigma
     subimage_index++;
 
     std::vector<generation_info> particles_to_generate;
-    // Handle life and death.
+    // Particles generated by the step of the survivors, which are created after those generated upon death.
+    std::vector<generation_info> step_particles_to_generate;
+    // Life and death, and generation each step.
+    // Dead particles are dropped by moving each survivor down over them. This pass counts and
+    // deletes particle types, which all systems share, so it stays on the game thread.
     {
-      for (std::vector<particle_instance>::iterator it = pi_list.begin(); it != pi_list.end(); it++)
+      const size_t count = pi_list.count();
+      size_t kept = 0;
+      for (size_t j = 0; j < count; j++)
       {
-        // Decrease life.
-        it->life_current--;
-        if (it->life_current <= 0) { // Death.
-          particle_type* pt = it->pt;
+        particle_type* pt = pi_list.pt[j];
 
+        // Decrease life.
+        pi_list.life_current[j]--;
+        if (pi_list.life_current[j] <= 0) { // Death.
           // Generated upon end of life.
           if (pt->alive && pt->death_on) {
             std::map<int,particle_type*>::iterator death_pt_it = pt_manager.id_to_particletype.find(pt->death_particle_id);
             if (death_pt_it != pt_manager.id_to_particletype.end()) {
               generation_info gen_info;
-              gen_info.x = it->x;
-              gen_info.y = it->y;
+              gen_info.x = pi_list.x[j];
+              gen_info.y = pi_list.y[j];
               gen_info.number = pt->death_number;
               gen_info.pt = (*death_pt_it).second;
               particles_to_generate.push_back(gen_info);
@@ -131,7 +377,7 @@ namespace enigma
           }
 
           // Death handling.
-          // Only the clean-up is made here.
+          // Only the clean-up is made here. The particle is dropped by not keeping it.
           pt->particle_count--;
           if (pt->particle_count <= 0 && !pt->alive) {
             // Particle type is no longer used, delete it.
@@ -139,209 +385,100 @@ namespace enigma
             delete pt;
             enigma::pt_manager.id_to_particletype.erase(pid);
           }
+          continue;
         }
-      }
-      pi_list.erase(std::remove_if(pi_list.begin(), pi_list.end(), is_dead_from_old_age), pi_list.end());
-    }
-    // Shape.
-    {
-      std::vector<particle_instance>::iterator end = pi_list.end();
-      for (std::vector<particle_instance>::iterator it = pi_list.begin(); it !=end; it++)
-      {
-        particle_type* pt = it->pt;
-        if (pt->alive) {
-          it->size = std::max(it->size + pt->size_incr, 0.0);
-          it->angle = fmod(it->angle + pt->ang_incr, 360.0);
-        }
-      }
-    }
-    // Color and blending.
-    {
-      std::vector<particle_instance>::iterator end = pi_list.end();
-      for (std::vector<particle_instance>::iterator it = pi_list.begin(); it !=end; it++)
-      {
-        particle_type* pt = it->pt;
-        // Color.
-        switch(pt->c_mode) {
-        default:
-        case one_color : {break;}
-        case two_color : {
-          if (pt->alive) {
-            const int r1 = color_get_red(pt->color1),
-                g1 = color_get_green(pt->color1),
-                b1 = color_get_blue(pt->color1);
-            const int r2 = color_get_red(pt->color2),
-                g2 = color_get_green(pt->color2),
-                b2 = color_get_blue(pt->color2);
-            const double part = 1.0 - 1.0*it->life_current/it->life_start;
-            it->color = make_color_rgb(int((1-part)*r1 + part*r2),int((1-part)*g1 + part*g2),int((1-part)*b1 + part*b2));
-          }
-          break;
-        }
-        case three_color : {
-          if (pt->alive) {
-            double part = 1.0 - 1.0*it->life_current/it->life_start;
-            int first_color, second_color;
-            if (part <= 0.5) {
-              part = 2.0*part;
-              first_color = pt->color1;
-              second_color = pt->color2;
-            }
-            else {
-              part = 2.0*(part - 0.5);
-              first_color = pt->color2;
-              second_color = pt->color3;
-            }
-            const int r1 = color_get_red(first_color),
-                g1 = color_get_green(first_color),
-                b1 = color_get_blue(first_color);
-            const int r2 = color_get_red(second_color),
-                g2 = color_get_green(second_color),
-                b2 = color_get_blue(second_color);
-            it->color = make_color_rgb(int((1-part)*r1 + part*r2),int((1-part)*g1 + part*g2),int((1-part)*b1 + part*b2));
-          }
-          break;
-        }
-        case mix_color : {break;}
-        case rgb_color : {break;}
-        case hsv_color : {break;}
-        }
-        // Alpha.
-        switch(pt->a_mode) {
-        default:
-        case one_alpha : {break;}
-        case two_alpha : {
-          if (pt->alive) {
-            const int alpha1 = pt->alpha1;
-            const int alpha2 = pt->alpha2;
-            const double part = 1.0 - 1.0*it->life_current/it->life_start;
-            it->alpha = bounds(int((1-part)*alpha1 + part*alpha2), 0, 255);
-          }
-          break;
-        }
-        case three_alpha : {
-          if (pt->alive) {
-            const int alpha1 = pt->alpha1;
-            const int alpha2 = pt->alpha2;
-            const int alpha3 = pt->alpha3;
-            double part = 1.0 - 1.0*it->life_current/it->life_start;
-            int first_alpha, second_alpha;
-            if (part <= 0.5) {
-              part = 2.0*part;
-              first_alpha = alpha1;
-              second_alpha = alpha2;
-            }
-            else {
-              part = 2.0*(part - 0.5);
-              first_alpha = alpha2;
-              second_alpha = alpha3;
-            }
-            it->alpha = bounds(int((1-part)*first_alpha + part*second_alpha), 0, 255);
-          }
-          break;
-        }
+        if (kept != j) {
+          pi_list.move(j, kept);
         }
-      }
-    }
-    // Step.
-    {
-      for (std::vector<particle_instance>::iterator it = pi_list.begin(); it != pi_list.end(); it++)
-      {
-        particle_type* pt = it->pt;
+        const size_t i = kept++;
 
-        // Generated each step.
+        // Generated each step, from where the particle is before it moves.
         if (pt->alive && pt->step_on) {
           std::map<int,particle_type*>::iterator step_pt_it = pt_manager.id_to_particletype.find(pt->step_particle_id);
           if (step_pt_it != pt_manager.id_to_particletype.end()) {
             generation_info gen_info;
-            gen_info.x = it->x;
-            gen_info.y = it->y;
+            gen_info.x = pi_list.x[i];
+            gen_info.y = pi_list.y[i];
             gen_info.number = pt->step_number;
             gen_info.pt = (*step_pt_it).second;
-            particles_to_generate.push_back(gen_info);
+            step_particles_to_generate.push_back(gen_info);
           }
         }
       }
+      pi_list.truncate(kept);
+      particles_to_generate.insert(particles_to_generate.end(), step_particles_to_generate.begin(), step_particles_to_generate.end());
     }
-    // Move particles.
-    {
-      std::vector<particle_instance>::iterator end = pi_list.end();
-      for (std::vector<particle_instance>::iterator it = pi_list.begin(); it !=end; it++)
-      {
-        particle_type* pt = it->pt;
-        if (pt->alive) {
-          it->speed += pt->speed_incr;
-          it->direction += pt->dir_incr;
-          if (it->speed < 0) {
-            it->speed = -it->speed;
-            it->direction += 180.0;
-          }
-          it->direction = fmod(it->direction, 360.0);
-          const double speed = it->speed, direction = it->direction;
-          const double grav_amount = pt->grav_amount, grav_dir = pt->grav_dir;
-          const double vx = speed*cos(direction*M_PI/180.0) + grav_amount*cos(grav_dir*M_PI/180.0);
-          const double vy = -(speed*sin(direction*M_PI/180.0) + grav_amount*sin(grav_dir*M_PI/180.0));
-          it->speed = sqrt(vx*vx + vy*vy);
-          it->direction = fzero(vx) && fzero(vy) ? direction : -atan2(vy,vx)*180.0/M_PI;
-        }
-        double speed = it->speed, direction = it->direction;
-        if (pt->alive) {
-          speed += pt->speed_wiggle*get_wiggle_result(it->speed_wiggle_offset);
-          direction += pt->dir_wiggle*get_wiggle_result(it->dir_wiggle_offset);
-        }
-        it->x += speed*cos(direction*M_PI/180.0);
-        it->y += -speed*sin(direction*M_PI/180.0);
-      }
-    }
+    // Shape, color and blending, and motion.
+    // These only depend on the particle itself and its type, so they are split between the update threads.
+    particle_parallel_for(pi_list.count(), update_particles_range, this);
     // Changers.
-    {
+    // Each particle is changed by the first changer, in order, whose region holds it and whose first type is its own.
+    // The changes are made changer by changer, as the types they delete can make later changers do nothing.
+    if (!id_to_changer.empty()) {
+      std::vector<particle_changer*> changers;
+      changer_grid.clear();
       std::map<int,particle_changer*>::iterator end1 = id_to_changer.end();
       for (std::map<int,particle_changer*>::iterator ch_it = id_to_changer.begin(); ch_it != end1; ch_it++)
       {
         particle_changer* p_ch = (*ch_it).second;
-        particle_type* pt1;
-        particle_type* pt2;
-        std::map<int,enigma::particle_type*>::iterator pt_it1 = enigma::pt_manager.id_to_particletype.find(p_ch->parttypeid1);
-        if (pt_it1 == enigma::pt_manager.id_to_particletype.end()) {
-          continue;
+        changers.push_back(p_ch);
+        changer_grid.add(p_ch->xmin, p_ch->ymin, p_ch->xmax, p_ch->ymax);
+      }
+      changer_grid.build();
+
+      // Pairs of changer and particle, in the order the changes are made.
+      std::set<std::pair<unsigned,size_t> > changes;
+      const size_t count = pi_list.count();
+      for (size_t i = 0; i < count; i++)
+      {
+        const unsigned k = first_changer(changers, changer_grid, pi_list, i, 0);
+        if (k < changers.size()) {
+          changes.insert(std::make_pair(k, i));
         }
+      }
+      while (!changes.empty())
+      {
+        const unsigned k = changes.begin()->first;
+        const size_t i = changes.begin()->second;
+        changes.erase(changes.begin());
+        particle_changer* p_ch = changers[k];
+        std::map<int,enigma::particle_type*>::iterator pt_it1 = enigma::pt_manager.id_to_particletype.find(p_ch->parttypeid1);
         std::map<int,enigma::particle_type*>::iterator pt_it2 = enigma::pt_manager.id_to_particletype.find(p_ch->parttypeid2);
-        if (pt_it2 == enigma::pt_manager.id_to_particletype.end()) {
+        if (pt_it1 == enigma::pt_manager.id_to_particletype.end() || pt_it2 == enigma::pt_manager.id_to_particletype.end()) {
+          // The changer does nothing, so the particle is left to the changers after it.
+          const unsigned next = first_changer(changers, changer_grid, pi_list, i, k + 1);
+          if (next < changers.size()) {
+            changes.insert(std::make_pair(next, i));
+          }
           continue;
         }
-        pt1 = (*pt_it1).second;
-        pt2 = (*pt_it2).second;
+        particle_type* pt1 = (*pt_it1).second;
+        particle_type* pt2 = (*pt_it2).second;
 
-        std::vector<particle_instance>::iterator end2 = pi_list.end();
-        for (std::vector<particle_instance>::iterator it = pi_list.begin(); it != end2; it++)
-        {
-          if (p_ch->is_inside(it->x, it->y) && it->pt->id == pt1->id && it->life_current > 0) { // Skip particles with life_current <= 0.
-            // Store position of old particle.
-            const double x = it->x, y = it->y;
-            // Destroy the old particle.
-            // Only the clean-up is made here. The actual removal is handle after the loops by remove_if and erase.
-            pt1->particle_count--;
-            if (pt1->particle_count <= 0 && !pt1->alive) {
-              // Particle type is no longer used, delete it.
-              int pid = pt1->id;
-              delete pt1;
-              enigma::pt_manager.id_to_particletype.erase(pid);
-            }
-            // Internally when handling changers, setting life_current to 0 indicates that the particle has been removed.
-            it->life_current = 0;
-            // Create a new particle at its position.
-            generation_info gen_info;
-            gen_info.x = x;
-            gen_info.y = y;
-            gen_info.number = 1;
-            gen_info.pt = pt2;
-            particles_to_generate.push_back(gen_info);
-          }
+        // Store position of old particle.
+        const double x = pi_list.x[i], y = pi_list.y[i];
+        // Destroy the old particle.
+        // Only the clean-up is made here. The actual removal is handled after the loops by remove_dead.
+        pt1->particle_count--;
+        if (pt1->particle_count <= 0 && !pt1->alive) {
+          // Particle type is no longer used, delete it.
+          int pid = pt1->id;
+          delete pt1;
+          enigma::pt_manager.id_to_particletype.erase(pid);
         }
+        // Internally when handling changers, setting life_current to 0 indicates that the particle has been removed.
+        pi_list.life_current[i] = 0;
+        // Create a new particle at its position.
+        generation_info gen_info;
+        gen_info.x = x;
+        gen_info.y = y;
+        gen_info.number = 1;
+        gen_info.pt = pt2;
+        particles_to_generate.push_back(gen_info);
       }
-      // Erase all particles with life_current <= 0.
-      pi_list.erase(std::remove_if(pi_list.begin(), pi_list.end(), is_dead_from_old_age), pi_list.end());
     }
+    // Erase all particles with life_current <= 0.
+    pi_list.remove_dead();
     // Generate particles.
     for (std::vector<generation_info>::iterator it = particles_to_generate.begin(); it != particles_to_generate.end(); it++)
     {
@@ -372,61 +509,50 @@ namespace enigma
       }
     }
     // Attractors.
-    {
+    // Each particle is pulled by the attractors in turn, independently of the other particles.
+    if (!id_to_attractor.empty()) {
+      std::vector<particle_attractor*> attractors;
+      attractor_grid.clear();
       std::map<int,particle_attractor*>::iterator end = id_to_attractor.end();
       for (std::map<int,particle_attractor*>::iterator at_it = id_to_attractor.begin(); at_it != end; at_it++)
       {
         particle_attractor* p_a = (*at_it).second;
-        std::vector<particle_instance>::iterator end1 = pi_list.end();
-        for (std::vector<particle_instance>::iterator it = pi_list.begin(); it != end1; it++)
-        {
-          // If the particle is not inside the attractor range of influence,
-          // or is at the attractor's exact position,
-          // skip to next attractor.
-          const double dx = it->x - p_a->x;
-          const double dy = it->y - p_a->y;
-          const double relative_distance = sqrt(dx*dx + dy*dy)/std::max(1.0, p_a->dist_effect);
-          if (relative_distance > 1.0 || (fzero(dx) && fzero(dy))) {
-            continue;
-          }
-          const double direction_radians = atan2(-(p_a->y - it->y), p_a->x - it->x);
-          // Determine force.
-          double force_effective_strength;
-          switch (p_a->force_kind)  {
-          case ps_fo_constant : force_effective_strength = p_a->force_strength; break;
-          case ps_fo_linear : force_effective_strength = (1.0 - relative_distance)*p_a->force_strength; break;
-          case ps_fo_quadratic : force_effective_strength = (1.0 - relative_distance)*(1.0 - relative_distance)*p_a->force_strength; break;
-          default : force_effective_strength = p_a->force_strength; break;
-          }
-          // Apply force.
-          if (p_a->additive) {
-            const double vx = it->speed*cos(it->direction*M_PI/180.0) + force_effective_strength*cos(direction_radians);
-            const double vy = -it->speed*sin(it->direction*M_PI/180.0) - force_effective_strength*sin(direction_radians);
-            it->speed = sqrt(vx*vx + vy*vy);
-            const double direction = it->direction;
-            it->direction = fzero(vx) && fzero(vy) ? direction : -atan2(vy,vx)*180.0/M_PI;
-          }
-          else {
-            it->x += force_effective_strength*cos(direction_radians);
-            it->y += -force_effective_strength*sin(direction_radians);
-          }
-        }
+        attractors.push_back(p_a);
+        // Widened a little, so that rounding in the distance test cannot reach outside.
+        const double reach = std::max(1.0, p_a->dist_effect)*(1.0 + 1e-9) + 1e-9*(fabs(p_a->x) + fabs(p_a->y));
+        attractor_grid.add(p_a->x - reach, p_a->y - reach, p_a->x + reach, p_a->y + reach);
       }
+      attractor_grid.build();
+      effector_range_job<particle_attractor> job = { &pi_list, &attractors, &attractor_grid };
+      particle_parallel_for(pi_list.count(), attract_particles_range, &job);
     }
     // Destroyers.
-    {
+    if (!id_to_destroyer.empty()) {
+      std::vector<particle_destroyer*> destroyers;
+      destroyer_grid.clear();
       std::map<int,particle_destroyer*>::iterator end1 = id_to_destroyer.end();
       for (std::map<int,particle_destroyer*>::iterator ds_it = id_to_destroyer.begin(); ds_it != end1; ds_it++)
       {
         particle_destroyer* p_ds = (*ds_it).second;
-        std::vector<particle_instance>::iterator end2 = pi_list.end();
-        for (std::vector<particle_instance>::iterator it = pi_list.begin(); it != end2; it++)
+        destroyers.push_back(p_ds);
+        destroyer_grid.add(p_ds->xmin, p_ds->ymin, p_ds->xmax, p_ds->ymax);
+      }
+      destroyer_grid.build();
+
+      const size_t count = pi_list.count();
+      for (size_t i = 0; i < count; i++)
+      {
+        if (pi_list.life_current[i] <= 0) { // Skip particles with life_current <= 0.
+          continue;
+        }
+        const std::vector<unsigned>& candidates = destroyer_grid.candidates(pi_list.x[i], pi_list.y[i]);
+        for (size_t c = 0; c < candidates.size(); c++)
         {
-          if (p_ds->is_inside(it->x, it->y) && it->life_current > 0) { // Skip particles with life_current <= 0.
-            particle_type* pt = it->pt;
+          if (destroyers[candidates[c]]->is_inside(pi_list.x[i], pi_list.y[i])) {
+            particle_type* pt = pi_list.pt[i];
 
             // Death handling.
-            // Only the clean-up is made here. The actual removal is handle after the loops by remove_if and erase.
+            // Only the clean-up is made here. The actual removal is handled after the loops by remove_dead.
             pt->particle_count--;
             if (pt->particle_count <= 0 && !pt->alive) {
               // Particle type is no longer used, delete it.
@@ -435,48 +561,29 @@ namespace enigma
               enigma::pt_manager.id_to_particletype.erase(pid);
             }
             // Internally when handling destroyers, setting life_current to 0 indicates that the particle has been removed.
-            it->life_current = 0;
+            pi_list.life_current[i] = 0;
+            break;
           }
         }
       }
-      // Erase all particles with life_current <= 0.
-      pi_list.erase(std::remove_if(pi_list.begin(), pi_list.end(), is_dead_from_old_age), pi_list.end());
     }
+    // Erase all particles with life_current <= 0.
+    pi_list.remove_dead();
     // Deflectors.
-    {
+    // Each particle is deflected by the deflectors in turn, independently of the other particles.
+    if (!id_to_deflector.empty()) {
+      std::vector<particle_deflector*> deflectors;
+      deflector_grid.clear();
       std::map<int,particle_deflector*>::iterator end = id_to_deflector.end();
       for (std::map<int,particle_deflector*>::iterator df_it = id_to_deflector.begin(); df_it != end; df_it++)
       {
         particle_deflector* p_df = (*df_it).second;
-        std::vector<particle_instance>::iterator end2 = pi_list.end();
-        for (std::vector<particle_instance>::iterator it = pi_list.begin(); it != end2; it++)
-        {
-          if (p_df->is_inside(it->x, it->y)) {
-            // Direction changing.
-            it->direction = fmod(it->direction + 360.0, 360.0);
-            switch (p_df->deflection_kind) {
-            case ps_de_horizontal : {
-              it->direction = it->direction <= 180.0 ? 180.0 - it->direction : 540.0 - it->direction;
-              break;
-            }
-            case ps_de_vertical : {
-              it->direction = 360.0 - it->direction;
-              break;
-            }
-            default : {
-              break;
-            }
-            }
-            // Friction handling.
-            const double new_speed = std::max(0.0, it->speed - p_df->friction);
-            const double friction_effect = it->speed - new_speed;
-            it->speed = new_speed;
-            // Move one step.
-            it->x += friction_effect*cos(it->direction*M_PI/180.0);
-            it->y += -friction_effect*sin(it->direction*M_PI/180.0);
-          }
-        }
+        deflectors.push_back(p_df);
+        deflector_grid.add(p_df->xmin, p_df->ymin, p_df->xmax, p_df->ymax);
       }
+      deflector_grid.build();
+      effector_range_job<particle_deflector> job = { &pi_list, &deflectors, &deflector_grid };
+      particle_parallel_for(pi_list.count(), deflect_particles_range, &job);
     }
   }
   void particle_system::draw_particlesystem()
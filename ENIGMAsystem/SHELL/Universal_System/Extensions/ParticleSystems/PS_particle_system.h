@@ -33,6 +33,7 @@
 #include "PS_particle_destroyer.h"
 #include "PS_particle_deflector.h"
 #include "PS_particle_changer.h"
+#include "PS_particle_effectors.h"
 #include "PS_particle_instance.h"
 #include "PS_particle_enums.h"
 #include "Graphics_Systems/General/GScolors.h"
@@ -48,7 +49,7 @@ namespace enigma
     // Initialization
     void initialize_particle_bridge();
     // Drawing
-    void draw_particles(std::vector<particle_instance>& pi_list, bool oldtonew, double wiggle, int subimage_index,
+    void draw_particles(particle_store& pi_list, bool oldtonew, double wiggle, int subimage_index,
         double x_offset, double y_offset);
   }
   
@@ -66,7 +67,7 @@ namespace enigma
     bool oldtonew;
     double x_offset, y_offset;
     double depth; // Integer stored as double.
-    std::vector<particle_instance> pi_list;
+    particle_store pi_list;
     bool auto_update, auto_draw;
     void initialize();
     void update_particlesystem();
@@ -82,18 +83,22 @@ namespace enigma
     std::map<int,particle_attractor*> id_to_attractor;
     int attractor_max_id;
     int create_attractor();
+    particle_effector_grid attractor_grid; // Rebuilt each update.
     // Destroyers.
     std::map<int,particle_destroyer*> id_to_destroyer;
     int destroyer_max_id;
     int create_destroyer();
+    particle_effector_grid destroyer_grid; // Rebuilt each update.
     // Deflectors.
     std::map<int,particle_deflector*> id_to_deflector;
     int deflector_max_id;
     int create_deflector();
+    particle_effector_grid deflector_grid; // Rebuilt each update.
     // Changers.
     std::map<int,particle_changer*> id_to_changer;
     int changer_max_id;
     int create_changer();
+    particle_effector_grid changer_grid; // Rebuilt each update.
     // Protection.
     bool hidden;
   };
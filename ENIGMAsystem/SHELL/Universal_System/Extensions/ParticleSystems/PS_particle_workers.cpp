@@ -0,0 +1,197 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2026 The ENIGMA Team                                          **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64) || defined(__WIN64__)
+#include <windows.h>
+#else
+#include <pthread.h> // use POSIX threads
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#include "PS_particle.h"
+#include "PS_particle_workers.h"
+
+namespace enigma
+{
+  // Fewer particles than this per chunk are not worth handing to another thread.
+  static const size_t particle_chunk_min = 1024;
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64) || defined(__WIN64__)
+  typedef HANDLE worker_handle;
+  static CRITICAL_SECTION pool_lock;
+  static CONDITION_VARIABLE pool_wake, pool_done;
+  static void pool_init() {
+    InitializeCriticalSection(&pool_lock);
+    InitializeConditionVariable(&pool_wake);
+    InitializeConditionVariable(&pool_done);
+  }
+  static inline void pool_acquire() { EnterCriticalSection(&pool_lock); }
+  static inline void pool_release() { LeaveCriticalSection(&pool_lock); }
+  static inline void pool_wait(CONDITION_VARIABLE *cond) { SleepConditionVariableCS(cond, &pool_lock, INFINITE); }
+  static inline void pool_broadcast(CONDITION_VARIABLE *cond) { WakeAllConditionVariable(cond); }
+#else
+  typedef pthread_t worker_handle;
+  static pthread_mutex_t pool_lock;
+  static pthread_cond_t pool_wake, pool_done;
+  static void pool_init() {
+    pthread_mutex_init(&pool_lock, NULL);
+    pthread_cond_init(&pool_wake, NULL);
+    pthread_cond_init(&pool_done, NULL);
+  }
+  static inline void pool_acquire() { pthread_mutex_lock(&pool_lock); }
+  static inline void pool_release() { pthread_mutex_unlock(&pool_lock); }
+  static inline void pool_wait(pthread_cond_t *cond) { pthread_cond_wait(cond, &pool_lock); }
+  static inline void pool_broadcast(pthread_cond_t *cond) { pthread_cond_broadcast(cond); }
+#endif
+
+  static bool pool_initialized = false;
+  static std::vector<worker_handle> pool_workers;
+  static bool pool_quit = false;
+
+  // The job being run. Everything below is guarded by pool_lock.
+  static particle_range_work job_work = NULL;
+  static void* job_data = NULL;
+  static size_t job_count = 0, job_chunk = 0;
+  static size_t job_next = 0;     // Start of the next unclaimed chunk
+  static size_t job_running = 0;  // Claimed chunks not yet finished
+  static unsigned job_serial = 0; // Bumped for every job, so that sleeping workers notice a new one
+
+  // Claims and runs chunks of the current job until none are left. Called with pool_lock held.
+  static void pool_work_chunks()
+  {
+    while (job_next < job_count)
+    {
+      const size_t begin = job_next, end = std::min(job_count, begin + job_chunk);
+      job_next = end;
+      job_running++;
+      pool_release();
+      job_work(begin, end, job_data);
+      pool_acquire();
+      if (--job_running == 0 && job_next >= job_count) {
+        pool_broadcast(&pool_done);
+      }
+    }
+  }
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64) || defined(__WIN64__)
+  static DWORD WINAPI pool_worker(LPVOID)
+#else
+  static void* pool_worker(void*)
+#endif
+  {
+    pool_acquire();
+    unsigned seen = job_serial;
+    while (!pool_quit)
+    {
+      if (seen == job_serial) {
+        pool_wait(&pool_wake);
+        continue;
+      }
+      seen = job_serial;
+      pool_work_chunks();
+    }
+    pool_release();
+    return 0;
+  }
+
+  static void pool_stop()
+  {
+    pool_acquire();
+    pool_quit = true;
+    pool_broadcast(&pool_wake);
+    pool_release();
+    for (size_t i = 0; i < pool_workers.size(); i++)
+    {
+#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64) || defined(__WIN64__)
+      WaitForSingleObject(pool_workers[i], INFINITE);
+      CloseHandle(pool_workers[i]);
+#else
+      pthread_join(pool_workers[i], NULL);
+#endif
+    }
+    pool_workers.clear();
+    pool_quit = false;
+  }
+
+  static void pool_start(int count)
+  {
+    for (int i = 0; i < count; i++)
+    {
+#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64) || defined(__WIN64__)
+      const worker_handle handle = CreateThread(NULL, 0, pool_worker, NULL, 0, NULL);
+      if (handle == NULL) break;
+#else
+      worker_handle handle;
+      if (pthread_create(&handle, NULL, pool_worker, NULL)) break;
+#endif
+      pool_workers.push_back(handle);
+    }
+  }
+
+  void particle_parallel_for(size_t count, particle_range_work work, void* data)
+  {
+    const size_t threads = pool_workers.size() + 1;
+    if (threads == 1 || count < 2*particle_chunk_min) {
+      work(0, count, data);
+      return;
+    }
+    // A few chunks per thread, so that a thread held up by the scheduler does not hold up the rest.
+    const size_t chunk = std::max(particle_chunk_min, (count + 4*threads - 1)/(4*threads));
+
+    pool_acquire();
+    job_work = work;
+    job_data = data;
+    job_count = count;
+    job_chunk = chunk;
+    job_next = 0;
+    job_running = 0;
+    job_serial++;
+    pool_broadcast(&pool_wake);
+    pool_work_chunks();
+    while (job_running)
+      pool_wait(&pool_done);
+    job_work = NULL;
+    job_data = NULL;
+    pool_release();
+  }
+}
+
+namespace enigma_user
+{
+  void part_update_threads(int number)
+  {
+    if (!enigma::pool_initialized) {
+      enigma::pool_init();
+      enigma::pool_initialized = true;
+    }
+    enigma::pool_stop();
+    enigma::pool_start(number - 1);
+  }
+}
+
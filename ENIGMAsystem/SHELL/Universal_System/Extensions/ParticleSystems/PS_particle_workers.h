@@ -0,0 +1,46 @@
+/********************************************************************************\
+**                                                                              **
+**  Copyright (C) 2026 The ENIGMA Team                                          **
+**                                                                              **
+**  This file is a part of the ENIGMA Development Environment.                  **
+**                                                                              **
+**                                                                              **
+**  ENIGMA is free software: you can redistribute it and/or modify it under the **
+**  terms of the GNU General Public License as published by the Free Software   **
+**  Foundation, version 3 of the license or any later version.                  **
+**                                                                              **
+**  This application and its source code is distributed AS-IS, WITHOUT ANY      **
+**  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS   **
+**  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more       **
+**  details.                                                                    **
+**                                                                              **
+**  You should have recieved a copy of the GNU General Public License along     **
+**  with this code. If not, see <http://www.gnu.org/licenses/>                  **
+**                                                                              **
+**  ENIGMA is an environment designed to create games and other programs with a **
+**  high-level, fully compilable language. Developers of ENIGMA or anything     **
+**  associated with ENIGMA are in no way responsible for its users or           **
+**  applications created by its users, or damages caused by the environment     **
+**  or programs made in the environment.                                        **
+**                                                                              **
+\********************************************************************************/
+
+#ifndef ENIGMA_PS_PARTICLEWORKERS
+#define ENIGMA_PS_PARTICLEWORKERS
+
+#include <cstddef>
+
+namespace enigma
+{
+  // Work on particles [begin, end).
+  typedef void (*particle_range_work)(size_t begin, size_t end, void* data);
+
+  // Runs work over the particles [0, count), split into chunks shared between the game thread and
+  // the worker threads, and returns once every chunk is done. With no workers, or too few
+  // particles to be worth splitting, work is simply called once on the whole range.
+  // Chunks must touch nothing but their own particles, so that results never depend on how the
+  // particles were split or in which order the chunks ran.
+  void particle_parallel_for(size_t count, particle_range_work work, void* data);
+}
+
+#endif // ENIGMA_PS_PARTICLEWORKERS
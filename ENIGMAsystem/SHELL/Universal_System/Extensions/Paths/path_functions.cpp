@@ -231,6 +231,7 @@ void path_shift(unsigned pathid, cs_scalar xshift, cs_scalar yshift)
     enigma::path *pa = enigma::pathstructarray[pathid];
     for (vector<enigma::path_point>::iterator it = pa->pointarray.begin(); it!=pa->pointarray.end(); ++it)
         (*it).x = (*it).x + xshift, (*it).y = (*it).y + yshift;
+    enigma::path_bake(pa);
 }
 
 void path_flip(unsigned pathid)
@@ -239,6 +240,7 @@ void path_flip(unsigned pathid)
     for (size_t i=0; i<pa->pointarray.size(); i++){
         pa->pointarray[i].y = pa->centery*2-pa->pointarray[i].y;
     }
+    enigma::path_bake(pa);
 }
 
 void path_mirror(unsigned pathid)
@@ -247,6 +249,7 @@ void path_mirror(unsigned pathid)
     for (size_t i=0; i<pa->pointarray.size(); i++){
         pa->pointarray[i].x = pa->centerx*2-pa->pointarray[i].x;
     }
+    enigma::path_bake(pa);
 }
 
 void path_scale(unsigned pathid, cs_scalar xscale, cs_scalar yscale)
@@ -269,6 +272,7 @@ void path_rotate(unsigned pathid, double angle)
         pa->pointarray[i].x = tmpx*cos(a) - tmpy*sin(a) + pa->centerx;
         pa->pointarray[i].y = tmpx*sin(a) + tmpy*cos(a) + pa->centery;
     }
+    enigma::path_bake(pa);
 }
 
 cs_scalar path_get_x(unsigned pathid, double t)
@@ -392,6 +396,19 @@ void path_set_precision(unsigned pathid, int prec)
     }
 }
 
+void path_set_sample_spacing(unsigned pathid, cs_scalar spacing)
+{
+    if (enigma::pathstructarray[pathid]->sample_spacing != spacing){
+        enigma::pathstructarray[pathid]->sample_spacing = spacing;
+        enigma::path_bake(enigma::pathstructarray[pathid]);
+    }
+}
+
+cs_scalar path_get_sample_spacing(unsigned pathid)
+{
+    return enigma::pathstructarray[pathid]->sample_spacing;
+}
+
 void path_clear_points(unsigned pathid)
 {
     enigma::pathstructarray[pathid]->pointarray.clear();
@@ -451,9 +468,6 @@ void path_reverse(unsigned pathid)
 }
 
 //Declare drawing functions here, so it works no matter if GL, GLES or D3D is used
-void draw_spline_begin(int mode);
-int draw_spline_vertex(gs_scalar x, gs_scalar y);
-void draw_bezier_quadratic_spline_end();
 /*void glBegin(GLenum mode);
 void glEnd(void);
 void glVertex2f(GLfloat  x,  GLfloat  y);
@@ -471,22 +485,12 @@ void draw_path(unsigned pathid, gs_scalar x, gs_scalar y, bool absolute)
         x=0, y=0;
     else
         x=x-path->pointarray[0].x, y=y-path->pointarray[0].y;
-    if (path->smooth) //Draw using quadratic bezier splines
+    if (path->smooth) //Draw the curve through its samples
     {
-        draw_spline_begin(3);
-        if (!path->closed)
-            draw_spline_vertex(x+path->pointarray.front().x,y+path->pointarray.front().y);
-        else
-            draw_spline_vertex(x+path->pointarray.back().x,y+path->pointarray.back().y);
-
-        for (unsigned i=0; i<path->pointarray.size(); i++)
-            draw_spline_vertex(x+path->pointarray[i].x,y+path->pointarray[i].y);
-
-        if (!path->closed)
-            draw_spline_vertex(x+path->pointarray.back().x,y+path->pointarray.back().y);
-        else
-            draw_spline_vertex(x+path->pointarray.front().x,y+path->pointarray.front().y);
-        draw_bezier_quadratic_spline_end();
+        draw_primitive_begin(3);
+        for (size_t i=0; i<path->samples.size(); i++)
+            draw_vertex(x+path->samples[i].x,y+path->samples[i].y);
+        draw_primitive_end();
     }else{ //Draw using lines
         //if(enigma::bound_texture) glBindTexture(GL_TEXTURE_2D,enigma::bound_texture = 0);
         //glPushAttrib(GL_LINE_BIT);
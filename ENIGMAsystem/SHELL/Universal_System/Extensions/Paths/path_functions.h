@@ -54,6 +54,9 @@ bool path_get_closed(unsigned pathid);
 void path_set_kind(unsigned pathid, bool val);
 void path_set_closed(unsigned pathid, bool val);
 void path_set_precision(unsigned pathid, int prec);
+// Positions along a path are looked up among points this many pixels apart at most; 2 by default.
+void path_set_sample_spacing(unsigned pathid, cs_scalar spacing);
+cs_scalar path_get_sample_spacing(unsigned pathid);
 void path_clear_points(unsigned pathid);
 void path_add_point(unsigned pathid, cs_scalar x, cs_scalar y, cs_scalar speed);
 void path_insert_point(unsigned pathid, unsigned n, cs_scalar x, cs_scalar y, cs_scalar speed);
@@ -27,6 +27,7 @@
 \********************************************************************************/
 
 #include <vector>
+#include <algorithm>
 #include <math.h>
 #include <float.h> //maxiumum values for certain datatypes. Useful for minx = DBL_MAX
 #include <cstdlib> //size_t
@@ -90,7 +91,8 @@ namespace enigma
     }
 
     path::path(unsigned pathid, bool smth, bool close, int prec, unsigned pointcount):
-        id(pathid), precision(prec), smooth(smth), closed(close), pointarray(), total_length(0)
+        id(pathid), precision(prec), smooth(smth), closed(close), pointarray(), total_length(0),
+        samples(), sample_spacing(2), corners(), corner_positions()
     {
         pathstructarray[pathid] = this;
         pathstructarray[pathid]->pointarray.reserve(pointcount);
@@ -110,7 +112,7 @@ namespace enigma
         path* const pth = pathstructarray[pathid];
         if (!pth) return;
         pth->total_length = 0; pth->pointoffset.clear();
-        if (!pth->pointarray.size()) return;
+        if (!pth->pointarray.size()) { pth->samples.clear(); return; }
 
         const size_t pc = pth->pointarray.size();
         const path_point& start = pth->closed ? pth->pointarray[pc-1] : pth->pointarray[0];
@@ -151,6 +153,82 @@ namespace enigma
         }
         //std::cout << "size of pointoffset: " << pth->pointoffset.size() << std::endl;
         //for (ppi_t i = pth->pointoffset.begin(); i != pth->pointoffset.end(); i++) std::cout << i->first << "=>" << i->second << std::endl;
+        path_bake(pth);
+    }
+
+    // Most samples kept for one path, however long it is
+    static const size_t path_max_samples = 65536;
+
+    void path_bake(path *pth)
+    {
+        pth->samples.clear();
+        pth->corners.clear();
+        pth->corner_positions.clear();
+        const size_t pc = pth->pointarray.size();
+        if (!pc) return;
+        const path_point& start = pth->closed ? pth->pointarray[pc-1] : pth->pointarray[0];
+        const path_point& end  =  pth->closed ? pth->pointarray[0] : pth->pointarray[pc-1];
+
+        // Trace each segment as path_recalculate measured it, curves in twenty steps, keeping the
+        // distance covered at every step
+        const bool curved = pth->smooth && (pc > 2 || pth->closed);
+        vector<path_sample> trace;
+        vector<double> covered;
+        double length = 0;
+        for (size_t i = 0; i < pc; i++)
+        {
+          const path_point &p1 = i==0 ? start : pth->pointarray[i-1], &p2 = pth->pointarray[i],
+                           &p3 = i+1==pc ? end : pth->pointarray[i+1];
+          const int steps = curved ? 20 : 1;
+          for (int k = (i==0 ? 0 : 1); k <= steps; k++)
+          {
+            const double t = double(k) / steps;
+            path_sample smp;
+            if (curved) {
+              smp.x = 0.5 * (((p1.x - 2 * p2.x + p3.x) * t + 2 * p2.x - 2 * p1.x) * t + p1.x + p2.x);
+              smp.y = 0.5 * (((p1.y - 2 * p2.y + p3.y) * t + 2 * p2.y - 2 * p1.y) * t + p1.y + p2.y);
+            } else {
+              smp.x = p1.x + (p2.x-p1.x) * t;
+              smp.y = p1.y + (p2.y-p1.y) * t;
+            }
+            if (pth->smooth)
+              smp.speed = 0.5 * (((p1.speed - 2 * p2.speed + p3.speed) * t + 2 * p2.speed - 2 * p1.speed) * t + p1.speed + p2.speed);
+            else
+              smp.speed = p1.speed + (p2.speed-p1.speed) * t;
+            if (!trace.empty())
+              length += hypot(smp.x - trace.back().x, smp.y - trace.back().y);
+            trace.push_back(smp);
+            covered.push_back(length);
+          }
+        }
+
+        if (length <= 0 || pc == 1) {
+          pth->samples.push_back(path_sample(start.x, start.y, start.speed));
+          return;
+        }
+
+        // A straight path's trace is its corners
+        if (!curved) {
+          pth->corners = trace;
+          pth->corner_positions.reserve(covered.size());
+          for (size_t i = 0; i < covered.size(); i++)
+            pth->corner_positions.push_back(covered[i] / length);
+        }
+
+        // Resample the trace at even distances
+        const double spacing = pth->sample_spacing > 0 ? double(pth->sample_spacing) : 1;
+        const size_t count = std::min(path_max_samples - 1, size_t(ceil(length / spacing)));
+        pth->samples.reserve(count + 1);
+        size_t k = 0;
+        for (size_t i = 0; i <= count; i++)
+        {
+          const double at = length * i / count;
+          while (k + 2 < trace.size() && covered[k+1] < at) k++;
+          const double span = covered[k+1] - covered[k], t = span > 0 ? std::min(1.0, (at - covered[k]) / span) : 0;
+          pth->samples.push_back(path_sample(trace[k].x + (trace[k+1].x - trace[k].x) * t,
+                                             trace[k].y + (trace[k+1].y - trace[k].y) * t,
+                                             trace[k].speed + (trace[k+1].speed - trace[k].speed) * t, k));
+        }
     }
 
     void pathstructarray_reallocate()
@@ -168,51 +246,42 @@ namespace enigma
       return path_point_iterator_at(pth, position)->second;
     }
 
+    /// Returns the path's sample at @param position, interpolated between the nearest two,
+    /// or on a straight path, between the corners either side of it.
+    static inline path_sample path_sample_at(const path *pth, cs_scalar position)
+    {
+      const vector<path_sample> &smp = pth->samples;
+      const size_t last = smp.size() - 1;
+      if (!last || !(position > 0)) return smp[0];
+      if (position >= 1) return smp[last];
+      const double f = position * last;
+      const size_t i = size_t(f);
+      if (!pth->corners.empty()) {
+        const vector<path_sample> &c = pth->corners;
+        const vector<cs_scalar> &at = pth->corner_positions;
+        size_t k = smp[i].corner;
+        while (k + 2 < c.size() && at[k+1] < position) k++;
+        const double span = at[k+1] - at[k], t = span > 0 ? std::max(0.0, std::min(1.0, (position - at[k]) / span)) : 0;
+        return path_sample(c[k].x + (c[k+1].x - c[k].x) * t,
+                           c[k].y + (c[k+1].y - c[k].y) * t,
+                           c[k].speed + (c[k+1].speed - c[k].speed) * t);
+      }
+      const double t = f - i;
+      return path_sample(smp[i].x + (smp[i+1].x - smp[i].x) * t,
+                         smp[i].y + (smp[i+1].y - smp[i].y) * t,
+                         smp[i].speed + (smp[i+1].speed - smp[i].speed) * t);
+    }
+
     void path_getXY(path *pth, cs_scalar &x, cs_scalar &y, cs_scalar position)
     {
       if (!pth) return;
-      if (!pth->pointarray.size()) return;
+      if (!pth->samples.size()) return;
       if (position < 0)
         position = 1 - fmod(-position, 1);
       else if (position > 1)
         position = fmod(position, 1);
-      ppi_t ppi = path_point_iterator_at(pth, position);
-      double t = position - ppi->first;
-      t /= double(pth->pointarray[ppi->second].length) / pth->total_length;
-      int sid = ppi->second;
-      double x1, x2, x3, y1, y2, y3;
-      //std::cout << "t on path: " << position << " first: " << ppi->first << " second: " << ppi->second << " Sid: " << sid << " delta:" << t << std::endl;
-      const size_t pc = pth->pointarray.size();
-      const path_point& start = pth->closed ? pth->pointarray[pc-1] : pth->pointarray[0];
-      const path_point& end  =  pth->closed ? pth->pointarray[0] : pth->pointarray[pc-1];
-      if (sid==0)
-          x1=start.x, y1=start.y;
-      else
-          x1=pth->pointarray[sid-1].x, y1=pth->pointarray[sid-1].y;
-
-      x2=pth->pointarray[sid].x, y2=pth->pointarray[sid].y;
-
-        //std::cout<<pth->pointarray.size()<<std::endl;
-      if (pth->pointarray.size() == 1) {
-        x = x1, y = y1;
-        return;
-      }
-      else if (pth->pointarray.size() == 2 && fequal(x1, x2) && fequal(y1, y2)) {
-        x = x1, y = y1;
-        return;
-      }
-
-      if (pth->smooth && (pth->pointarray.size()>2 || pth->closed)) {
-        if (size_t(sid)+1 == pc)
-            x3=end.x, y3=end.y;
-        else
-            x3=pth->pointarray[sid+1].x, y3=pth->pointarray[sid+1].y;
-        x = 0.5 * (((x1 - 2 * x2 + x3) * t + 2 * x2 - 2 * x1) * t + x1 + x2);
-        y = 0.5 * (((y1 - 2 * y2 + y3) * t + 2 * y2 - 2 * y1) * t + y1 + y2);
-      } else {
-        x = x1 + (x2-x1) * t;
-        y = y1 + (y2-y1) * t;
-      }
+      const path_sample smp = path_sample_at(pth, position);
+      x = smp.x, y = smp.y;
     }
     
     void path_getXY_scaled(path *pth, cs_scalar &x, cs_scalar &y, cs_scalar position, cs_scalar scale)
@@ -225,30 +294,8 @@ namespace enigma
     void path_getspeed(path *pth, cs_scalar &speed, cs_scalar position)
     {
       if (!pth) return;
-      if (!pth->pointarray.size()) return;
-      ppi_t ppi = path_point_iterator_at(pth, position);
-      double t = position - ppi->first;
-      t /= double(pth->pointarray[ppi->second].length) / pth->total_length;
-      int sid = ppi->second;
-      double x1, x2, x3;
-      //std::cout << "t on path: " << position << " first: " << ppi->first << " Sid: " << sid << " delta:" << t << std::endl;
-      const size_t pc = pth->pointarray.size();
-      const path_point& start = pth->closed ? pth->pointarray[pc-1] : pth->pointarray[0];
-      const path_point& end  =  pth->closed ? pth->pointarray[0] : pth->pointarray[pc-1];
-      if (sid==0)
-          x1=start.speed;
-      else
-          x1=pth->pointarray[sid-1].speed;
-      x2=pth->pointarray[sid].speed;
-      if (pth->smooth){
-          if (size_t(sid)+1==pc)
-              x3=end.speed;
-          else
-              x3=pth->pointarray[sid+1].speed;
-          speed = 0.5 * (((x1 - 2 * x2 + x3) * t + 2 * x2 - 2 * x1) * t + x1 + x2);
-      }else{
-          speed = x1+(x2-x1)*t;
-      }
+      if (!pth->samples.size()) return;
+      speed = path_sample_at(pth, position).speed;
     }
 
     /// Allocates and zero-fills the path array at game start
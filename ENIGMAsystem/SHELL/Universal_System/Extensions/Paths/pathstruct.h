@@ -45,13 +45,29 @@ namespace enigma
     path_point(cs_scalar X = 0, cs_scalar Y = 0, cs_scalar Speed = 0, cs_scalar Length = 0):
       x(X), y(Y), speed(Speed), length(Length) {}
   };
+  // A point on the path, with the path's speed there.
+  struct path_sample
+  {
+    cs_scalar x, y, speed;
+    unsigned corner; // On straight paths, the corner starting the segment this sample lies on
+    path_sample(cs_scalar X = 0, cs_scalar Y = 0, cs_scalar Speed = 0, unsigned Corner = 0):
+      x(X), y(Y), speed(Speed), corner(Corner) {}
+  };
   struct path
   {
     int id, precision;
     bool smooth, closed;
     vector<path_point> pointarray;
-    map<cs_scalar,int> pointoffset;
+    map<cs_scalar,int> pointoffset; // Position at which each point's segment starts
     cs_scalar total_length, centerx, centery;
+    // Points spaced evenly along the path's length, the first at its start and the last at its
+    // end, rebuilt with the rest by path_recalculate. Positions are looked up here.
+    vector<path_sample> samples;
+    cs_scalar sample_spacing; // The greatest distance between samples, in pixels
+    // Straight paths only: their corners in order, and the position of each. Samples there just
+    // find the segment, and positions are interpolated along it, so they never cut a corner.
+    vector<path_sample> corners;
+    vector<cs_scalar> corner_positions;
     path(unsigned pathid, bool smooth, bool closed, int precision, unsigned pointcount);
     ~path();
   };
@@ -59,6 +75,8 @@ namespace enigma
   extern path** pathstructarray;
   void path_add_point(unsigned pathid, cs_scalar x, cs_scalar y, cs_scalar speed);
   void path_recalculate(unsigned pathid);
+  // Rebuilds only the samples, for changes that move points without changing lengths.
+  void path_bake(path *pth);
   void path_getXY(path *pth, cs_scalar &x, cs_scalar &y, cs_scalar position);
   void path_getXY_scaled(path *pth, cs_scalar &x, cs_scalar &y, cs_scalar position, cs_scalar scale);
   void path_getspeed(path *pth, cs_scalar &speed, cs_scalar position);
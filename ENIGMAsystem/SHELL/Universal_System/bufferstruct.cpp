@@ -19,6 +19,8 @@
 using std::string;
 using std::cout;
 #include <cstring>
+#include <algorithm>
+#include <stdint.h>
 #include <fstream>
 using std::ofstream;
 using std::ifstream;
@@ -40,13 +42,174 @@ namespace enigma
 		return buffers.size();
 	}
 
-	vector<unsigned char> valToBytes(variant value, unsigned count)
+	// Buffers hold their values little endian, whatever the host.
+	static inline void little_endian(unsigned char *bytes, unsigned size) {
+	#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		std::reverse(bytes, bytes + size);
+	#else
+		(void)bytes; (void)size;
+	#endif
+	}
+
+	// IEEE half precision, for buffer_f16; rounds to nearest even.
+	static uint16_t float_to_half(float f) {
+		uint32_t x;
+		memcpy(&x, &f, sizeof x);
+		const uint16_t sign = (x >> 16) & 0x8000;
+		const int exp = int((x >> 23) & 0xFF) - 127 + 15;
+		uint32_t mant = x & 0x7FFFFF;
+		if (((x >> 23) & 0xFF) == 0xFF)
+			return sign | 0x7C00 | (mant ? 0x200 : 0);
+		if (exp >= 31)
+			return sign | 0x7C00;
+		if (exp <= 0) {
+			if (exp < -10) return sign;
+			mant |= 0x800000;
+			const unsigned shift = 14 - exp;
+			uint16_t half = mant >> shift;
+			const uint32_t rest = mant & ((1u << shift) - 1), midway = 1u << (shift - 1);
+			if (rest > midway || (rest == midway && (half & 1))) half++;
+			return sign | half;
+		}
+		uint16_t half = sign | (exp << 10) | (mant >> 13);
+		const uint32_t rest = mant & 0x1FFF;
+		if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+		return half;
+	}
+
+	static float half_to_float(uint16_t h) {
+		const uint32_t sign = uint32_t(h & 0x8000) << 16;
+		int exp = (h >> 10) & 0x1F;
+		uint32_t mant = h & 0x3FF, x;
+		if (exp == 31)
+			x = sign | 0x7F800000 | (mant << 13);
+		else if (exp)
+			x = sign | uint32_t(exp + 112) << 23 | (mant << 13);
+		else if (!mant)
+			x = sign;
+		else {
+			for (exp = 1; !(mant & 0x400); exp--)
+				mant <<= 1;
+			x = sign | uint32_t(exp + 112) << 23 | ((mant & 0x3FF) << 13);
+		}
+		float f;
+		memcpy(&f, &x, sizeof f);
+		return f;
+	}
+
+	// Encodes a value as one of the fixed size types, returning the number of bytes used.
+	// Integer types keep the low bits of the value, as a cast would.
+	static unsigned encode_value(int type, const variant &value, unsigned char *bytes)
+	{
+		const double d = value.rval.d;
+		switch (type) {
+			case enigma_user::buffer_u8: case enigma_user::buffer_s8:
+			bytes[0] = (unsigned char)(long long)d;
+			return 1;
+			case enigma_user::buffer_u16: case enigma_user::buffer_s16: {
+				const uint16_t v = (uint16_t)(long long)d;
+				memcpy(bytes, &v, 2);
+				break;
+			}
+			case enigma_user::buffer_u32: case enigma_user::buffer_s32: {
+				const uint32_t v = (uint32_t)(long long)d;
+				memcpy(bytes, &v, 4);
+				break;
+			}
+			case enigma_user::buffer_f16: {
+				const uint16_t v = float_to_half(float(d));
+				memcpy(bytes, &v, 2);
+				break;
+			}
+			case enigma_user::buffer_f32: {
+				const float v = float(d);
+				memcpy(bytes, &v, 4);
+				break;
+			}
+			case enigma_user::buffer_f64:
+			memcpy(bytes, &d, 8);
+			break;
+			case enigma_user::buffer_bool:
+			bytes[0] = d != 0;
+			return 1;
+			default:
+			return 0;
+		}
+		const unsigned size = enigma_user::buffer_sizeof(type);
+		little_endian(bytes, size);
+		return size;
+	}
+
+	static variant decode_value(int type, const unsigned char *data)
+	{
+		unsigned char bytes[8];
+		const unsigned size = enigma_user::buffer_sizeof(type);
+		memcpy(bytes, data, size);
+		little_endian(bytes, size);
+		switch (type) {
+			case enigma_user::buffer_u8: return bytes[0];
+			case enigma_user::buffer_s8: return (signed char)bytes[0];
+			case enigma_user::buffer_bool: return bytes[0] != 0;
+			case enigma_user::buffer_u16: { uint16_t v; memcpy(&v, bytes, 2); return v; }
+			case enigma_user::buffer_s16: { int16_t v;  memcpy(&v, bytes, 2); return v; }
+			case enigma_user::buffer_u32: { uint32_t v; memcpy(&v, bytes, 4); return v; }
+			case enigma_user::buffer_s32: { int32_t v;  memcpy(&v, bytes, 4); return v; }
+			case enigma_user::buffer_f16: { uint16_t v; memcpy(&v, bytes, 2); return half_to_float(v); }
+			case enigma_user::buffer_f32: { float v;    memcpy(&v, bytes, 4); return v; }
+			case enigma_user::buffer_f64: { double v;   memcpy(&v, bytes, 8); return v; }
+			default: return 0;
+		}
+	}
+
+	// Reads a value at the buffer's position and moves past it.
+	static variant read_value(BinaryBuffer *binbuff, int type)
 	{
-		vector<unsigned char> result(0);
-		for (unsigned i = 0; i < count; i++) {
-			result.push_back(value >> ((i) * 8));
+		if (type == enigma_user::buffer_string) {
+			binbuff->Seek(binbuff->position);
+			const unsigned size = binbuff->GetSize();
+			if (!size) return "";
+			const unsigned char *start = &binbuff->data[binbuff->position];
+			const unsigned char *end = (const unsigned char*)memchr(start, 0, size - binbuff->position);
+			if (end) {
+				const string res((const char*)start, end - start);
+				binbuff->Seek(binbuff->position + res.length() + 1);
+				return res;
+			}
+			// The string runs off the end; let wrap and grow buffers deal with that.
+			string res;
+			for (unsigned i = 0; i < size; i++) {
+				const char byte = binbuff->ReadByte();
+				if (!byte) break;
+				res += byte;
+			}
+			return res;
 		}
-		return result;
+		const unsigned size = enigma_user::buffer_sizeof(type);
+		if (!size) return 0;
+		unsigned char bytes[8];
+		binbuff->Read(bytes, size);
+		return decode_value(type, bytes);
+	}
+
+	// Writes a value at the buffer's position and moves past it.
+	static void write_value(BinaryBuffer *binbuff, int type, const variant &value)
+	{
+		if (type == enigma_user::buffer_string) {
+			const string &str = value.sval;
+			const unsigned len = str.length() + 1;
+			binbuff->Write(str.c_str(), len);
+			for (unsigned i = len; i < binbuff->alignment; i++)
+				binbuff->WriteByte(0);
+			return;
+		}
+		unsigned char bytes[8];
+		const unsigned size = encode_value(type, value, bytes);
+		binbuff->Write(bytes, size);
+	}
+
+	// Whether values of a type stay aligned when packed back to back from an aligned position.
+	static bool packs_aligned(const BinaryBuffer *binbuff, unsigned size) {
+		return binbuff->alignment <= 1 || size % binbuff->alignment == 0;
 	}
 }
 
@@ -175,20 +338,22 @@ void buffer_load_ext(int buffer, string filename, unsigned offset) {
 
 void buffer_fill(int buffer, unsigned offset, int type, variant value, unsigned size) {
 	get_buffer(binbuff, buffer);
+	unsigned char bytes[8];
+	const unsigned n = enigma::encode_value(type, value, bytes);
+	if (!n) return;
 	unsigned nsize = offset + size;
 	if (binbuff->GetSize() < nsize && binbuff->type == buffer_grow) {
 		binbuff->data.resize(nsize);
 	}
-	unsigned pos = offset;
-	for (unsigned i = 0; i < buffer_sizeof(type); i++) {
-		binbuff[pos] = value[i];
-		if (i > binbuff->GetSize()) {
-			if (binbuff->type != buffer_wrap) {
-				break;
-			}
-			pos = 0;
-		}
+	// Each copy starts on the buffer's alignment.
+	const unsigned align = binbuff->alignment > 1 ? binbuff->alignment : 1, step = (n + align - 1) / align * align;
+	const unsigned saved = binbuff->position;
+	for (unsigned pos = offset; pos + n <= nsize; pos += step) {
+		if (binbuff->type != buffer_wrap && pos + n > binbuff->GetSize()) break;
+		binbuff->Seek(pos);
+		binbuff->Write(bytes, n);
 	}
+	binbuff->position = saved;
 }
 
 unsigned buffer_get_size(int buffer) {
@@ -268,64 +433,82 @@ int buffer_tell(int buffer) {
 
 variant buffer_peek(int buffer, unsigned offset, int type) {
 	get_bufferr(binbuff, buffer, -1);
+	const unsigned saved = binbuff->position;
 	binbuff->Seek(offset);
-	if (type != buffer_string) {
-		//unsigned dsize = buffer_sizeof(type) + binbuff->alignment - 1;
-		unsigned char data[buffer_sizeof(type)];
-		//NOTE: These buffers most likely need a little more code added to take care of endianess on different architectures.
-		//TODO: Fix floating point precision.
-		long res = 0;
-		for (unsigned i = 0; i < buffer_sizeof(type); i++) {
-			data[i] = binbuff->ReadByte();
-			res += data[i] << i * 8;
-		}
-		return res;
-	} else {
-		char byte = '1';
-		vector<char> data;
-		while (byte != 0x00) {
-			byte = binbuff->ReadByte();
-			data.push_back(byte);
-		}
-		return variant(&data[0]);
-	}
-
+	const variant res = enigma::read_value(binbuff, type);
+	binbuff->position = saved;
+	return res;
 }
 
 variant buffer_read(int buffer, int type) {
 	get_bufferr(binbuff, buffer, -1);
-	return buffer_peek(buffer, binbuff->position, type);
+	if (type != buffer_string) binbuff->Align();
+	return enigma::read_value(binbuff, type);
 }
 
 void buffer_poke(int buffer, unsigned offset, int type, variant value) {
 	get_buffer(binbuff, buffer);
+	const unsigned saved = binbuff->position;
 	binbuff->Seek(offset);
-	if (type != buffer_string) {
-		//TODO: Implement buffer alignment.
-		//unsigned dsize = buffer_sizeof(type); //+ binbuff->alignment - 1;
-		vector<unsigned char> data = enigma::valToBytes(value, buffer_sizeof(type));
-		for (unsigned i = 0; i < data.size(); i++) {
-			binbuff->WriteByte(data[i]);
-		}
-	} else {
-		char byte = '1';
-		unsigned pos = 0;
-		while (byte != 0x00) {
-			byte = value[pos];
-			pos += 1;
-			binbuff->WriteByte(byte);
-		}
-		if (binbuff->alignment > pos) {
-			for (unsigned i = 0; i < binbuff->alignment - pos; i++) {
-				binbuff->WriteByte(0);
-			}
+	enigma::write_value(binbuff, type, value);
+	binbuff->position = saved;
+}
+
+void buffer_write(int buffer, int type, variant value) {
+	get_buffer(binbuff, buffer);
+	if (type != buffer_string) binbuff->Align();
+	enigma::write_value(binbuff, type, value);
+}
+
+var buffer_read_array(int buffer, int type, unsigned count) {
+	var res;
+	get_bufferr(binbuff, buffer, res);
+	if (!count) return res;
+	res.array_fill(0, 0, count, 0);
+
+	// Packed values lying wholly inside the buffer are decoded in place.
+	const unsigned size = buffer_sizeof(type);
+	if (size && enigma::packs_aligned(binbuff, size)) {
+		binbuff->Align();
+		if (binbuff->position + (unsigned long long)size * count <= binbuff->GetSize()) {
+			const unsigned char *data = &binbuff->data[binbuff->position];
+			for (unsigned i = 0; i < count; i++)
+				res[i] = enigma::decode_value(type, data + i * size);
+			binbuff->Seek(binbuff->position + size * count);
+			return res;
 		}
 	}
+	for (unsigned i = 0; i < count; i++) {
+		if (type != buffer_string) binbuff->Align();
+		res[i] = enigma::read_value(binbuff, type);
+	}
+	return res;
 }
 
-void buffer_write(int buffer, int type, variant value) {
+void buffer_write_array(int buffer, int type, const var& values, int count) {
 	get_buffer(binbuff, buffer);
-	buffer_poke(buffer, binbuff->position, type, value);
+	if (count < 0) count = values.array_len();
+	if (!count) return;
+
+	// Packed values are encoded straight into the buffer when they fit, growing it first if it may.
+	const unsigned size = buffer_sizeof(type);
+	if (size && enigma::packs_aligned(binbuff, size)) {
+		binbuff->Align();
+		const unsigned long long end = binbuff->position + (unsigned long long)size * count;
+		if (binbuff->type == buffer_grow && end > binbuff->GetSize() && end <= 0xFFFFFFFFULL)
+			binbuff->Resize(end);
+		if (end <= binbuff->GetSize()) {
+			unsigned char *data = &binbuff->data[binbuff->position];
+			for (int i = 0; i < count; i++)
+				enigma::encode_value(type, values[i], data + i * size);
+			binbuff->Seek(end);
+			return;
+		}
+	}
+	for (int i = 0; i < count; i++) {
+		if (type != buffer_string) binbuff->Align();
+		enigma::write_value(binbuff, type, values[i]);
+	}
 }
 
 string buffer_md5(int buffer, unsigned offset, unsigned size) {
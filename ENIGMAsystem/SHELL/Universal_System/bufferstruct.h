@@ -17,6 +17,7 @@
 
 #include <string>
 #include <vector>
+#include <cstring>
 using std::vector;
 
 #include "var4.h"
@@ -129,6 +130,41 @@ namespace enigma
 		Seek(position + 1);
 	}
 
+	// Moves the position up to the next multiple of the alignment.
+	void Align() {
+		if (alignment > 1 && position % alignment)
+			Seek(position + alignment - position % alignment);
+	}
+
+	// Reads or writes size bytes at the position and moves past them. Where they fit in the
+	// buffer this is one copy; otherwise they go a byte at a time, so that buffer_wrap and
+	// buffer_grow buffers behave exactly as with ReadByte and WriteByte.
+	void Read(void *dest, unsigned size) {
+		Seek(position);
+		if (type == enigma_user::buffer_grow && position + size > GetSize())
+			Resize(position + size);
+		if (position + size <= GetSize()) {
+			memcpy(dest, &data[position], size);
+			Seek(position + size);
+			return;
+		}
+		for (unsigned i = 0; i < size; i++)
+			((unsigned char*)dest)[i] = ReadByte();
+	}
+
+	void Write(const void *src, unsigned size) {
+		Seek(position);
+		if (type == enigma_user::buffer_grow && position + size > GetSize())
+			Resize(position + size);
+		if (position + size <= GetSize()) {
+			memcpy(&data[position], src, size);
+			Seek(position + size);
+			return;
+		}
+		for (unsigned i = 0; i < size; i++)
+			WriteByte(((const unsigned char*)src)[i]);
+	}
+
   };
   
   extern vector<BinaryBuffer*> buffers;
@@ -187,6 +223,11 @@ void buffer_fill(int buffer, unsigned offset, int type, variant value, unsigned
 void buffer_poke(int buffer, unsigned offset, int type, variant value);
 void buffer_write(int buffer, int type, variant value);
 
+// Reads or writes count values of one type in a single call; values come from or go to
+// elements 0 to count - 1 of a 1D array. A negative count writes the whole array.
+var buffer_read_array(int buffer, int type, unsigned count);
+void buffer_write_array(int buffer, int type, const var& values, int count = -1);
+
 void game_save_buffer(int buffer);
 void game_load_buffer(int buffer);
 
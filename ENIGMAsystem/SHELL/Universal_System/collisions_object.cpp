@@ -116,7 +116,50 @@ namespace enigma
          return (mask_index >= 0 ? sprite_get_bbox(mask_index) : sprite_get_bbox(sprite_index));
     }
 
-    object_collisions::object_collisions(): object_transform() {}
-    object_collisions::object_collisions(unsigned _id,int _objid): object_transform(_id,_objid) {}
+    void get_border(int *leftv, int *rightv, int *topv, int *bottomv, int left, int top, int right, int bottom, double x, double y, double xscale, double yscale, double angle)
+    {
+        const bool xsp = (xscale >= 0), ysp = (yscale >= 0);
+        const double lsc = left*xscale, rsc = (right+1)*xscale-1, tsc = top*yscale, bsc = (bottom+1)*yscale-1;
+        if (fzero(angle))
+        {
+            *leftv   = (xsp ? lsc : rsc) + x + .5;
+            *rightv  = (xsp ? rsc : lsc) + x + .5;
+            *topv    = (ysp ? tsc : bsc) + y + .5;
+            *bottomv = (ysp ? bsc : tsc) + y + .5;
+        }
+        else
+        {
+            const double arad = angle*(M_PI/180.0);
+            const double sina = sin(arad), cosa = cos(arad);
+            const int quad = int(fmod(fmod(angle, 360) + 360, 360)/90.0);
+            const bool q12 = (quad == 1 || quad == 2), q23 = (quad == 2 || quad == 3),
+                       xs12 = xsp^q12, sx23 = xsp^q23, ys12 = ysp^q12, ys23 = ysp^q23;
+
+            *leftv   = cosa*(xs12 ? lsc : rsc) + sina*(ys23 ? tsc : bsc) + x + .5;
+            *rightv  = cosa*(xs12 ? rsc : lsc) + sina*(ys23 ? bsc : tsc) + x + .5;
+            *topv    = cosa*(ys12 ? tsc : bsc) - sina*(sx23 ? rsc : lsc) + y + .5;
+            *bottomv = cosa*(ys12 ? bsc : tsc) - sina*(sx23 ? lsc : rsc) + y + .5;
+        }
+    }
+
+    // Recomputed only when the position, transform, sprite or mask differ from the cached ones, or
+    // after a change to any sprite's collision box.
+    const world_bbox_t& object_collisions::$bbox_world() const
+    {
+        world_bbox_t &c = $bbox_world_cache;
+        if (c.x == x && c.y == y && c.xscale == image_xscale && c.yscale == image_yscale && c.angle == image_angle &&
+            c.sprite_index == sprite_index && c.mask_index == mask_index && c.serial == sprite_bbox_serial)
+            return c;
+
+        c.x = x, c.y = y, c.xscale = image_xscale, c.yscale = image_yscale, c.angle = image_angle;
+        c.sprite_index = sprite_index, c.mask_index = mask_index, c.serial = sprite_bbox_serial;
+        const bbox_rect_t &box = $bbox_relative();
+        get_border(&c.left, &c.right, &c.top, &c.bottom, box.left, box.top, box.right, box.bottom, x, y, image_xscale, image_yscale, image_angle);
+        return c;
+    }
+
+    // A NaN scale never compares equal, so the first $bbox_world() call always computes.
+    object_collisions::object_collisions(): object_transform() { $bbox_world_cache.xscale = NAN; }
+    object_collisions::object_collisions(unsigned _id,int _objid): object_transform(_id,_objid) { $bbox_world_cache.xscale = NAN; }
     object_collisions::~object_collisions() {}
 }
@@ -38,6 +38,20 @@
 struct bbox_rect_t;
 namespace enigma
 {
+  // An instance's bounding box in room coordinates, along with the locals and the sprite_bbox_serial
+  // it was computed under.
+  struct world_bbox_t
+  {
+    int left, top, right, bottom;
+    cs_scalar x, y;
+    gs_scalar xscale, yscale, angle;
+    int sprite_index, mask_index;
+    unsigned serial;
+  };
+
+  // Computes the room-coordinate bounding box of a relative box placed at (x, y) with the given scale and rotation.
+  void get_border(int *leftv, int *rightv, int *topv, int *bottomv, int left, int top, int right, int bottom, double x, double y, double xscale, double yscale, double angle);
+
   struct object_collisions: object_transform
   {
     //Bit Mask
@@ -54,10 +68,12 @@ namespace enigma
         int $bbox_bottom() const;
         const bbox_rect_t& $bbox_relative() const;
         const bbox_rect_t& $bbox() const;
+        const world_bbox_t& $bbox_world() const;
         #define bbox_left   $bbox_left()
         #define bbox_right  $bbox_right()
         #define bbox_top    $bbox_top()
         #define bbox_bottom $bbox_bottom()
+        mutable world_bbox_t $bbox_world_cache;
       #endif
     
     //Constructors
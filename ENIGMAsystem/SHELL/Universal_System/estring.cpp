@@ -17,9 +17,12 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 #include <cstdlib>
+#include <vector>
 #include "var4.h"
 #include "estring.h"
+#include "callbacks_events.h"
 
 #ifdef DEBUG_MODE
 #include "libEGMstd.h"
@@ -37,6 +40,147 @@ static const char ldgrs[256] = {
   1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0
 };
 
+// Word-at-a-time helpers, eight bytes to a 64-bit word; each leaves the high bit set in the
+// bytes matching some test and clears every other bit.
+typedef uint64_t swar_word;
+static const swar_word swar_ones = 0x0101010101010101ULL, swar_highs = 0x8080808080808080ULL;
+
+static inline swar_word swar_load(const char *p) {
+  swar_word w;
+  memcpy(&w, p, sizeof w);
+  return w;
+}
+static inline void swar_store(char *p, swar_word w) {
+  memcpy(p, &w, sizeof w);
+}
+
+// Bytes from lo to hi, inclusive; only ASCII bytes can match.
+static inline swar_word swar_in_range(swar_word w, unsigned char lo, unsigned char hi) {
+  const swar_word low7 = w & ~swar_highs;
+  const swar_word above_hi = low7 + swar_ones * (0x7F - hi), from_lo = low7 + swar_ones * (0x80 - lo);
+  return (from_lo & ~above_hi) & ~w & swar_highs;
+}
+
+// UTF-8 continuation bytes, 10xxxxxx.
+static inline swar_word swar_continuations(swar_word w) {
+  return w & (~w << 1) & swar_highs;
+}
+static inline size_t swar_count(swar_word marks) {
+  return size_t(((marks >> 7) * swar_ones) >> 56);
+}
+
+// Adds 'a' - 'A' to the bytes from lo to hi, which is both case conversions.
+static string swar_shift_case(const string &str, unsigned char lo, unsigned char hi, bool up)
+{
+  string ret(str);
+  char *c = &ret[0];
+  const size_t len = ret.length();
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    const swar_word w = swar_load(c + i), hit = swar_in_range(w, lo, hi);
+    if (hit) swar_store(c + i, w ^ (hit >> 2)); // 0x80 >> 2 is the 0x20 case bit
+  }
+  for (; i < len; ++i)
+    if ((unsigned char)c[i] >= lo and (unsigned char)c[i] <= hi)
+      c[i] += up ? -32 : 32;
+  return ret;
+}
+
+static size_t utf8_count(const char *str, size_t len)
+{
+  size_t cont = 0, i = 0;
+  for (; i + 8 <= len; i += 8)
+    cont += swar_count(swar_continuations(swar_load(str + i)));
+  for (; i < len; ++i)
+    if ((str[i] & 0xC0) == 0x80)
+      ++cont;
+  return len - cont;
+}
+
+// Remembers where every utf8_mark_spacing-th character starts in the last variant string indexed
+// by character, so walking a long string one character at a time doesn't rescan it from the
+// start on every call. Holding the string's handle keeps its buffer alive and unchanged, since
+// var_string unshares a buffer before writing to it, so the buffer's address and length are
+// enough to recognize the same string again. The handle is given up when another string is
+// indexed or the room ends, so the cache doesn't keep a string alive after the game drops it.
+static const size_t utf8_mark_spacing = 64;
+static struct {
+  enigma::var_string text;
+  size_t length;               // In characters
+  std::vector<size_t> marks;   // Byte offsets of characters 0, utf8_mark_spacing, ...
+} utf8_index;
+static bool utf8_index_callbacks_registered = false;
+
+static void utf8_index_release() {
+  utf8_index.text = enigma::var_string();
+  std::vector<size_t>().swap(utf8_index.marks);
+}
+
+static bool utf8_index_holds(const enigma::var_string &str) {
+  return str.c_str() == utf8_index.text.c_str() and str.length() == utf8_index.text.length();
+}
+
+static void utf8_index_build(const enigma::var_string &str)
+{
+  if (!utf8_index_callbacks_registered) {
+    enigma::register_callback_clean_up_roomend(utf8_index_release);
+    utf8_index_callbacks_registered = true;
+  }
+  utf8_index.text = str;
+  utf8_index.marks.clear();
+  const string &s = str;
+  size_t chars = 0;
+  for (size_t i = 0; i < s.length(); ++i)
+    if ((s[i] & 0xC0) != 0x80) {
+      if (!(chars % utf8_mark_spacing))
+        utf8_index.marks.push_back(i);
+      ++chars;
+    }
+  utf8_index.length = chars;
+}
+
+// Byte offset of the character at the given index, or the string's length if it has no such
+// character. Scanning starts at 'from', which must be the offset of character 'index - skip'.
+static size_t utf8_offset(const string &str, size_t from, size_t skip)
+{
+  for (size_t i = from; i < str.length(); ++i)
+    if ((str[i] & 0xC0) != 0x80 and !skip--)
+      return i;
+  return str.length();
+}
+
+static size_t utf8_offset(const string &str, size_t index) {
+  return utf8_offset(str, 0, index);
+}
+
+static size_t utf8_offset(const enigma::var_string &str, size_t index)
+{
+  if (str.length() <= utf8_mark_spacing)
+    return utf8_offset(str.str(), index);
+  if (!utf8_index_holds(str))
+    utf8_index_build(str);
+  if (index >= utf8_index.length)
+    return str.length();
+  return utf8_offset(str.str(), utf8_index.marks[index / utf8_mark_spacing], index % utf8_mark_spacing);
+}
+
+// The character starting at the given byte offset.
+static string utf8_char_at(const string &str, size_t start)
+{
+  size_t end = start;
+  if (end < str.length())
+    for (++end; end < str.length() and (str[end] & 0xC0) == 0x80; ++end);
+  return str.substr(start, end - start);
+}
+
+// The text of a variant. A string variant's buffer is bound in place rather than copied out by
+// its string conversion; any other value still goes through that conversion, into 'buf'.
+static const string &variant_text(const variant &v, string &buf) {
+  if (v.type == enigma::vt_tstr)
+    return v.sval;
+  return buf = string(v);
+}
+
 static const std::string base64_chars =
              "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
              "abcdefghijklmnopqrstuvwxyz"
@@ -140,31 +284,33 @@ bool is_string(variant val) { return val.type;  }
 bool is_real(variant val)   { return !val.type; }
 string ansi_char(char byte) { return string(1,byte); }
 string chr(char val) { return string(1,val); }
-int ord(string str)  { return str[0]; }
+int ord(const string& str)  { return str[0]; }
 
-size_t string_length(string str) { return str.length(); }
+size_t string_length(const string& str) { return str.length(); }
 size_t string_length(const char* str) { return strlen(str); }
 
-size_t string_length_utf8(string str) {
-  size_t res = 0;
-  for (size_t i = 0; i < str.length(); ++i)
-    if ((str[i] & 0xC0) != 0x80)
-      ++res;
-  return res;
+size_t string_length_utf8(const string& str) {
+  return utf8_count(str.data(), str.length());
 }
 
 size_t string_length_utf8(const char* str) {
-  size_t res = 0;
-  for (size_t i = 0; str[i]; ++i)
-    if ((str[i] & 0xC0) != 0x80)
-      ++res;
-  return res;
+  return utf8_count(str, strlen(str));
 }
 
-size_t string_pos(string substr,string str) {
+size_t string_pos(const string& substr, const string& str) {
   const size_t res = str.find(substr,0) + 1;
   return res == string::npos ? 0 : (int)res;
 }
+size_t string_pos(const string& substr, const char* str) {
+  return string_pos(substr, string(str));
+}
+size_t string_pos(const string& substr, const variant& str) {
+  string buf;
+  return string_pos(substr, variant_text(str, buf));
+}
+size_t string_pos(const string& substr, const var& str) {
+  return string_pos(substr, *str);
+}
 
 string string_format(double val, unsigned tot, unsigned dec)
 {
@@ -174,18 +320,30 @@ string string_format(double val, unsigned tot, unsigned dec)
   return fstr.c_str();
 }
 
-string string_copy(string str, int index, int count) {
+string string_copy(const string& str, int index, int count) {
   index = index < 0 ? 0 : index;
   return (size_t)index > str.length() ? "" : str.substr(index < 2 ? 0 : index - 1, count < 1 ? 0 : count);
 }
+string string_copy(const char* str, int index, int count) {
+  return string_copy(string(str), index, count);
+}
+string string_copy(const variant& str, int index, int count) {
+  string buf;
+  return string_copy(variant_text(str, buf), index, count);
+}
+string string_copy(const var& str, int index, int count) {
+  return string_copy(*str, index, count);
+}
 
-string string_set_byte_at(string str, int index, char byte) {
+string string_set_byte_at(const string& str, int index, char byte) {
   if (index <= 1) return str + byte;
   const size_t x = index - 1;
-  return x > str.length()? str + byte: str.replace(x, 1, 1, byte);
+  if (x > str.length()) return str + byte;
+  string ret(str);
+  return ret.replace(x, 1, 1, byte);
 }
 
-char string_byte_at(string str, int index) {
+char string_byte_at(const string& str, int index) {
   unsigned int n = index <= 1 ? 0 : (unsigned int)(index - 1);
   #ifdef DEBUG_MODE
     if (n > str.length())
@@ -194,7 +352,7 @@ char string_byte_at(string str, int index) {
   return str[n];
 }
 
-string string_char_at(string str,int index) {
+string string_char_at(const string& str,int index) {
   unsigned int n = index <= 1 ? 0 : (unsigned int)(index - 1);
   #ifdef DEBUG_MODE
     if (n > str.length())
@@ -203,97 +361,164 @@ string string_char_at(string str,int index) {
   return string(1, str[n]);
 }
 
-string string_delete(string str,int index,int count) {
-  return str.erase(index < 2 ? 0 : index - 1, count < 1 ? 0 : count);
+string string_char_at_utf8(const string& str, int index) {
+  return utf8_char_at(str, utf8_offset(str, index <= 1 ? 0 : size_t(index - 1)));
+}
+string string_char_at_utf8(const char* str, int index) {
+  return string_char_at_utf8(string(str), index);
+}
+string string_char_at_utf8(const variant& str, int index) {
+  if (str.type != enigma::vt_tstr)
+    return string_char_at_utf8(string(str), index);
+  return utf8_char_at(str.sval, utf8_offset(str.sval, index <= 1 ? 0 : size_t(index - 1)));
+}
+string string_char_at_utf8(const var& str, int index) {
+  return string_char_at_utf8(*str, index);
+}
+
+string string_delete(const string& str,int index,int count) {
+  const size_t x = index < 2 ? 0 : index - 1, n = count < 1 ? 0 : count;
+  if (x >= str.length() or !n) return str;
+  if (n >= str.length() - x) return str.substr(0, x);
+  string ret;
+  ret.reserve(str.length() - n);
+  return ret.append(str, 0, x).append(str, x + n, string::npos);
 }
 
-string string_insert(string substr,string str,int index) {
+string string_insert(const string& substr,const string& str,int index) {
   if (index <= 1) return substr + str;
   const size_t x = index - 1;
-  return x > str.length() ? str + substr : str.insert(x, substr);
+  if (x > str.length()) return str + substr;
+  string ret;
+  ret.reserve(str.length() + substr.length());
+  return ret.append(str, 0, x).append(substr).append(str, x, string::npos);
 }
 
-string string_replace(string str,string substr,string newstr) {
-  size_t pos = str.find(substr,0);
-  return pos == (size_t)-1 ? str : str.replace(pos,substr.length(),newstr);
+string string_replace(const string& str,const string& substr,const string& newstr) {
+  const size_t pos = str.find(substr,0);
+  if (pos == string::npos) return str;
+  string ret;
+  ret.reserve(str.length() - substr.length() + newstr.length());
+  return ret.append(str, 0, pos).append(newstr).append(str, pos + substr.length(), string::npos);
 }
 
-string string_replace_all(string str,string substr,string newstr) {
-  size_t pos = 0;
-  const size_t sublen = substr.length(), newlen = newstr.length();
-  while ((pos = str.find(substr,pos)) != string::npos) {
-    str.replace(pos,sublen,newstr);
-    pos += newlen;
-  }
-  return str;
+// Builds the result in one pass rather than replacing in place, which would move the rest of
+// the string along at every match.
+string string_replace_all(const string& str,const string& substr,const string& newstr) {
+  const size_t sublen = substr.length();
+  if (!sublen) return str;
+  size_t pos = str.find(substr,0);
+  if (pos == string::npos) return str;
+  string ret;
+  ret.reserve(str.length());
+  size_t done = 0;
+  do {
+    ret.append(str, done, pos - done).append(newstr);
+    done = pos + sublen;
+  } while ((pos = str.find(substr,done)) != string::npos);
+  return ret.append(str, done, string::npos);
+}
+string string_replace_all(const char* str,const string& substr,const string& newstr) {
+  return string_replace_all(string(str), substr, newstr);
+}
+string string_replace_all(const variant& str,const string& substr,const string& newstr) {
+  string buf;
+  return string_replace_all(variant_text(str, buf), substr, newstr);
+}
+string string_replace_all(const var& str,const string& substr,const string& newstr) {
+  return string_replace_all(*str, substr, newstr);
 }
 
-size_t string_count(string substr,string str) {
+size_t string_count(const string& substr,const string& str) {
   size_t pos = 0, occ = 0;
   const size_t sublen = substr.length();
+  if (!sublen) return 0;
   while ((pos = str.find(substr,pos)) != string::npos)
     occ++, pos += sublen;
   return occ;
 }
+size_t string_count(const string& substr,const char* str) {
+  return string_count(substr, string(str));
+}
+size_t string_count(const string& substr,const variant& str) {
+  string buf;
+  return string_count(substr, variant_text(str, buf));
+}
+size_t string_count(const string& substr,const var& str) {
+  return string_count(substr, *str);
+}
 
-string string_lower(string str) {
-  const size_t len = str.length();
-  for (size_t i = 0; i < len; ++i)
-    if (ldgrs[(int)(unsigned char)str[i]] & 2)
-      str[i] += 32;
-  return str;
+string string_lower(const string& str) {
+  return swar_shift_case(str, 'A', 'Z', false);
+}
+string string_lower(const char* str) {
+  return string_lower(string(str));
+}
+string string_lower(const variant& str) {
+  string buf;
+  return string_lower(variant_text(str, buf));
+}
+string string_lower(const var& str) {
+  return string_lower(*str);
 }
 
-string string_upper(string str) {
-  const size_t len = str.length();
-  for (size_t i = 0; i < len; ++i)
-    if (ldgrs[(unsigned char)str[i]] & 1)
-      str[i] -= 32;
-  return str;
+string string_upper(const string& str) {
+  return swar_shift_case(str, 'a', 'z', true);
+}
+string string_upper(const char* str) {
+  return string_upper(string(str));
+}
+string string_upper(const variant& str) {
+  string buf;
+  return string_upper(variant_text(str, buf));
+}
+string string_upper(const var& str) {
+  return string_upper(*str);
 }
 
-string string_repeat(string str,int count) {
+string string_repeat(const string& str,int count) {
+  if (count <= 0) return "";
   string ret; ret.reserve(str.length() * count);
   for (int i = count; i; i--) ret.append(str);
   return ret;
 }
 
-string string_letters(string str) {
+string string_letters(const string& str) {
   string ret;
   for (const char *c = str.c_str(); *c; c++)
     if (ldgrs[(unsigned char)*c] & 3) ret += *c;
   return ret;
 }
 
-string string_digits(string str) {
+string string_digits(const string& str) {
   string ret;
   for (const char *c = str.c_str(); *c; c++)
     if (ldgrs[(unsigned char)*c] & 4) ret += *c;
   return ret;
 }
 
-string string_lettersdigits(string str) {
+string string_lettersdigits(const string& str) {
   string ret;
   for (const char *c = str.c_str(); *c; c++)
     if (ldgrs[(unsigned char)*c]) ret += *c;
   return ret;
 }
 
-bool string_isletters(string str) {
+bool string_isletters(const string& str) {
   for (const char *c = str.c_str(); *c; c++)
     if (!(ldgrs[(unsigned char)*c] & 3))
       return false;
   return true;
 }
 
-bool string_isdigits(string str) {
+bool string_isdigits(const string& str) {
   for (const char *c = str.c_str(); *c; c++)
     if (!(ldgrs[(unsigned char)*c] & 4))
       return false;
   return true;
 }
 
-bool string_islettersdigits(string str) {
+bool string_islettersdigits(const string& str) {
   for (const char *c = str.c_str(); *c; c++)
     if (!ldgrs[(unsigned char)*c])
       return false;
@@ -302,19 +527,19 @@ bool string_islettersdigits(string str) {
 
 //filename fucntions place here as they are just string based
 
-string filename_name(string fname)
+string filename_name(const string& fname)
 {
   size_t fp = fname.find_last_of("/\\");
   return fname.substr(fp+1);
 }
 
-string filename_path(string fname)
+string filename_path(const string& fname)
 {
   size_t fp = fname.find_last_of("/\\");
   return fname.substr(0,fp+1);
 }
 
-string filename_dir(string fname)
+string filename_dir(const string& fname)
 {
   size_t fp = fname.find_last_of("/\\");
   if (fp == string::npos)
@@ -322,13 +547,13 @@ string filename_dir(string fname)
   return fname.substr(0, fp);
 }
 
-string filename_drive(string fname)
+string filename_drive(const string& fname)
 {
   size_t fp = fname.find("/\\");
   return fname.substr(0, fp);
 }
 
-string filename_ext(string fname)
+string filename_ext(const string& fname)
 {
   size_t fp = fname.find_last_of(".");
   if (fp == string::npos)
@@ -336,12 +561,12 @@ string filename_ext(string fname)
   return fname.substr(fp);
 }
 
-string filename_change_ext(string fname, string newext)
+string filename_change_ext(const string& fname, const string& newext)
 {
   size_t fp = fname.find_last_of(".");
   if (fp == string::npos)
     return fname + newext;
-  return fname.replace(fp,fname.length(),newext);
+  return fname.substr(0,fp) + newext;
 }
 
 }
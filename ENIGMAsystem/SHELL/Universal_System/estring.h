@@ -29,46 +29,68 @@ bool is_real(variant val);
 
 string ansi_char(char byte);
 string chr(char val);
-int ord(string str);
+int ord(const string& str);
 
 double real(variant str);
 
-size_t string_length(string str);
+size_t string_length(const string& str);
 size_t string_length(const char* str);
 #define string_byte_length(x) string_length(x)
-size_t string_length_utf8(string str);
+size_t string_length_utf8(const string& str);
 size_t string_length_utf8(const char* str);
-size_t string_pos(string substr, string str);
+size_t string_pos(const string& substr, const string& str);
+size_t string_pos(const string& substr, const char* str);
+size_t string_pos(const string& substr, const variant& str); // Reads string variants in place
+size_t string_pos(const string& substr, const var& str);
 
 string string_format(double val, unsigned tot, unsigned dec);
-string string_copy(string str, int index, int count);
-string string_set_byte_at(string str, int pos, char byte);
-char string_byte_at(string str, int index);
-string string_char_at(string str,int index);
-string string_delete(string str, int index, int count);
-string string_insert(string substr, string str, int index);
-string string_replace(string str, string substr, string newstr);
-string string_replace_all(string str, string substr, string newstr);
-size_t string_count(string substr, string str);
+string string_copy(const string& str, int index, int count);
+string string_copy(const char* str, int index, int count);
+string string_copy(const variant& str, int index, int count);
+string string_copy(const var& str, int index, int count);
+string string_set_byte_at(const string& str, int pos, char byte);
+char string_byte_at(const string& str, int index);
+string string_char_at(const string& str,int index);
+string string_char_at_utf8(const string& str, int index);
+string string_char_at_utf8(const char* str, int index);
+string string_char_at_utf8(const variant& str, int index); // Indexes long strings for stepping through them
+string string_char_at_utf8(const var& str, int index);
+string string_delete(const string& str, int index, int count);
+string string_insert(const string& substr, const string& str, int index);
+string string_replace(const string& str, const string& substr, const string& newstr);
+string string_replace_all(const string& str, const string& substr, const string& newstr);
+string string_replace_all(const char* str, const string& substr, const string& newstr);
+string string_replace_all(const variant& str, const string& substr, const string& newstr);
+string string_replace_all(const var& str, const string& substr, const string& newstr);
+size_t string_count(const string& substr, const string& str);
+size_t string_count(const string& substr, const char* str);
+size_t string_count(const string& substr, const variant& str);
+size_t string_count(const string& substr, const var& str);
 
-string string_lower(string str);
-string string_upper(string str);
+string string_lower(const string& str);
+string string_lower(const char* str);
+string string_lower(const variant& str);
+string string_lower(const var& str);
+string string_upper(const string& str);
+string string_upper(const char* str);
+string string_upper(const variant& str);
+string string_upper(const var& str);
 
-string string_repeat(string str, int count);
+string string_repeat(const string& str, int count);
 
-string string_letters(string str);
-string string_digits(string str);
-string string_lettersdigits(string str);
+string string_letters(const string& str);
+string string_digits(const string& str);
+string string_lettersdigits(const string& str);
 
-bool string_isletters(string str);
-bool string_isdigits(string str);
-bool string_islettersdigits(string str);
+bool string_isletters(const string& str);
+bool string_isdigits(const string& str);
+bool string_islettersdigits(const string& str);
 
-string filename_name(string fname);
-string filename_path(string fname);
-string filename_dir(string fname);
-string filename_drive(string fname);
-string filename_ext(string fname);
-string filename_change_ext(string fname, string newext);
+string filename_name(const string& fname);
+string filename_path(const string& fname);
+string filename_dir(const string& fname);
+string filename_drive(const string& fname);
+string filename_ext(const string& fname);
+string filename_change_ext(const string& fname, const string& newext);
 
 }
@@ -150,6 +150,7 @@ namespace enigma
 	  fontstructarray[i]->texture = graphics_create_texture(twid,thgt,twid,thgt,pixels,false);
 	  fontstructarray[i]->twid = twid;
 	  fontstructarray[i]->thgt = thgt;
+	  font_index_glyphs(fontstructarray[i]);
 
 	  delete[] pixels;
 
@@ -17,6 +17,7 @@
 *** with this code. If not, see <http://www.gnu.org/licenses/>
 **/
 
+#include <algorithm>
 #include <list>
 #include <string>
 #include <string.h>
@@ -36,6 +37,31 @@ namespace enigma
 {
   font **fontstructarray = NULL;
   extern size_t font_idmax;
+  unsigned font_glyph_generation = 0;
+
+  void font_index_glyphs(font *fnt)
+  {
+    static const uint32_t plane_end = 0x10000; // Characters below this are looked up directly
+    fnt->glyphTable.clear();
+    fnt->astralRanges.clear();
+    const size_t count = std::min(size_t(fnt->glyphRangeCount), fnt->glyphRanges.size());
+    for (size_t i = 0; i < count; i++)
+    {
+      fontglyphrange *fgr = fnt->glyphRanges[i];
+      // Only glyphs that were actually loaded; a range may claim more than it holds
+      const uint32_t end = fgr->glyphstart + std::min(size_t(fgr->glyphcount), fgr->glyphs.size());
+      if (end > plane_end)
+        fnt->astralRanges.push_back(fgr);
+      const uint32_t table_end = std::min(end, plane_end);
+      if (table_end > fnt->glyphTable.size())
+        fnt->glyphTable.resize(table_end, NULL);
+      // Earlier ranges take precedence, as they did when the ranges were searched in order
+      for (uint32_t c = fgr->glyphstart; c < table_end; c++)
+        if (!fnt->glyphTable[c])
+          fnt->glyphTable[c] = fgr->glyphs[c - fgr->glyphstart];
+    }
+    font_glyph_generation++;
+  }
 
   int font_new(uint32_t gs, uint32_t gc) // Creates a new font, allocating 'gc' glyphs
   {
@@ -57,6 +83,7 @@ namespace enigma
     }
     fontstructarray = fsan + 1;
     fontstructarray[font_idmax] = ret;
+    font_index_glyphs(ret);
     return font_idmax++;
   }
 
@@ -84,7 +111,7 @@ namespace enigma
         enigma::fontglyph* fg = new enigma::fontglyph();
         fgr->glyphs.push_back(fg);
         unsigned fw, fh;
-        unsigned char* data = enigma::graphics_get_texture_pixeldata(sspr->texturearray[i], &fw, &fh);
+        unsigned char* data = enigma::sprite_get_subimage_pixeldata(sspr, i, &fw, &fh);
         //NOTE: Following line replaced gtw = int((double)sspr->width / sspr->texbordyarray[i]);
         //this was to fix non-power of two subimages
         gtw = fw;
@@ -171,21 +198,12 @@ namespace enigma
       font->twid = w;
       font->thgt = h;
       font->yoffset = 0;
+      font_index_glyphs(font);
 
       return true;
   }
 }
 
-static enigma::fontglyph* findGlyph(const enigma::font *const fnt, uint32_t character) {
-	for (size_t i = 0; i < fnt->glyphRangeCount; i++) {
-		enigma::fontglyphrange* fgr = fnt->glyphRanges[i];
-		if (character >= fgr->glyphstart && character < fgr->glyphstart + fgr->glyphcount) {
-			return fgr->glyphs[character - fgr->glyphstart];
-		}
-	}
-	return NULL;
-}
-
 namespace enigma_user
 {
 
@@ -247,6 +265,7 @@ int font_add(string name, int size, bool bold, bool italic, uint32_t first, uint
   fnt->glyphRanges.push_back(fgr);
   fgr->glyphstart = first;
   fgr->glyphcount = last-first;
+  enigma::font_index_glyphs(fnt);
   
   return res;
 }
@@ -263,6 +282,7 @@ bool font_replace(int ind, string name, int size, bool bold, bool italic, uint32
   fnt->glyphRanges.push_back(fgr);
   fgr->glyphstart = first;
   fgr->glyphcount = last-first;
+  enigma::font_index_glyphs(fnt);
   return true;
 }
 
@@ -274,6 +294,7 @@ bool font_replace_sprite(int ind, int spr, uint32_t first, bool prop, int sep)
   unsigned char gcount = sspr->subcount;
   enigma::font *fnt = enigma::fontstructarray[ind];
   fnt->glyphRanges.clear(); //TODO: Delete glyphs for each range or add it to the destructor?
+  enigma::font_index_glyphs(fnt);
   fnt->glyphRangeCount = 1;
   enigma::fontglyphrange* fgr = new enigma::fontglyphrange();
   fnt->glyphRanges.push_back(fgr);
@@ -295,22 +316,22 @@ int font_add_sprite(int spr, uint32_t first, bool prop, int sep)
 }
 
 float font_get_glyph_texture_left(int fnt, uint32_t character) {
-  enigma::fontglyph* glyph = findGlyph(enigma::fontstructarray[fnt], character);
+  enigma::fontglyph* glyph = enigma::font_find_glyph(enigma::fontstructarray[fnt], character);
   return glyph->tx;
 }
 
 float font_get_glyph_texture_top(int fnt, uint32_t character) {
-  enigma::fontglyph* glyph = findGlyph(enigma::fontstructarray[fnt], character);
+  enigma::fontglyph* glyph = enigma::font_find_glyph(enigma::fontstructarray[fnt], character);
   return glyph->ty;
 }
 
 float font_get_glyph_texture_right(int fnt, uint32_t character) {
-  enigma::fontglyph* glyph = findGlyph(enigma::fontstructarray[fnt], character);
+  enigma::fontglyph* glyph = enigma::font_find_glyph(enigma::fontstructarray[fnt], character);
   return glyph->tx2;
 }
 
 float font_get_glyph_texture_bottom(int fnt, uint32_t character) {
-  enigma::fontglyph* glyph = findGlyph(enigma::fontstructarray[fnt], character);
+  enigma::fontglyph* glyph = enigma::font_find_glyph(enigma::fontstructarray[fnt], character);
   return glyph->ty2;
 }
 
@@ -46,6 +46,11 @@ namespace enigma
     std::vector<fontglyphrange*> glyphRanges;
     unsigned int height, yoffset;
 
+    // Lookup built from the ranges by font_index_glyphs: a glyph per character up to the end of
+    // the last range in the basic multilingual plane, and the ranges reaching past it
+    std::vector<fontglyph*> glyphTable;
+    std::vector<fontglyphrange*> astralRanges;
+
     // Texture layer
     int texture;
     int twid, thgt;
@@ -64,6 +69,26 @@ namespace enigma
   extern int rawfontcount, rawfontmaxid;
   int font_new(uint32_t gs, uint32_t gc); // Creates a new font, allocating 'gc' glyphs
   int font_pack(enigma::font *font, int spr, uint32_t gcount, bool prop, int sep);
+
+  // Rebuilds the glyph lookup of a font after its ranges or glyphs change.
+  void font_index_glyphs(font *fnt);
+  // Bumped by font_index_glyphs, so that anything laid out with old glyphs can tell.
+  extern unsigned font_glyph_generation;
+
+  // The glyph drawn for a character, or NULL if the font has none.
+  inline fontglyph* font_find_glyph(const font *fnt, uint32_t character)
+  {
+    if (character < fnt->glyphTable.size())
+      return fnt->glyphTable[character];
+    for (size_t i = 0; i < fnt->astralRanges.size(); i++) {
+      const fontglyphrange *fgr = fnt->astralRanges[i];
+      // Only glyphs that were actually loaded, as in font_index_glyphs
+      if (character >= fgr->glyphstart && character - fgr->glyphstart < fgr->glyphcount
+          && character - fgr->glyphstart < fgr->glyphs.size())
+        return fgr->glyphs[character - fgr->glyphstart];
+    }
+    return NULL;
+  }
 }
 
 namespace enigma_user {
@@ -28,6 +28,7 @@
 #include <string>
 using namespace std;
 #include "globalupdate.h"
+#include "var4.h"
 
 #include "roomsystem.h"
 #include "CallbackArrays.h"
@@ -39,5 +40,6 @@ namespace enigma
   void update_globals()
   {
     audiosystem_update();
+    var_end_element_loans();
   }
 }
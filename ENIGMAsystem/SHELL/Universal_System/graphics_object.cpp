@@ -64,6 +64,7 @@ namespace enigma
     else { // Local value is invalid, use the one in the map.
       drawing_depths[(*it).second.first].draw_events->unlink(myiter);
     }
+    retire_inst_iter(myiter);
     myiter = NULL;
   }
 
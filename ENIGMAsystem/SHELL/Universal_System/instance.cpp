@@ -59,7 +59,7 @@ void instance_deactivate_all(bool notme) {
 
 void instance_activate_all() {
 
-    std::map<int,enigma::object_basic*>::iterator iter = enigma::instance_deactivated_list.begin();
+    enigma::instance_id_table<enigma::object_basic*>::iterator iter = enigma::instance_deactivated_list.begin();
     while (iter != enigma::instance_deactivated_list.end()) {
         iter->second->activate();
         enigma::instance_deactivated_list.erase(iter++);
@@ -74,7 +74,7 @@ void instance_deactivate_object(int obj) {
 }
 
 void instance_activate_object(int obj) {
-    std::map<int,enigma::object_basic*>::iterator iter = enigma::instance_deactivated_list.begin();
+    enigma::instance_id_table<enigma::object_basic*>::iterator iter = enigma::instance_deactivated_list.begin();
     while (iter != enigma::instance_deactivated_list.end()) {
         enigma::object_basic* const inst = iter->second;
         if (obj == all || (obj < 100000 ? (inst->object_index==obj || inst->can_cast(obj)) : inst->id == unsigned(obj))) {
@@ -0,0 +1,221 @@
+/** Copyright (C) 2026 The ENIGMA Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_INSTANCE_ID_TABLE_H
+#define ENIGMA_INSTANCE_ID_TABLE_H
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace enigma
+{
+  // Registry of pointers keyed by instance ID.
+  // Entries are kept in one array sorted by ID, and an open-addressed hash maps each live ID to
+  // its position, so lookups are a hash probe and an array load, and iteration walks contiguous
+  // storage in ascending ID order. Erasing an entry only clears its value; the cleared entries
+  // are compacted away by a later insert once they outnumber the live ones, and an instance
+  // inserted again (as when it is reactivated) takes back its own cleared entry. Storage is
+  // therefore proportional to the number of live instances, however far apart their IDs are.
+  // Instance IDs are never recycled, so the ID itself serves as the stable handle.
+  // The interface mirrors the subset of std::map the engine has always used. Erasing never
+  // moves entries, so iterators survive erasure; inserting may, so don't insert into a table
+  // while iterating it.
+  template<typename T> class instance_id_table
+  {
+    struct entry {
+      int id;
+      T value; // T() once erased
+    };
+    std::vector<entry> entries;  // Sorted by ID, including erased entries not yet compacted
+    std::vector<unsigned> index; // Live IDs to their position + 1; 0 marks an empty bucket
+    size_t lo;    // No entry below this position is live
+    size_t count; // Number of live entries
+
+    static bool id_less(const entry &e, int id) { return e.id < id; }
+    static bool less_id(int id, const entry &e) { return id < e.id; }
+
+    size_t bucket(int id) const {
+      return (unsigned(id) * 2654435761u) & (index.size() - 1);
+    }
+
+    // Position of the live entry with the given ID, or entries.size() if there is none.
+    size_t locate(int id) const {
+      if (!count) return entries.size();
+      const size_t mask = index.size() - 1;
+      for (size_t b = bucket(id); index[b]; b = (b + 1) & mask)
+        if (entries[index[b] - 1].id == id)
+          return index[b] - 1;
+      return entries.size();
+    }
+
+    void index_add(size_t pos) {
+      const size_t mask = index.size() - 1;
+      size_t b = bucket(entries[pos].id);
+      while (index[b]) b = (b + 1) & mask;
+      index[b] = unsigned(pos + 1);
+    }
+
+    // Removes a live ID from the hash, shifting later entries of its probe run back into the gap.
+    void index_remove(int id) {
+      const size_t mask = index.size() - 1;
+      size_t gap = bucket(id);
+      while (entries[index[gap] - 1].id != id) gap = (gap + 1) & mask;
+      for (size_t b = (gap + 1) & mask; index[b]; b = (b + 1) & mask) {
+        const size_t home = bucket(entries[index[b] - 1].id);
+        if (((b - home) & mask) >= ((b - gap) & mask)) {
+          index[gap] = index[b];
+          gap = b;
+        }
+      }
+      index[gap] = 0;
+    }
+
+    // Moves the hash slots of the entries at or after pos up by one, after an entry is inserted there.
+    void index_shift(size_t pos) {
+      for (size_t b = 0; b < index.size(); ++b)
+        if (index[b] > pos) ++index[b];
+    }
+
+    // Rebuilds the hash for the live entries, at most half full.
+    void reindex() {
+      size_t size = 16;
+      while (size < 2 * count + 2) size <<= 1;
+      index.assign(size, 0);
+      for (size_t i = lo; i < entries.size(); ++i)
+        if (entries[i].value) index_add(i);
+    }
+
+    // Drops the erased entries.
+    void compact() {
+      size_t n = 0;
+      for (size_t i = lo; i < entries.size(); ++i)
+        if (entries[i].value) entries[n++] = entries[i];
+      entries.resize(n);
+      lo = 0;
+      reindex();
+    }
+
+    size_t next_live(size_t i) const {
+      while (i < entries.size() && !entries[i].value) ++i;
+      return i;
+    }
+
+   public:
+    class iterator {
+      const instance_id_table *table;
+      size_t pos;
+      std::pair<int,T> kv;
+      friend class instance_id_table;
+      iterator(const instance_id_table *t, size_t p): table(t), pos(p < t->entries.size() ? p : size_t(-1)),
+          kv(pos == size_t(-1) ? std::pair<int,T>(INT_MIN, T()) : std::pair<int,T>(t->entries[p].id, t->entries[p].value)) {}
+
+     public:
+      std::pair<int,T>* operator->() { return &kv; }
+      std::pair<int,T>& operator*() { return kv; }
+      iterator &operator++() { *this = iterator(table, table->next_live(pos + 1)); return *this; }
+      iterator operator++(int) { iterator ret(*this); ++*this; return ret; }
+      bool operator==(const iterator &other) const { return pos == other.pos; }
+      bool operator!=(const iterator &other) const { return pos != other.pos; }
+      iterator(): table(NULL), pos(size_t(-1)), kv(INT_MIN, T()) {}
+    };
+
+    // Constant-time lookup; returns NULL if the ID is not registered.
+    T get(int id) const {
+      const size_t pos = locate(id);
+      return pos < entries.size() ? entries[pos].value : T();
+    }
+
+    // Returns the live entry with the greatest ID below the given one, or NULL.
+    T before(int id) const {
+      for (size_t i = std::lower_bound(entries.begin() + lo, entries.end(), id, id_less) - entries.begin(); i-- > lo; )
+        if (entries[i].value) return entries[i].value;
+      return T();
+    }
+
+    // Returns the live entry with the least ID above the given one, or NULL.
+    T after(int id) const {
+      const size_t i = next_live(std::upper_bound(entries.begin() + lo, entries.end(), id, less_id) - entries.begin());
+      return i < entries.size() ? entries[i].value : T();
+    }
+
+    std::pair<iterator,bool> insert(const std::pair<int,T> &kv) {
+      const int id = kv.first;
+      size_t pos = locate(id);
+      if (pos < entries.size())
+        return std::pair<iterator,bool>(iterator(this, pos), false);
+
+      if (!count)
+        entries.clear(), lo = 0;
+      else if (entries.size() >= 64 && entries.size() > 2 * count)
+        compact();
+
+      if (entries.empty() || entries.back().id < id) {
+        pos = entries.size();
+        entries.push_back(entry());
+      } else {
+        pos = std::lower_bound(entries.begin(), entries.end(), id, id_less) - entries.begin();
+        if (entries[pos].id == id) {
+          // Its own erased entry, still in place
+        } else if (pos && !entries[pos - 1].value) {
+          --pos; // An erased entry between the neighbours can take the new ID without reordering
+        } else {
+          entries.insert(entries.begin() + pos, entry());
+          if (!index.empty()) index_shift(pos);
+        }
+      }
+      entries[pos].id = id;
+      entries[pos].value = kv.second;
+      if (!count || pos < lo) lo = pos;
+      ++count;
+
+      if (2 * count > index.size())
+        reindex();
+      else
+        index_add(pos);
+      return std::pair<iterator,bool>(iterator(this, pos), true);
+    }
+
+    size_t erase(int id) {
+      const size_t pos = locate(id);
+      if (pos >= entries.size())
+        return 0;
+      index_remove(id);
+      entries[pos].value = T();
+      if (!--count)
+        entries.clear(), lo = 0;
+      else if (pos == lo)
+        lo = next_live(lo);
+      return 1;
+    }
+    void erase(const iterator &it) { if (it.pos < entries.size()) erase(entries[it.pos].id); }
+
+    iterator find(int id) const { return iterator(this, locate(id)); }
+    iterator begin() const { return iterator(this, count ? lo : entries.size()); }
+    iterator end() const { return iterator(); }
+
+    size_t size() const { return count; }
+    bool empty() const { return !count; }
+    void clear() { entries.clear(); index.clear(); lo = count = 0; }
+
+    instance_id_table(): lo(0), count(0) {}
+  };
+}
+
+#endif
@@ -27,7 +27,6 @@ namespace enigma {
     enigma::inst_iter temp_iter;
     enigma::inst_iter* it;
 
-    void addme();
     void copy(const iterator& other);
 
    public:
@@ -35,8 +34,6 @@ namespace enigma {
     object_basic* operator*() const;
     object_basic* operator->() const;
     
-    void handle_unlink(const inst_iter* dead);
-    
     iterator &operator++();
     iterator operator++(int);
     iterator &operator--();
@@ -50,8 +47,6 @@ namespace enigma {
     iterator(inst_iter*);
     iterator(object_basic*);
     iterator();
-    
-    ~iterator();
 
     class with;
   };
@@ -61,7 +56,6 @@ namespace enigma {
     with(const iterator& push): iterator(push), iterator_level(it) {}
   };
   
-  void update_iterators_for_destroy(const inst_iter*);
   iterator instance_list_first();
   iterator fetch_inst_iter_by_id(int id);
   iterator fetch_inst_iter_by_int(int x);
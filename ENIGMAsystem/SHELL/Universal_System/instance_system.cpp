@@ -18,6 +18,7 @@
 **/
 
 #include <map>
+#include <algorithm>
 #include <deque>
 #include <set>
 #include <math.h>
@@ -41,8 +42,96 @@ extern deque<int> instance_id; // TODO: Implement and move to enigma_user.
 namespace enigma
 {
   inst_iter::inst_iter(object_basic* i,inst_iter *n = NULL,inst_iter *p = NULL):
-      inst(i), next(n), prev(p) {}
-  inst_iter::inst_iter() {}
+      inst(i), next(n), prev(p), dead(false) {}
+  inst_iter::inst_iter(): dead(false) {}
+
+
+  /*------ Node pool ---------------------------------------------------------*\
+  \*--------------------------------------------------------------------------*/
+
+  // Every instance owns one node per list it is on (one per event it handles,
+  // one per object in its ancestry, one for its depth layer), so nodes are
+  // carved out of fixed-size blocks and recycled through a free list. Blocks
+  // go back to the heap only through inst_iter_pool_trim(), at room end.
+  // Derived list heads (event_iter, objectid_base) are a different size and
+  // fall through to the regular heap.
+
+  static const size_t inst_iter_block_size = 256;
+  struct inst_iter_free_node { inst_iter_free_node *next; };
+  static vector<inst_iter*> inst_iter_blocks;
+  static inst_iter_free_node *inst_iter_free_list = NULL;
+  static size_t inst_iter_live = 0;
+  static vector<inst_iter*> inst_iter_retired;
+
+  void *inst_iter::operator new(size_t size) {
+    if (size != sizeof(inst_iter))
+      return ::operator new(size);
+    if (!inst_iter_free_list) {
+      inst_iter *block = static_cast<inst_iter*>(::operator new(inst_iter_block_size * sizeof(inst_iter)));
+      inst_iter_blocks.push_back(block);
+      for (size_t i = inst_iter_block_size; i--; ) {
+        inst_iter_free_node *n = reinterpret_cast<inst_iter_free_node*>(block + i);
+        n->next = inst_iter_free_list;
+        inst_iter_free_list = n;
+      }
+    }
+    inst_iter_free_node *n = inst_iter_free_list;
+    inst_iter_free_list = n->next;
+    ++inst_iter_live;
+    return n;
+  }
+
+  void inst_iter::operator delete(void *p, size_t size) {
+    if (!p) return;
+    if (size != sizeof(inst_iter))
+      return ::operator delete(p);
+    inst_iter_free_node *n = static_cast<inst_iter_free_node*>(p);
+    n->next = inst_iter_free_list;
+    inst_iter_free_list = n;
+    --inst_iter_live;
+  }
+
+  void retire_inst_iter(inst_iter *node) {
+    if (node) inst_iter_retired.push_back(node);
+  }
+
+  size_t inst_iter_pool_live() {
+    return inst_iter_live;
+  }
+  size_t inst_iter_pool_capacity() {
+    return inst_iter_blocks.size() * inst_iter_block_size;
+  }
+
+  void inst_iter_pool_trim() {
+    if (inst_iter_blocks.empty()) return;
+    sort(inst_iter_blocks.begin(), inst_iter_blocks.end());
+
+    // Count the free nodes in each block, by address.
+    vector<size_t> free_count(inst_iter_blocks.size(), 0);
+    for (inst_iter_free_node *n = inst_iter_free_list; n; n = n->next) {
+      inst_iter *const node = reinterpret_cast<inst_iter*>(n);
+      const size_t b = upper_bound(inst_iter_blocks.begin(), inst_iter_blocks.end(), node) - inst_iter_blocks.begin() - 1;
+      ++free_count[b];
+    }
+
+    // Rebuild the free list from the blocks still in use, and release the rest.
+    vector<inst_iter*> kept;
+    inst_iter_free_node **tail = &inst_iter_free_list;
+    for (inst_iter_free_node *n = inst_iter_free_list; n; n = n->next) {
+      inst_iter *const node = reinterpret_cast<inst_iter*>(n);
+      const size_t b = upper_bound(inst_iter_blocks.begin(), inst_iter_blocks.end(), node) - inst_iter_blocks.begin() - 1;
+      if (free_count[b] != inst_iter_block_size)
+        *tail = n, tail = &n->next;
+    }
+    *tail = NULL;
+    for (size_t b = 0; b < inst_iter_blocks.size(); ++b) {
+      if (free_count[b] == inst_iter_block_size)
+        ::operator delete(inst_iter_blocks[b]);
+      else
+        kept.push_back(inst_iter_blocks[b]);
+    }
+    inst_iter_blocks.swap(kept);
+  }
   
   objectid_base::objectid_base(): inst_iter(NULL,NULL,this), count(0) {}
   event_iter::event_iter(string n): inst_iter(NULL,NULL,this), name(n) {}
@@ -52,16 +141,15 @@ namespace enigma
   /*------ New iterator system -----------------------------------------------*\
   \*--------------------------------------------------------------------------*/
 
-  set<iterator*> central_iterator_cache;
-  typedef set<iterator*>::iterator central_iterator_cache_iterator;
+  // Iterators are not registered anywhere. Unlinking a node from a list only
+  // splices its neighbors around it and marks it dead; the node keeps its own
+  // next/prev pointers until it is freed with its instance, so an iterator that
+  // is sitting on it (or on a chain of such nodes) can still walk off of it.
+  // Iterator increment/decrement simply skips over dead nodes.
 
   object_basic* iterator::operator*()  const { return it->inst; }
   object_basic* iterator::operator->() const { return it->inst; }
 
-  void iterator::addme() {
-    central_iterator_cache.insert(this);
-  }
-  
   void iterator::copy(const iterator& other) {
     // If the other pointer indicates its own temporary object, copy
     // it into our temporary object and point to ours, instead.
@@ -70,39 +158,29 @@ namespace enigma
       it = &temp_iter;
     } else {
       // Otherwise, assume the pointer is from one of the global lists.
-      // Registering ourself with the central iterator list will handle
-      // memory management caveats, for us.
+      // Dead nodes stay valid until their instance is freed, so sharing
+      // the pointer is safe.
       it = other.it;
     }
   }
   
-  void iterator::handle_unlink(const inst_iter *dead) {
-    if (it) {
-      if (it->next == dead) {
-        it->next = dead->next;
-      } else if (it->prev == dead) {
-        it->prev = dead->prev;
-      }
-    }
-  }
-
   iterator::operator bool() { return it; }
   iterator &iterator::operator++() {
-    it = it->next;
+    do it = it->next; while (it && it->dead);
     return *this;
   }
   iterator  iterator::operator++(int) {
     iterator ret(*this);
-    it = it->next;
+    ++*this;
     return ret;
   }
   iterator &iterator::operator--() {
-    it = it->prev;
+    do it = it->prev; while (it && it->dead);
     return *this;
   }
   iterator  iterator::operator--(int) {
     iterator ret(*this);
-    it = it->prev;
+    --*this;
     return ret;
   }
 
@@ -121,34 +199,13 @@ namespace enigma
     return *this;
   }
   
-  // Always add ourself to the central iterator cache, because future
-  // assignment could cause us to point to something deleteable
-  iterator::iterator(): it(NULL) {
-    addme();
-  }
+  iterator::iterator(): it(NULL) {}
   iterator::iterator(const iterator& other) {
     copy(other);
-    addme();
-  }
-  iterator::iterator(inst_iter* iter): it(iter) {
-    addme();
   }
+  iterator::iterator(inst_iter* iter): it(iter) {}
   iterator::iterator(object_basic* ob):
-      temp_iter(ob, NULL, NULL), it(&temp_iter) {
-    addme();
-  }
-
-  iterator:: ~iterator() {
-    central_iterator_cache.erase(this);
-  }
-
-  void update_iterators_for_destroy(const inst_iter* dd)
-  {
-    for (central_iterator_cache_iterator it = central_iterator_cache.begin();
-         it != central_iterator_cache.end(); ++it) {
-      (*it)->handle_unlink(dd);
-    }
-  }
+      temp_iter(ob, NULL, NULL), it(&temp_iter) {}
 
 
   /*------Iterator methods ---------------------------------------------------*\
@@ -168,7 +225,7 @@ namespace enigma
     if (which->next) which->next->prev = which->prev;
     if (prev == which) prev = which->prev; // If our last item is this, decrement our last item.
     if (next == which) next = NULL; // If our first item is this, we have no item.
-    update_iterators_for_destroy(which);
+    which->dead = true;
   }
 
   inst_iter *objectid_base::add_inst(object_basic* ninst)
@@ -186,7 +243,7 @@ namespace enigma
     objectid_base *a = objects + oid;
     if (a->prev == which) a->prev = which->prev;
     a->count--;
-    update_iterators_for_destroy(which);
+    which->dead = true;
   }
 
   /* **  Variables ** */
@@ -196,12 +253,15 @@ namespace enigma
   // Through these, we will list objects by object_index, and implement heredity.
   objectid_base *objects;
 
-  // This is the all-inclusive, centralized list of instances.
-  map<int,inst_iter*> instance_list;
-  map<int,object_basic*> instance_deactivated_list;
-  typedef map<int,inst_iter*>::iterator iliter;
+  // This is the all-inclusive, centralized list of instances, indexed by ID.
+  // The nodes it holds are also linked to each other in order of ID.
+  instance_id_table<inst_iter*> instance_list;
+  instance_id_table<object_basic*> instance_deactivated_list;
   typedef pair<int,inst_iter*> inode_pair;
 
+  // The node with the greatest ID; new instances almost always link after it.
+  static inst_iter *instance_list_last = NULL;
+
 
 
   // When you say "global.vname", this is the structure that answers
@@ -225,8 +285,7 @@ namespace enigma
   // Retrieve the first instance on the complete list.
   iterator instance_list_first()
   {
-    iliter a = instance_list.begin();
-    return a != instance_list.end() ? a->second : NULL;
+    return instance_list.begin()->second;
   }
 
   extern size_t object_idmax;
@@ -249,13 +308,13 @@ namespace enigma
     if (x < 100000)
       return x < object_idmax ? objects[x].next ? objects[x].next->inst : NULL : NULL;
 
-    iliter a = instance_list.find(x);
-    return a != instance_list.end() ? a->second->inst : NULL;
+    inst_iter *a = instance_list.get(x);
+    return a ? a->inst : NULL;
   }
   object_basic* fetch_instance_by_id(int x)
   {
-    iliter a = instance_list.find(x);
-    return a != instance_list.end() ? a->second->inst : NULL;
+    inst_iter *a = instance_list.get(x);
+    return a ? a->inst : NULL;
   }
 
   iterator fetch_inst_iter_by_int(int x)
@@ -277,16 +336,16 @@ namespace enigma
       return objects[x].next;
 
     // ID-based lookup
-    iliter a = instance_list.find(x);
-    return a != instance_list.end() ? iterator(a->second->inst) : iterator();
+    inst_iter *a = instance_list.get(x);
+    return a ? iterator(a->inst) : iterator();
   }
   iterator fetch_inst_iter_by_id(int x)
   {
     if (x < 100000)
       return iterator();
 
-    iliter a = instance_list.find(x);
-    return a != instance_list.end() ? iterator(a->second->inst) : iterator();
+    inst_iter *a = instance_list.get(x);
+    return a ? iterator(a->inst) : iterator();
   }
 
   iterator fetch_roominst_iter_by_id(int x)
@@ -295,21 +354,15 @@ namespace enigma
       return iterator();
 
     //Check if it's a deactivated instance first.
-    std::map<int,enigma::object_basic*>::iterator rIt = enigma::instance_deactivated_list.find(x);
-    if (rIt!=enigma::instance_deactivated_list.end()) {
-      return iterator(rIt->second);
+    object_basic *deactivated = instance_deactivated_list.get(x);
+    if (deactivated) {
+      return iterator(deactivated);
     }
 
     //Else, it's still live (or was null). Use normal dispatch.
     return fetch_inst_iter_by_id(x);
   }
 
-  // Implementation for frontend
-  // (Wrapper struct to lower compile time)
-  typedef struct winstance_list_iterator {
-    instance_list_iterator w;
-    winstance_list_iterator(instance_list_iterator n): w(n) {}
-  } *pinstance_list_iterator;
   void winstance_list_iterator_delete(pinstance_list_iterator whop) {
     delete whop;
   }
@@ -319,27 +372,18 @@ namespace enigma
   {
     inst_iter *ins = new inst_iter(who);
     instance_id.push_back(who->id);
-    pair<iliter,bool> it = instance_list.insert(inode_pair(who->id,ins));
-    if (!it.second) {
-      delete ins;
-      return new winstance_list_iterator(it.first);
-    }
-    if (it.first != instance_list.begin())
-    {
-      iliter ib = it.first; ib--; // Find the previous iterator
-      ins->prev = ib->second; // Link this to previous instance
-      ib->second->next = ins; // Link previous instance to this
+    if (!instance_list.insert(inode_pair(who->id,ins)).second) {
+      ins->dead = true; // Duplicate ID; hand back a node that is on no list.
+      return ins;
     }
-    else ins->prev = NULL; // Found nothing.
-
-    iliter in = it.first; in++; // Find next iterator
-    if (in != instance_list.end())
-    {
-      ins->next = in->second, // Link this to next instance
-      in->second->prev = ins; // Link next to this
-    }
-    else ins->next = NULL;
-    return new winstance_list_iterator(it.first);
+    inst_iter *ib = !instance_list_last || instance_list_last->inst->id < who->id
+        ? instance_list_last : instance_list.before(who->id);
+    ins->prev = ib; // Link this to previous instance, if any
+    ins->next = ib ? ib->next : instance_list.after(who->id); // Link this to next instance, if any
+    if (ib) ib->next = ins; // Link previous instance to this
+    if (ins->next) ins->next->prev = ins; // Link next to this
+    else instance_list_last = ins;
+    return ins;
   }
   inst_iter *link_obj_instance(object_basic* who, int oid)
   {
@@ -358,21 +402,17 @@ namespace enigma
     for (set<object_basic*>::iterator i = cleanups.begin(); i != cleanups.end(); i++)
       delete (*i);
     cleanups.clear();
+    for (size_t i = 0; i < inst_iter_retired.size(); i++)
+      delete inst_iter_retired[i];
+    inst_iter_retired.clear();
   }
-  void unlink_main(instance_list_iterator who)
-  {
-    inst_iter *a = who->second;
-    if (a->prev) a->prev->next = a->next;
-    if (a->next) a->next->prev = a->prev;
-    instance_list.erase(who);
-    update_iterators_for_destroy(a);
-  }
-  void unlink_main(pinstance_list_iterator whop)
+  void unlink_main(pinstance_list_iterator a)
   {
-    inst_iter *a = whop->w->second;
+    if (instance_list.get(a->inst->id) != a) return;
     if (a->prev) a->prev->next = a->next;
     if (a->next) a->next->prev = a->prev;
-    instance_list.erase(whop->w);
-    update_iterators_for_destroy(a);
+    if (instance_list_last == a) instance_list_last = a->prev;
+    instance_list.erase(a->inst->id);
+    a->dead = true;
   }
 }
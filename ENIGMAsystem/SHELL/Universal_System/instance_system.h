@@ -30,16 +30,13 @@
 #error This file is high-impact and should not be included from SHELLmain.cpp.
 #endif
 
-#include <map>
 #include <set>
+#include "instance_id_table.h"
 
 namespace enigma {
-  typedef std::map<int,inst_iter*>::iterator instance_list_iterator;
-  extern std::map<int,inst_iter*> instance_list;
-  extern std::map<int,object_basic*> instance_deactivated_list;
+  extern instance_id_table<inst_iter*> instance_list;
+  extern instance_id_table<object_basic*> instance_deactivated_list;
   extern std::set<object_basic*> cleanups;
-  
-  void unlink_main(instance_list_iterator who);
 }
 
 #endif
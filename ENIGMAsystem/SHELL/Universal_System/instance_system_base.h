@@ -19,6 +19,8 @@
 #ifndef INSTANCE_SYSTEM_BASE_h
 #define INSTANCE_SYSTEM_BASE_h
 
+#include <cstddef>
+
 namespace enigma
 {
   typedef int instance_t;
@@ -27,10 +29,14 @@ namespace enigma
   {
     object_basic* inst;     // Inst is first member for non-arithmetic dereference
     inst_iter *next, *prev; // Double linked for active removal
-    bool dead;              // Whether or not this instance has been destroyed. Should be accessed rarely.
+    bool dead;              // Set when this node is unlinked from its list; iterators skip over it.
     //std::deque<inst_iter*>::iterator instance_id_index;
     inst_iter(object_basic* i,inst_iter *n,inst_iter *p);
     inst_iter();
+
+    // Nodes are carved from a shared pool rather than the general heap.
+    static void *operator new(size_t size);
+    static void operator delete(void *p, size_t size);
   };
 
   class temp_event_scope
@@ -94,6 +100,12 @@ namespace enigma
 
   object_basic* fetch_instance_by_int(int x);
   object_basic* fetch_instance_by_id(int x);
+
+  // Node pool bookkeeping.
+  void retire_inst_iter(inst_iter*); // Frees an unlinked node once the current step is over
+  size_t inst_iter_pool_live();      // Nodes currently handed out
+  size_t inst_iter_pool_capacity();  // Nodes allocated from the heap, live or free
+  void inst_iter_pool_trim();        // Returns wholly free blocks to the heap
 }
 
 // Other
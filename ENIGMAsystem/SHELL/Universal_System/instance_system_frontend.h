@@ -26,11 +26,15 @@
 \********************************************************************************/
 
 #include "instance_system_base.h"
+#include "instance_id_table.h"
 
 namespace enigma
 {
-  // This is an iterator typedef for use with the red-black backbone of the instance list.
-  typedef struct winstance_list_iterator *pinstance_list_iterator;
+  // Instances which are deactivated, by ID.
+  extern instance_id_table<object_basic*> instance_deactivated_list;
+
+  // This is the node an instance occupies in the ID-ordered list of all instances.
+  typedef inst_iter *pinstance_list_iterator;
   void winstance_list_iterator_delete(pinstance_list_iterator);
 
   // Linking
@@ -28,9 +28,7 @@
 #ifndef _H_LUA_TABLE
 #define _H_LUA_TABLE
 
-#include <map>      // Sparse part
-#include <string.h> // Memcpy
-#include <stdlib.h> // Malloc, Realloc, Free
+#include <stddef.h>
 
 #ifdef INCLUDED_FROM_SHELLMAIN
 #error This file is high-impact and should not be included from SHELLmain.cpp.
@@ -38,19 +36,12 @@
 
 /**
   This file implements a Lua-table-like structure. It borrows ideas not only from 
-  Lua, but from STL containers. It also borrows the entirety of std::map. This should
-  be replaced with a sparse hash map container when it's a "good time" to do so.
-  
-  By ENIGMA-defined standard, this table class takes up sizeof(void*) bytes. The class
-  itself contains a single pointer to a dense part (dynamic array). This ctually points
-  to a fixed-length position from the beginning of an allocated block. At the beginning
-  of this block is precisely enough room for the table's map component. The implication
-  is that the dense segment can be dereferenced without additional arithmetic (by unary
-  operator*), while the map section requires taking dense[-sizeof(map)],  where `dense`
-  has been cast to char*, then casting back to maptype*.
-
-  NOTE: Memory layout is something like this:
-    <sparse_map><dense_length><max_elem+1><dense_elem[0],dense_elem[1],...>
+  Lua, but from STL containers. Each table has a dense part, a dynamic array holding
+  the indices from zero up, and a sparse part for indices far beyond it, which is an
+  open addressing hash map (lua_sparse, below).
+
+  lua_grid is the two dimensional version used by var: a single row-major dense block,
+  with the same kind of sparse map for cells too far outside it.
 */
 
 namespace {
@@ -61,10 +52,142 @@ T my_max(const T& lhs, const T& rhs) {
 }
 
 
+// Hash map from integer keys, with linear probing, for the far-flung elements of a table.
+template <class T> class lua_sparse
+{
+  typedef unsigned long long key_type;
+
+  struct slot {
+    key_type key;
+    bool used;
+    T value;
+    slot(): key(0), used(false), value() {}
+  };
+
+  slot* slots;
+  size_t cap;   //Always zero or a power of two.
+  size_t count;
+
+  static size_t hash(key_type k) {
+    k ^= k >> 33;
+    k *= 0xFF51AFD7ED558CCDULL;
+    k ^= k >> 33;
+    return size_t(k);
+  }
+
+  //The slot holding key, or the empty slot where it would go.
+  size_t probe(key_type key) const {
+    size_t i = hash(key) & (cap - 1);
+    while (slots[i].used && slots[i].key != key)
+      i = (i + 1) & (cap - 1);
+    return i;
+  }
+
+  void place(key_type key, const T& value) {
+    slot &s = slots[probe(key)];
+    s.key = key;
+    s.used = true;
+    s.value = value;
+    count++;
+  }
+
+  //Rebuilds the table at the given capacity, keeping the entries for which keep returns true.
+  template <class F> void rebuild(size_t c, F &keep)
+  {
+    slot* old = slots;
+    const size_t old_cap = cap;
+    slots = new slot[c];
+    cap = c;
+    count = 0;
+    for (size_t i = 0; i < old_cap; i++) {
+      if (old[i].used && keep(old[i].key, old[i].value)) {
+        place(old[i].key, old[i].value);
+      }
+    }
+    delete [] old;
+  }
+
+  struct keep_all {
+    bool operator() (key_type, T&) const { return true; }
+  };
+  template <class F> struct untaken {
+    F &take;
+    untaken(F &f): take(f) {}
+    bool operator() (key_type key, T& value) { return !take(key, value); }
+  };
+
+  void pick_up(const lua_sparse<T>& who)
+  {
+    if (slots) {
+      delete [] slots;
+      slots = NULL;
+    }
+    cap = who.cap;
+    count = who.count;
+    if (cap) {
+      slots = new slot[cap];
+      for (size_t i = 0; i < cap; i++) {
+        slots[i] = who.slots[i];
+      }
+    }
+  }
+
+public:
+  T& operator[] (key_type key)
+  {
+    if ((count + 1) * 4 > cap * 3) {
+      keep_all all;
+      rebuild(cap ? cap << 1 : 8, all);
+    }
+    slot &s = slots[probe(key)];
+    if (!s.used) {
+      s.key = key;
+      s.used = true;
+      count++;
+    }
+    return s.value;
+  }
+
+  const T* find(key_type key) const
+  {
+    if (!count) return NULL;
+    const slot &s = slots[probe(key)];
+    return s.used ? &s.value : NULL;
+  }
+
+  //Removes every entry for which take(key, value) returns true; take may keep the value.
+  template <class F> void claim(F &take)
+  {
+    if (!count) return;
+    untaken<F> keep(take);
+    rebuild(cap, keep);
+  }
+
+  size_t size() const {
+    return count;
+  }
+
+  lua_sparse<T>& operator= (const lua_sparse<T>& x)
+  {
+    if (this != &x) pick_up(x);
+    return *this;
+  }
+
+  lua_sparse<T>(): slots(NULL), cap(0), count(0) {
+  }
+  lua_sparse<T>(const lua_sparse<T> &x): slots(NULL), cap(0), count(0) {
+    pick_up(x);
+  }
+  ~lua_sparse<T>() {
+    if (slots) { delete [] slots; }
+  }
+};
+
+
 template <class T> struct lua_table
 {
   // This is what kind of sparse container we'll be using
-  typedef std::map<size_t,T> lua_map_type;
+  typedef lua_sparse<T> lua_map_type;
 
 private:
   //Stuff relating to dense storage.
@@ -90,7 +213,7 @@ private:
     }
 
     //Create a new dense chunk, copy over values.
-    dense = new T[dn_reserve];
+    dense = new T[dn_reserve]();
     for (size_t i=0; i<dn_reserve; i++) {
       dense[i] = who.dense[i];
     }
@@ -99,10 +222,21 @@ private:
     sparse = who.sparse;
   }
 
+  //Moves sparse values that now fall within the dense reserve into it.
+  struct settle {
+    lua_table<T> &t;
+    settle(lua_table<T> &tbl): t(tbl) {}
+    bool operator() (unsigned long long key, T& value) {
+      if (key >= t.dn_reserve) return false;
+      t.dense[key] = value;
+      return true;
+    }
+  };
+
   void upsize(const size_t c)
   {
     //Create a new dense section and copy over values; free old memory.
-    T* new_dense = new T[c];
+    T* new_dense = new T[c]();
     if (dense) { 
       for (size_t i=0; i<dn_reserve; i++) {
         new_dense[i] = dense[i];
@@ -113,13 +247,8 @@ private:
     dn_reserve = c;
 
     //Copy sparse array values that are now within this reserve space.
-    for (typename lua_map_type::iterator it=sparse.begin(); it!=sparse.end();) {
-      if (it->first >= c) {
-        break;
-      }
-      dense[it->first] = it->second;
-      sparse.erase(it++);
-    }
+    settle into(*this);
+    sparse.claim(into);
   }
   
 
@@ -147,6 +276,14 @@ public:
     return dense[0];
   }
 
+  // Looks up an element without creating it; NULL if it was never touched.
+  const T* find(size_t ind) const
+  {
+    if (ind >= mx_size) return NULL;
+    if (ind < dn_reserve) return dense + ind;
+    return sparse.find(ind);
+  }
+
   int max_index() const {
     return mx_size;
   }
@@ -157,7 +294,7 @@ public:
     return *this;
   }
   
-  lua_table<T>() : dense(new T[1]), dn_reserve(1), mx_size(1) {
+  lua_table<T>() : dense(new T[1]()), dn_reserve(1), mx_size(1) {
   }
   lua_table<T>(const lua_table<T> &x): dense(NULL), dn_reserve(0), mx_size(0) {
     pick_up(x);
@@ -167,4 +304,193 @@ public:
   }
 };
 
+
+// The dense block only grows to an area at most twice the cells in use, unless it stays under
+// lua_grid_free_area; other cells go to the sparse map. Indices past lua_grid_max_extent are
+// always sparse.
+static const size_t lua_grid_free_area = 1 << 16;
+static const size_t lua_grid_max_extent = 1 << 24;
+
+/**
+  A two dimensional table. Cells live in one row-major block, (row, col) at
+  dense[row * dn_cols + col], which grows by doubling; only rows and columns indexed by an
+  int are supported. Each row records one more than the last column touched in it, which
+  is what a GML array reports as that row's length.
+*/
+template <class T> class lua_grid
+{
+  T* dense;
+  size_t dn_rows, dn_cols;
+
+  lua_table<size_t> lengths; //Per row; zero for rows never touched. Its max_index is the height.
+  lua_sparse<T> sparse;      //Cells outside the dense block.
+  size_t covered;            //Cells of the dense block that lie within their row's length.
+
+  static unsigned long long key(size_t row, size_t col) {
+    return (unsigned long long)(row & 0xFFFFFFFF) << 32 | (col & 0xFFFFFFFF);
+  }
+
+  size_t in_block(size_t len) const {
+    return len < dn_cols ? len : dn_cols;
+  }
+
+  void touch(size_t row, size_t end) {
+    size_t &len = lengths[row];
+    if (end <= len) return;
+    if (row < dn_rows) covered += in_block(end) - in_block(len);
+    len = end;
+  }
+
+  struct settle {
+    lua_grid<T> &g;
+    settle(lua_grid<T> &grid): g(grid) {}
+    bool operator() (unsigned long long k, T& value) {
+      const size_t row = size_t(k >> 32), col = size_t(k & 0xFFFFFFFF);
+      if (row >= g.dn_rows || col >= g.dn_cols) return false;
+      g.dense[row * g.dn_cols + col] = value;
+      return true;
+    }
+  };
+
+  struct clip {
+    unsigned long long row, from;
+    clip(size_t r, size_t c): row(r & 0xFFFFFFFF), from(c) {}
+    bool operator() (unsigned long long k, T&) const {
+      return (k >> 32) == row && (k & 0xFFFFFFFF) >= from;
+    }
+  };
+
+  //Grows the dense block to cover (row, col), if it can do so without getting too sparse.
+  //Extra is a number of cells the caller is about to fill, which the block may also grow by.
+  bool grow_for(size_t row, size_t col, size_t extra)
+  {
+    if (row >= lua_grid_max_extent || col >= lua_grid_max_extent)
+      return false;
+    const size_t rows = row < dn_rows ? dn_rows : my_max(row + 1, dn_rows * 2),
+                 cols = col < dn_cols ? dn_cols : my_max(col + 1, my_max(dn_cols * 2, size_t(4)));
+    const unsigned long long area = (unsigned long long)rows * cols,
+        in_use = (unsigned long long)covered + sparse.size() + extra + 1;
+    if (area > lua_grid_free_area && area > 2 * in_use)
+      return false;
+
+    T* new_dense = new T[rows * cols]();
+    for (size_t r = 0; r < dn_rows; r++) {
+      for (size_t c = 0; c < dn_cols; c++) {
+        new_dense[r * cols + c] = dense[r * dn_cols + c];
+      }
+    }
+    if (dense) { delete [] dense; }
+    dense = new_dense;
+    dn_rows = rows;
+    dn_cols = cols;
+
+    covered = 0;
+    for (size_t r = 0; r < dn_rows; r++) {
+      const size_t *len = lengths.find(r);
+      if (len) covered += in_block(*len);
+    }
+
+    settle into(*this);
+    sparse.claim(into);
+    return true;
+  }
+
+  void pick_up(const lua_grid<T>& who)
+  {
+    if (dense) {
+      delete [] dense;
+      dense = NULL;
+    }
+    dn_rows = who.dn_rows;
+    dn_cols = who.dn_cols;
+    if (who.dense) {
+      dense = new T[dn_rows * dn_cols];
+      for (size_t i = 0; i < dn_rows * dn_cols; i++) {
+        dense[i] = who.dense[i];
+      }
+    }
+    lengths = who.lengths;
+    sparse = who.sparse;
+    covered = who.covered;
+  }
+
+public:
+  T& operator() (size_t row, size_t col)
+  {
+    touch(row, col + 1);
+    if ((row < dn_rows && col < dn_cols) || grow_for(row, col, 0))
+      return dense[row * dn_cols + col];
+    return sparse[key(row, col)];
+  }
+
+  // Looks up a cell without creating it; NULL if it was never touched.
+  const T* find(size_t row, size_t col) const
+  {
+    if (row < dn_rows && col < dn_cols)
+      return dense + row * dn_cols + col;
+    return sparse.find(key(row, col));
+  }
+
+  // Makes n cells of a row, starting at col, contiguous and returns the first, or returns
+  // NULL if they are too far out to be worth it. The cells count as touched.
+  T* span(size_t row, size_t col, size_t n)
+  {
+    if (!n) return NULL;
+    const size_t last = col + n - 1;
+    if (last < col || !((row < dn_rows && last < dn_cols) || grow_for(row, last, n)))
+      return NULL;
+    touch(row, col + n);
+    return dense + row * dn_cols + col;
+  }
+
+  // The same for reading; NULL unless all n cells are already in the dense block.
+  const T* span(size_t row, size_t col, size_t n) const
+  {
+    if (row >= dn_rows || col >= dn_cols || n > dn_cols - col)
+      return NULL;
+    return dense + row * dn_cols + col;
+  }
+
+  // Shortens a row to n cells, resetting those past the end.
+  void truncate(size_t row, size_t n)
+  {
+    if (row >= size_t(lengths.max_index())) return;
+    size_t &len = lengths[row];
+    if (len <= n) return;
+    if (row < dn_rows) {
+      for (size_t c = n; c < len && c < dn_cols; c++) {
+        dense[row * dn_cols + c] = T();
+      }
+      covered -= in_block(len) - in_block(n);
+    }
+    clip past(row, n);
+    sparse.claim(past);
+    len = n;
+  }
+
+  int height() const {
+    return lengths.max_index();
+  }
+
+  int width(size_t row) const {
+    const size_t *len = lengths.find(row);
+    return len && *len > 1 ? int(*len) : 1;
+  }
+
+  lua_grid<T>& operator= (const lua_grid<T>& x)
+  {
+    if (this != &x) pick_up(x);
+    return *this;
+  }
+
+  lua_grid<T>(): dense(NULL), dn_rows(0), dn_cols(0), covered(0) {
+  }
+  lua_grid<T>(const lua_grid<T> &x): dense(NULL), dn_rows(0), dn_cols(0), covered(0) {
+    pick_up(x);
+  }
+  ~lua_grid<T>() {
+    if (dense) { delete [] dense; }
+  }
+};
+
 #endif //_H_LUA_TABLE
@@ -30,6 +30,7 @@
 #include "Universal_System/callbacks_events.h"
 #include "libEGMstd.h"
 #include "instance_system.h"
+#include "instance_system_frontend.h"
 #include "instance.h"
 #include "planar_object.h"
 #include "backgroundstruct.h"
@@ -96,6 +97,10 @@ namespace enigma
     
     perform_callbacks_clean_up_roomend();
 
+    // Free the instances that did not persist, and the list nodes they held.
+    dispose_destroyed_instances();
+    inst_iter_pool_trim();
+
     // Set the index to self
     room.rval.d = id;
     room_caption = cap;
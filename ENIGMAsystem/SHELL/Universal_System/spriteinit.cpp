@@ -16,7 +16,9 @@
 **/
 
 #include <string>
+#include <vector>
 #include <stdio.h>
+#include <string.h>
 using namespace std;
 
 #include "spritestruct.h"
@@ -29,25 +31,41 @@ using namespace std;
 
 namespace enigma
 {
-  void exe_loadsprs(FILE *exe)
+  // Copies a subimage into an atlas page with a border of the given width around it. When extruding, the border
+  // repeats the subimage's edge pixels, so that filtering at its edges does not pick up its neighbours.
+  static void atlas_blit(unsigned char *page, unsigned pagew, const unsigned char *pixels, int w, int h, int x, int y, int border, bool extrude)
+  {
+    for (int yy = extrude ? -border : 0; yy < (extrude ? h + border : h); yy++)
+    {
+      const int sy = yy < 0 ? 0 : yy >= h ? h - 1 : yy;
+      const unsigned char *src = pixels + sy*w*4;
+      unsigned char *dst = page + ((y + yy)*pagew + x)*4;
+      memcpy(dst, src, w*4);
+      if (extrude)
+        for (int xx = 1; xx <= border; xx++)
+          memcpy(dst - xx*4, src, 4),
+          memcpy(dst + (w - 1 + xx)*4, src + (w - 1)*4, 4);
+    }
+  }
+
+  struct atlas_subimage {
+    int sprid, subimg, page;
+  };
+
+  struct sprite_atlas {
+    vector<unsigned> w, h;
+    vector<unsigned char*> pixels;
+    int padding;
+    bool extrude;
+    vector<atlas_subimage> subimages; // Those waiting for their page's texture to be created
+  };
+
+  static void load_sprites(FILE *exe, int sprcount, sprite_atlas &atlas)
   {
     int nullhere;
     unsigned sprid, width, height, bbt, bbb, bbl, bbr, shape;
     int xorig, yorig;
     
-    if (!fread(&nullhere,4,1,exe)) return;
-    if (nullhere != *(int*)"SPR ")
-      return;
-    
-    // Determine how many sprites we have
-    int sprcount;
-    if (!fread(&sprcount,4,1,exe)) return;
-    
-    // Fetch the highest ID we will be using
-    int spr_highid;
-    if (!fread(&spr_highid,4,1,exe)) return;
-    sprites_init();
-    
     for (int i = 0; i < sprcount; i++)
     {
       if (!fread(&sprid, 4,1,exe)) return;
@@ -79,6 +97,10 @@ namespace enigma
       sprite_new_empty(sprid, subimages, width, height, xorig, yorig, bbt, bbb, bbl, bbr, 1,0);
       for (int ii=0;ii<subimages;ii++) 
       {
+        int page, pagex, pagey;
+        if (!fread(&page,4,1,exe)) return;
+        if (!fread(&pagex,4,1,exe)) return;
+        if (!fread(&pagey,4,1,exe)) return;
         int unpacked;
         if (!fread(&unpacked,4,1,exe)) return;
         unsigned int size;
@@ -114,7 +136,18 @@ namespace enigma
           default: collision_data = 0; break;
         };
         
-        sprite_set_subimage(sprid, ii, width, height, pixels, collision_data, coll_type);
+        if (page >= 0 && page < int(atlas.pixels.size()) && pagex >= atlas.padding && pagey >= atlas.padding
+            && pagex + width + atlas.padding <= atlas.w[page] && pagey + height + atlas.padding <= atlas.h[page])
+        {
+          atlas_blit(atlas.pixels[page], atlas.w[page], pixels, width, height, pagex, pagey, atlas.padding, atlas.extrude);
+          const texture_rect region = {double(pagex)/atlas.w[page], double(pagey)/atlas.h[page],
+                                       double(pagex + width)/atlas.w[page], double(pagey + height)/atlas.h[page]};
+          sprite_set_subimage_region(sprid, ii, -1, region, collision_data, coll_type);
+          const atlas_subimage as = {int(sprid), int(spritestructarray[sprid]->texturearray.size()) - 1, page};
+          atlas.subimages.push_back(as);
+        }
+        else
+          sprite_set_subimage(sprid, ii, width, height, pixels, collision_data, coll_type);
         
         delete[] pixels;
         if (!fread(&nullhere,4,1,exe)) return;
@@ -127,4 +160,53 @@ namespace enigma
       }
     }
   }
+
+  void exe_loadsprs(FILE *exe)
+  {
+    int nullhere;
+    
+    if (!fread(&nullhere,4,1,exe)) return;
+    if (nullhere != *(int*)"SPR ")
+      return;
+    
+    // Determine how many sprites we have
+    int sprcount;
+    if (!fread(&sprcount,4,1,exe)) return;
+    
+    // Fetch the highest ID we will be using
+    int spr_highid;
+    if (!fread(&spr_highid,4,1,exe)) return;
+    sprites_init();
+    
+    // The compiler packs small subimages into shared atlas pages, which are assembled here as the sprites load
+    int pagecount, padding, extrude;
+    if (!fread(&pagecount,4,1,exe)) return;
+    if (!fread(&padding,4,1,exe)) return;
+    if (!fread(&extrude,4,1,exe)) return;
+    sprite_atlas atlas;
+    atlas.padding = padding;
+    atlas.extrude = extrude;
+    for (int i = 0; i < pagecount; i++)
+    {
+      unsigned w, h;
+      if (!fread(&w,4,1,exe)) break;
+      if (!fread(&h,4,1,exe)) break;
+      atlas.w.push_back(w);
+      atlas.h.push_back(h);
+      atlas.pixels.push_back(new unsigned char[w*h*4]());
+    }
+    
+    load_sprites(exe, sprcount, atlas);
+    
+    // Even if loading stopped early, the subimages already placed need their pages
+    vector<int> pagetex(atlas.pixels.size());
+    for (size_t i = 0; i < atlas.pixels.size(); i++)
+    {
+      pagetex[i] = graphics_create_texture(atlas.w[i], atlas.h[i], atlas.w[i], atlas.h[i], atlas.pixels[i], false);
+      sprite_add_atlas_page(pagetex[i]);
+      delete[] atlas.pixels[i];
+    }
+    for (size_t i = 0; i < atlas.subimages.size(); i++)
+      spritestructarray[atlas.subimages[i].sprid]->texturearray[atlas.subimages[i].subimg] = pagetex[atlas.subimages[i].page];
+  }
 }
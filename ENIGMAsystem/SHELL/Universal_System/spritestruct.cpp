@@ -29,6 +29,7 @@ using namespace std;
 #include "libEGMstd.h"
 #include "image_formats.h"
 #include "estring.h"
+#include "nlpo2.h"
 
 #define get_current_instance() \
     ((enigma::object_graphics*) enigma::instance_event_iterator->inst)
@@ -57,8 +58,68 @@ bool get_sprite_mtx(enigma::sprite* &spr, int id)
 namespace enigma {
   sprite** spritestructarray;
   extern size_t sprite_idmax;
+  unsigned sprite_bbox_serial = 0;
   sprite::sprite() {}
   sprite::sprite(int x) {}
+
+  static vector<int> atlas_pages;
+
+  void sprite_add_atlas_page(int texture) {
+    atlas_pages.push_back(texture);
+  }
+
+  bool sprite_texture_is_atlas_page(int texture) {
+    for (size_t i = 0; i < atlas_pages.size(); i++)
+      if (atlas_pages[i] == texture) return true;
+    return false;
+  }
+
+  void sprite_free_texture(int texture) {
+    if (!sprite_texture_is_atlas_page(texture))
+      graphics_delete_texture(texture);
+  }
+
+  // Copies made of a sprite share its atlas pages rather than duplicating them.
+  static int sprite_copy_texture(int texture) {
+    return sprite_texture_is_atlas_page(texture) ? texture : graphics_duplicate_texture(texture);
+  }
+
+  // Copies a subimage out of its atlas page, padded to a power of two as it would be in a texture of its own.
+  static unsigned char* atlas_crop(const sprite *spr, int subimg, unsigned *w, unsigned *h, unsigned *fullwidth, unsigned *fullheight)
+  {
+    unsigned pagew, pageh;
+    unsigned char *page = graphics_get_texture_pixeldata(spr->texturearray[subimg], &pagew, &pageh);
+    const texture_rect &tr = spr->texrectarray[subimg];
+    const unsigned x = unsigned(tr.left*pagew + .5), y = unsigned(tr.top*pageh + .5);
+    *w = unsigned((tr.right - tr.left)*pagew + .5), *h = unsigned((tr.bottom - tr.top)*pageh + .5);
+    *fullwidth = nlpo2dc(*w) + 1, *fullheight = nlpo2dc(*h) + 1;
+
+    unsigned char *pixels = new unsigned char[(*fullwidth)*(*fullheight)*4]();
+    for (unsigned row = 0; row < *h; row++)
+      memcpy(pixels + row*(*fullwidth)*4, page + ((y + row)*pagew + x)*4, (*w)*4);
+    delete[] page;
+    return pixels;
+  }
+
+  unsigned char* sprite_get_subimage_pixeldata(const sprite *spr, int subimg, unsigned *fullwidth, unsigned *fullheight)
+  {
+    if (!sprite_texture_is_atlas_page(spr->texturearray[subimg]))
+      return graphics_get_texture_pixeldata(spr->texturearray[subimg], fullwidth, fullheight);
+    unsigned w, h;
+    return atlas_crop(spr, subimg, &w, &h, fullwidth, fullheight);
+  }
+
+  void sprite_unpack_subimage(sprite *spr, int subimg)
+  {
+    if (!sprite_texture_is_atlas_page(spr->texturearray[subimg]))
+      return;
+    unsigned w, h, fw, fh;
+    unsigned char *pixels = atlas_crop(spr, subimg, &w, &h, &fw, &fh);
+    spr->texturearray[subimg] = graphics_create_texture(w, h, fw, fh, pixels, false);
+    const texture_rect tr = {0, 0, double(w)/fw, double(h)/fh};
+    spr->texrectarray[subimg] = tr;
+    delete[] pixels;
+  }
 }
 
 namespace enigma_user
@@ -85,13 +146,12 @@ bool sprite_replace(int ind, string filename, int imgnumb, bool precise, bool tr
 
   if (free_texture) {
     for (int ii = 0; ii < spr->subcount; ii++) {
-      enigma::graphics_delete_texture(spr->texturearray[ii]);
+      enigma::sprite_free_texture(spr->texturearray[ii]);
     }
   }
 
   spr->texturearray.clear();
-  spr->texbordxarray.clear();
-  spr->texbordyarray.clear();
+  spr->texrectarray.clear();
   enigma::sprite_add_to_index(spr, filename, imgnumb, precise, transparent,
       smooth, x_offset, y_offset, mipmap);
   return true;
@@ -114,7 +174,7 @@ void sprite_save(int ind, unsigned subimg, string fname) {
 
   unsigned w, h;
   unsigned char* rgbdata =
-      enigma::graphics_get_texture_pixeldata(spr->texturearray[subimg], &w, &h);
+      enigma::sprite_get_subimage_pixeldata(spr, subimg, &w, &h);
 
   enigma::image_save(fname, rgbdata, spr->width, spr->height, w, h, false);
 
@@ -133,10 +193,11 @@ void sprite_delete(int ind, bool free_texture)
 
   if (free_texture)
     for (int ii = 0; ii < spr->subcount; ii++)
-      enigma::graphics_delete_texture(spr->texturearray[ii]);
+      enigma::sprite_free_texture(spr->texturearray[ii]);
 
   delete enigma::spritestructarray[ind];
   enigma::spritestructarray[ind] = NULL;
+  enigma::sprite_bbox_serial++;
 }
 
 int sprite_duplicate(int copy_sprite)
@@ -162,11 +223,10 @@ void sprite_assign(int ind, int copy_sprite, bool free_texture)
 
   if (free_texture)
     for (int ii = 0; ii < spr->subcount; ii++)
-      enigma::graphics_delete_texture(spr->texturearray[ii]);
+      enigma::sprite_free_texture(spr->texturearray[ii]);
 
   spr->texturearray.clear();
-  spr->texbordxarray.clear();
-  spr->texbordyarray.clear();
+  spr->texrectarray.clear();
   enigma::sprite_add_copy(spr, spr_copy);
 }
 
@@ -178,8 +238,11 @@ void sprite_set_alpha_from_sprite(int ind, int copy_sprite, bool free_texture)
   if (!get_sprite_mtx(spr_copy, copy_sprite))
     return;
 
-  for (int i = 0; i < spr->subcount; i++)
+  for (int i = 0; i < spr->subcount; i++) {
+    enigma::sprite_unpack_subimage(spr, i);
+    enigma::sprite_unpack_subimage(spr_copy, i % spr_copy->subcount);
     enigma::graphics_replace_texture_alpha_from_texture(spr->texturearray[i], spr_copy->texturearray[i % spr_copy->subcount]);
+  }
 }
 
 void sprite_merge(int ind, int copy_sprite)
@@ -193,9 +256,8 @@ void sprite_merge(int ind, int copy_sprite)
   int i = 0, j = 0, t_subcount = spr->subcount + spr_copy->subcount;
   while (j < spr_copy->subcount)
   {
-    spr->texturearray.push_back(enigma::graphics_duplicate_texture(spr_copy->texturearray[j]));
-    spr->texbordxarray.push_back(spr_copy->texbordxarray[j]);
-    spr->texbordyarray.push_back(spr_copy->texbordyarray[j]);
+    spr->texturearray.push_back(enigma::sprite_copy_texture(spr_copy->texturearray[j]));
+    spr->texrectarray.push_back(spr_copy->texrectarray[j]);
     i++; j++;
   }
   spr->subcount = t_subcount;
@@ -210,7 +272,6 @@ void sprite_merge(int ind, int copy_sprite)
  * use at load time with data read from the executable. These both expect
  * RAW format, RGB only.
  */
-#include "nlpo2.h"
 
 namespace enigma
 {
@@ -257,6 +318,7 @@ namespace enigma
       as->bbox_relative.left  = bbl - x;
       as->bbox_relative.top   = bbt - y;
       as->bbox_relative.right = bbr - x;
+    sprite_bbox_serial++;
     as->xoffset = x;
     as->yoffset = y;
 
@@ -322,6 +384,7 @@ namespace enigma
       ns->bbox_relative.left  = bbl - x_offset;
       ns->bbox_relative.top   = bbt - y_offset;
       ns->bbox_relative.right = bbr - x_offset;
+    sprite_bbox_serial++;
     ns->xoffset   = (int)x_offset;
     ns->yoffset   = (int)y_offset;
 
@@ -346,9 +409,9 @@ namespace enigma
       }
       unsigned texture = graphics_create_texture(
           cellwidth, height, fullcellwidth, fullheight, pixels, mipmap);
+      const texture_rect tr = {0, 0, (double) cellwidth/fullcellwidth, (double) height/fullheight};
       ns->texturearray.push_back(texture);
-      ns->texbordxarray.push_back((double) cellwidth/fullcellwidth);
-      ns->texbordyarray.push_back((double) height/fullheight);
+      ns->texrectarray.push_back(tr);
 
       collision_type coll_type = precise ? ct_precise : ct_bbox;
       ns->colldata.push_back(get_collision_mask(ns,(unsigned char*)pixels,coll_type));
@@ -366,9 +429,8 @@ namespace enigma
 
     for (int i = 0; i < spr->subcount; i++)
     {
-      spr->texturearray.push_back(graphics_duplicate_texture(spr_copy->texturearray[i]));
-      spr->texbordxarray.push_back(spr_copy->texbordxarray[i]);
-      spr->texbordyarray.push_back(spr_copy->texbordyarray[i]);
+      spr->texturearray.push_back(sprite_copy_texture(spr_copy->texturearray[i]));
+      spr->texrectarray.push_back(spr_copy->texrectarray[i]);
     }
   }
 
@@ -398,14 +460,23 @@ namespace enigma
 
     sprite* sprstr = spritestructarray[sprid];
 
+    const texture_rect tr = {0, 0, (double) w/fullwidth, (double) h/fullheight};
     sprstr->texturearray.push_back(texture);
-    sprstr->texbordxarray.push_back((double) w/fullwidth);
-    sprstr->texbordyarray.push_back((double) h/fullheight);
+    sprstr->texrectarray.push_back(tr);
     sprstr->colldata.push_back(get_collision_mask(sprstr,collision_data,ct));
 
     delete[] imgpxdata;
   }
 
+  void sprite_set_subimage_region(int sprid, int imgindex, int texture, const texture_rect &region,
+      unsigned char* collision_data, collision_type ct) {
+    sprite* sprstr = spritestructarray[sprid];
+
+    sprstr->texturearray.push_back(texture);
+    sprstr->texrectarray.push_back(region);
+    sprstr->colldata.push_back(get_collision_mask(sprstr,collision_data,ct));
+  }
+
   //Appends a subimage
   void sprite_add_subimage(int sprid, unsigned int w, unsigned int h,
       unsigned char* chunk, unsigned char* collision_data, collision_type ct) {
@@ -431,9 +502,9 @@ namespace enigma
 
   sprite* sprstr = spritestructarray[sprid];
 
+  const texture_rect tr = {0, 0, (double) w/fullwidth, (double) h/fullheight};
   sprstr->texturearray.push_back(texture);
-  sprstr->texbordxarray.push_back((double) w/fullwidth);
-  sprstr->texbordyarray.push_back((double) h/fullheight);
+  sprstr->texrectarray.push_back(tr);
   sprstr->colldata.push_back(get_collision_mask(sprstr,collision_data,ct));
 
   sprstr->subcount += 1;
@@ -469,7 +540,7 @@ double sprite_get_texture_width_factor(int sprite, int subimg)
   if (!get_sprite(spr,sprite))
     return 32;
 
-  return spr->texbordxarray[subimg];
+  return spr->texrectarray[subimg].right - spr->texrectarray[subimg].left;
 }
 
 double sprite_get_texture_height_factor(int sprite, int subimg)
@@ -478,7 +549,7 @@ double sprite_get_texture_height_factor(int sprite, int subimg)
   if (!get_sprite(spr,sprite))
     return 32;
 
-  return spr->texbordyarray[subimg];
+  return spr->texrectarray[subimg].bottom - spr->texrectarray[subimg].top;
 }
 
 int sprite_get_bbox_bottom(int sprite)
@@ -644,6 +715,7 @@ void sprite_set_bbox(int ind, int left, int top, int right, int bottom)
   spr->bbox_relative.top = top - spr->yoffset;
   spr->bbox_relative.right = right - spr->xoffset;
   spr->bbox_relative.bottom = bottom - spr->yoffset;
+  enigma::sprite_bbox_serial++;
 }
 
 void sprite_collision_mask(int ind, bool sepmasks, int mode,
@@ -31,13 +31,17 @@ struct bbox_rect_t {
 };
 namespace enigma
 {
+  // The region of a texture holding one subimage, in texture coordinates.
+  struct texture_rect {
+    double left, top, right, bottom;
+  };
+
   struct sprite
   {
     int width,height,subcount,xoffset,yoffset,id;
 	
-	vector<int> texturearray; //Each subimage has a texture
-	vector<double> texbordxarray;
-	vector<double> texbordyarray;
+	vector<int> texturearray; //Each subimage has a texture, which may be an atlas page shared with other sprites
+	vector<texture_rect> texrectarray; //Where each subimage lies in its texture
 	vector<void*> colldata; // Each subimage has collision data
 
     //void*  *pixeldata;
@@ -49,6 +53,7 @@ namespace enigma
   };
   extern sprite** spritestructarray; // INVARIANT: Should only be modified inside spritestruct.cpp.
   extern size_t sprite_idmax;
+  extern unsigned sprite_bbox_serial; // Bumped whenever a sprite's collision box changes, to invalidate cached instance boxes
 }
 
 //int sprite_add(string filename,double imgnumb,double precise,double transparent,double smooth,double preload,double x_offset,double y_offset);
@@ -64,9 +69,20 @@ namespace enigma
 
   //Sets the subimage
   void sprite_set_subimage(int sprid, int imgindex, unsigned int w,unsigned int h,unsigned char*chunk, unsigned char*collision_data, collision_type ct);
+  //Sets the subimage to a region of a texture shared with other subimages
+  void sprite_set_subimage_region(int sprid, int imgindex, int texture, const texture_rect &region, unsigned char*collision_data, collision_type ct);
   //Appends a subimage
   void sprite_add_subimage(int sprid, unsigned int w, unsigned int h, unsigned char*chunk, unsigned char*collision_data, collision_type ct);
   void spritestructarray_reallocate();
+
+  // Atlas pages are shared between sprites, so they are never freed along with one.
+  void sprite_add_atlas_page(int texture);
+  bool sprite_texture_is_atlas_page(int texture);
+  void sprite_free_texture(int texture);
+  // Returns a copy of a subimage's pixels laid out as in a texture of its own, to be delete[]d.
+  unsigned char* sprite_get_subimage_pixeldata(const sprite *spr, int subimg, unsigned *fullwidth, unsigned *fullheight);
+  // Moves a subimage out of its atlas page into a texture of its own, so that it can be modified.
+  void sprite_unpack_subimage(sprite *spr, int subimg);
 }
 
 namespace enigma_user
@@ -97,7 +113,7 @@ namespace enigma_user
 {
 
 extern int sprite_get_number  (int sprite);
-extern int sprite_get_texture (int sprite, int subimage);
+extern int sprite_get_texture (int sprite, int subimage); // With sprite atlas pages enabled, may be a page shared with other sprites
 extern int sprite_get_xoffset (int sprite);
 extern int sprite_get_yoffset (int sprite);
 
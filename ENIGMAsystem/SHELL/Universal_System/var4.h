@@ -35,6 +35,7 @@ using std::string;
 // We want var and variant to support a lot of assignment types.
 
 #include "var_te.h"
+#include "var_string.h"
 
 namespace enigma {
   union rvt {
@@ -43,6 +44,10 @@ namespace enigma {
     rvt(double x): d(x) {}
     #define var_e 1e-12
   };
+
+  // Declares that no reference to a var array element handed out so far is still held, so
+  // arrays indexed before now can be shared by their copies again. Called between events.
+  void var_end_element_loans();
 }
 
 struct var;
@@ -54,7 +59,7 @@ struct variant
   static const int default_type;
 
   enigma::rvt rval;
-  string sval;
+  enigma::var_string sval; // Shared with copies; see var_string.h
   int type;
   
   operator int();
@@ -164,7 +169,8 @@ struct variant
 
 struct var
 {
-  void* values;
+  variant scalar; // Element 0 (and 0,0) lives here, so vars never indexed never allocate
+  void* values;   // The rest of the array, shared between copies until written; see var4_lua.cpp
   
   private:
     void initialize();
@@ -294,6 +300,11 @@ struct var
   int array_len() const;
   int array_height() const;
   int array_len(int row) const;
+
+  //Bulk operations on a row of the array (row 0 being the 1D array), done a block at a time.
+  void array_copy(int row, int index, const var& src, int src_row, int src_index, int length);
+  void array_fill(int row, int index, int length, const variant& value);
+  void array_resize(int row, int length);
   
   ~var();
 };
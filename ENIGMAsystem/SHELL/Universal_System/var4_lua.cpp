@@ -26,96 +26,231 @@
 \********************************************************************************/
 
 #include <string>
+#include <climits>
 using std::string;
 
 #include "var4.h"      // Var stuff
 #include "lua_table.h" // The Lua part
 
-#define vararray lua_table<lua_table<variant> >
-#define as_lua(x) (*((vararray*)x))
+#define vararray lua_grid<variant>
 
-//#define as_lua(x) (*(vararray*)(&(x)))
-//typedef lua_table<lua_table<variant> > vararray;
+// Array elements other than the scalar. Copies of a var share one of these until either writes
+// to it. Cell (0,0) of the table is never used; the var's scalar stands in for it.
+// Once a writable reference to an element has been handed out, the owner may still be holding it,
+// so later copies get a table of their own instead of sharing this one. That lasts only until the
+// current event is over, since no reference is held across events; see var_end_element_loans().
+struct var_payload {
+  unsigned refs;
+  unsigned lent; // The loan period in which an element reference was last handed out, or 0
+  vararray table;
+  var_payload(): refs(1), lent(0) {}
+  var_payload(const var_payload &x): refs(1), lent(0), table(x.table) {}
+};
+
+// Numbers the stretches between var_end_element_loans() calls, skipping 0.
+static unsigned loan_period = 1;
+
+namespace enigma {
+  void var_end_element_loans() {
+    if (!++loan_period) ++loan_period;
+  }
+}
+
+#define as_payload(x) ((var_payload*)(x))
+#define as_lua(x) (as_payload(x)->table)
+
+// Gives the var a table of its own that can be written to, creating or unsharing it as needed.
+static vararray& writable(void*& values)
+{
+  var_payload *p = as_payload(values);
+  if (!p)
+    values = p = new var_payload();
+  else if (p->refs > 1) {
+    --p->refs;
+    values = p = new var_payload(*p);
+  }
+  return p->table;
+}
+
+// Like writable(), for element references handed out to the caller.
+static vararray& lend(void*& values)
+{
+  vararray &t = writable(values);
+  as_payload(values)->lent = loan_period;
+  return t;
+}
+
+// Gets the payload a copy of a var should hold.
+static void* share(void* values)
+{
+  var_payload *p = as_payload(values);
+  if (!p) return NULL;
+  if (p->lent == loan_period) return new var_payload(*p);
+  ++p->refs;
+  return p;
+}
+
+// Reads an element without creating it, or unsharing the table.
+static const variant& lookup(const void* values, size_t ind1, size_t ind2)
+{
+  static const variant untouched;
+  const variant *v = values ? as_lua(values).find(ind1, ind2) : NULL;
+  return v ? *v : untouched;
+}
 
 void var::initialize() {
-  values = new vararray();
+  values = NULL;
 }
 void var::cleanup() {
-  if (values) { 
-    delete ((vararray*)values);
-    values = NULL; 
+  if (values) {
+    if (!--as_payload(values)->refs)
+      delete as_payload(values);
+    values = NULL;
   }
 }
 
 variant& var::operator*  ()
 {
-  return **as_lua(values);
+  return scalar;
 }
 variant& var::operator() ()
 {
-  return **as_lua(values);
+  return scalar;
 }
 variant& var::operator[] (int ind)
 {
-  return (*as_lua(values))[size_t(ind)];
+  if (!ind) return scalar;
+  return lend(values)(0, size_t(ind));
 }
 variant& var::operator() (int ind)
 {
-  return (*as_lua(values))[size_t(ind)];
+  if (!ind) return scalar;
+  return lend(values)(0, size_t(ind));
 }
 variant& var::operator() (int ind1,int ind2)
 {
-  return as_lua(values)[size_t(ind1)][size_t(ind2)];
+  if (!ind1 and !ind2) return scalar;
+  return lend(values)(size_t(ind1), size_t(ind2));
 }
 
 const variant& var::operator*  () const
 {
-  return **as_lua(values);
+  return scalar;
 }
 const variant& var::operator() () const
 {
-  return **as_lua(values);
+  return scalar;
 }
 const variant& var::operator[] (int ind) const
 {
-  return (*as_lua(values))[size_t(ind)];
+  if (!ind) return scalar;
+  return lookup(values, 0, size_t(ind));
 }
 const variant& var::operator() (int ind) const
 {
-  return (*as_lua(values))[size_t(ind)];
+  if (!ind) return scalar;
+  return lookup(values, 0, size_t(ind));
 }
 const variant& var::operator() (int ind1,int ind2) const
 {
-  return as_lua(values)[size_t(ind1)][size_t(ind2)];
+  if (!ind1 and !ind2) return scalar;
+  return lookup(values, size_t(ind1), size_t(ind2));
 }
 
 int var::array_len() const
 {
-  return (*as_lua(values)).max_index();
+  return values ? as_lua(values).width(0) : 1;
 }
 
 int var::array_height() const
 {
-  return as_lua(values).max_index();
+  return values ? as_lua(values).height() : 1;
 }
 
 int var::array_len(int row) const
 {
-  return row>=array_height() ? 0 : as_lua(values)[size_t(row)].max_index();
+  if (row >= array_height()) return 0;
+  return values ? as_lua(values).width(size_t(row)) : 1;
 }
 
-var::var(const var& x) {
-  values = new vararray();
-  as_lua(values) = as_lua(x.values);
-  //new(&values) vararray(*(vararray*)&(x.values));
+// Keeps index + length within an int, since cells past that can't be told apart.
+static int clamp_length(int index, int length) {
+  return length < INT_MAX - index ? length : INT_MAX - index;
 }
-var& var::operator= (const var& x) {
-  if (values) {
-    delete ((vararray*)values);
+
+void var::array_copy(int row, int index, const var& src, int src_row, int src_index, int length)
+{
+  if (row < 0 or index < 0 or src_row < 0 or src_index < 0 or length <= 0) return;
+  length = clamp_length(index > src_index ? index : src_index, length);
+
+  // Within a row of one var, copying right to left keeps an overlapping source intact.
+  const bool backward = &src == this and row == src_row and index > src_index;
+
+  // The scalar isn't in the table, so an end of the range that starts there is copied alone.
+  const int first = ((!row and !index) or (!src_row and !src_index)) ? 1 : 0;
+  if (first and !backward)
+    (*this)(row, index) = src(src_row, src_index);
+
+  const int n = length - first;
+  if (n > 0)
+  {
+    vararray &t = writable(values);
+    variant *to = t.span(row, index + first, n);
+    const variant *from = src.values ? ((const vararray&)as_lua(src.values)).span(src_row, src_index + first, n) : NULL;
+    for (int k = 0; k < n; k++) {
+      const int i = backward ? n - 1 - k : k;
+      if (to)
+        to[i] = from ? from[i] : src(src_row, src_index + first + i);
+      else {
+        const variant v = src(src_row, src_index + first + i);
+        t(row, index + first + i) = v;
+      }
+    }
+  }
+
+  if (first and backward) {
+    const variant v = src(src_row, src_index);
+    (*this)(row, index) = v;
+  }
+}
+
+void var::array_fill(int row, int index, int length, const variant& value)
+{
+  if (row < 0 or index < 0 or length <= 0) return;
+  length = clamp_length(index, length);
+
+  if (!row and !index) {
+    scalar = value;
+    ++index, --length;
+  }
+  if (length <= 0) return;
+
+  vararray &t = writable(values);
+  if (variant *to = t.span(row, index, length)) {
+    for (int i = 0; i < length; i++)
+      to[i] = value;
+  }
+  else {
+    for (int i = 0; i < length; i++)
+      t(row, index + i) = value;
   }
+}
 
-  values = new vararray();
-  as_lua(values) = as_lua(x.values);
-  //*(vararray*)&(values) = *(vararray*)&(x.values);
+void var::array_resize(int row, int length)
+{
+  if (row < 0) return;
+  if (length < 1) length = 1; // The first element can't be removed
+  if (length > array_len(row))
+    writable(values)(size_t(row), size_t(length - 1));
+  else if (values)
+    writable(values).truncate(row, length);
+}
+
+var::var(const var& x): scalar(x.scalar), values(share(x.values)) {}
+var& var::operator= (const var& x) {
+  void *const shared = share(x.values);
+  cleanup();
+  values = shared;
+  scalar = x.scalar;
   return *this;
 }
@@ -49,3 +49,41 @@ bool enigma_user::is_array(const var& v)
   return (v.array_height() > 1) || (v.array_len() > 1);
 }
 
+void enigma_user::array_copy(var& dest, int dest_index, const var& src, int src_index, int length)
+{
+  dest.array_copy(0, dest_index, src, 0, src_index, length);
+}
+
+void enigma_user::array_copy_2d(var& dest, int dest_n, int dest_index, const var& src, int src_n, int src_index, int length)
+{
+  dest.array_copy(dest_n, dest_index, src, src_n, src_index, length);
+}
+
+void enigma_user::array_fill(var& v, const variant& value, int index, int length)
+{
+  v.array_fill(0, index, length, value);
+}
+
+void enigma_user::array_fill_2d(var& v, int n, const variant& value, int index, int length)
+{
+  v.array_fill(n, index, length, value);
+}
+
+void enigma_user::array_resize(var& v, int length)
+{
+  v.array_resize(0, length);
+}
+
+void enigma_user::array_resize_2d(var& v, int n, int length)
+{
+  v.array_resize(n, length);
+}
+
+var enigma_user::array_slice(const var& v, int index, int length)
+{
+  var res;
+  if (length > v.array_len() - index)
+    length = v.array_len() - index;
+  res.array_copy(0, 0, v, 0, index, length);
+  return res;
+}
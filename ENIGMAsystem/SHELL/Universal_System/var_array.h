@@ -40,6 +40,22 @@ int array_height_2d(const var& v);
 
 bool is_array(const var& v);
 
+// Copies length elements of src, from src_index on, over those of dest from dest_index on.
+// The ranges may overlap. The _2d versions work on row n of a 2D array.
+void array_copy(var& dest, int dest_index, const var& src, int src_index, int length);
+void array_copy_2d(var& dest, int dest_n, int dest_index, const var& src, int src_n, int src_index, int length);
+
+// Sets length elements, from index on, to value.
+void array_fill(var& v, const variant& value, int index, int length);
+void array_fill_2d(var& v, int n, const variant& value, int index, int length);
+
+// Grows or shrinks an array to the given length; elements cut off are reset.
+void array_resize(var& v, int length);
+void array_resize_2d(var& v, int n, int length);
+
+// A new array of length elements of v, starting at index.
+var array_slice(const var& v, int index, int length);
+
 }
 
 #endif //_H_VAR_ARRAY
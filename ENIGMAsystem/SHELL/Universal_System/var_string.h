@@ -0,0 +1,113 @@
+/** Copyright (C) 2026 The ENIGMA Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_VAR_STRING_H
+#define ENIGMA_VAR_STRING_H
+
+#include <string>
+#include <cstddef>
+using std::string;
+
+namespace enigma
+{
+  // The string half of a variant. It is one pointer wide, so real values don't pay for a whole
+  // std::string; the empty string has no buffer at all. Copies share one reference counted
+  // buffer, which is only duplicated when a shared string is written to. Like the rest of the
+  // variant machinery, it is not safe to share between threads.
+  class var_string
+  {
+    struct rep {
+      unsigned refs;
+      string str;
+      rep(const string &s): refs(1), str(s) {}
+    };
+    rep *r;
+
+    static const string &empty_string() { static const string empty; return empty; }
+    void release() { if (r && !--r->refs) delete r; }
+
+    // The buffer, made private to this handle so it can be modified.
+    string &own() {
+      if (!r) r = new rep(empty_string());
+      else if (r->refs > 1) { --r->refs; r = new rep(r->str); }
+      return r->str;
+    }
+
+  public:
+    var_string(): r(NULL) {}
+    explicit var_string(const string &s): r(s.empty() ? NULL : new rep(s)) {}
+    explicit var_string(const char *s): r(*s ? new rep(s) : NULL) {}
+    var_string(const var_string &x): r(x.r) { if (r) ++r->refs; }
+    ~var_string() { release(); }
+
+    var_string &operator=(const var_string &x) {
+      if (x.r) ++x.r->refs;
+      release();
+      r = x.r;
+      return *this;
+    }
+    var_string &operator=(const string &s) {
+      if (r && r->refs == 1) r->str = s;
+      else { release(); r = s.empty() ? NULL : new rep(s); }
+      return *this;
+    }
+    var_string &operator+=(const string &s) {
+      if (!s.empty()) own() += s;
+      return *this;
+    }
+    var_string &operator+=(const var_string &x) {
+      if (!r) return *this = x;
+      if (x.r) own() += x.r->str;
+      return *this;
+    }
+
+    const string &str() const { return r ? r->str : empty_string(); }
+    operator const string&() const { return str(); }
+    const char *c_str() const { return str().c_str(); }
+    size_t length() const { return r ? r->str.length() : 0; }
+    size_t size() const { return length(); }
+    bool empty() const { return !length(); }
+
+    char operator[](size_t i) const { return r ? r->str[i] : '\0'; }
+    char &operator[](size_t i) { return own()[i]; }
+
+    // Strings sharing a buffer are trivially equal.
+    bool operator==(const var_string &x) const { return r == x.r || str() == x.str(); }
+    bool operator!=(const var_string &x) const { return !(*this == x); }
+    bool operator< (const var_string &x) const { return r != x.r && str() <  x.str(); }
+    bool operator> (const var_string &x) const { return r != x.r && str() >  x.str(); }
+    bool operator<=(const var_string &x) const { return !(*this > x); }
+    bool operator>=(const var_string &x) const { return !(*this < x); }
+  };
+
+  #define var_string_compare(op)\
+    inline bool operator op(const var_string &a, const string &b) { return a.str() op b; }\
+    inline bool operator op(const string &a, const var_string &b) { return a op b.str(); }
+  var_string_compare(==)
+  var_string_compare(!=)
+  var_string_compare(<)
+  var_string_compare(>)
+  var_string_compare(<=)
+  var_string_compare(>=)
+  #undef var_string_compare
+
+  inline string operator+(const var_string &a, const var_string &b) { return a.str() + b.str(); }
+  inline string operator+(const var_string &a, const string &b) { return a.str() + b; }
+  inline string operator+(const string &a, const var_string &b) { return a + b.str(); }
+}
+
+#endif
@@ -0,0 +1,142 @@
+/** Copyright (C) 2026 The ENIGMA Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+// Times mp_grid_path between the corners of a 512x512 grid, open, with scattered walls, and with
+// the goal walled off, with and without diagonal moves. Nothing is drawn and no instance moves, so mp_movement.cpp is left out. Build
+// from ENIGMAsystem/SHELL:
+//   g++ -std=c++11 -O2 -I. -IUniversal_System/Info bench/mp_grid_path.cpp
+//       $(ls Universal_System/Extensions/MotionPlanning/*.cpp | grep -v mp_movement)
+//       Universal_System/Extensions/Paths/pathstruct.cpp Universal_System/var4.cpp
+//       Universal_System/var4_lua.cpp -lpthread -o mp_grid_path
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "Universal_System/var4.h"
+#include "Universal_System/Extensions/MotionPlanning/motion_planning.h"
+#include "Universal_System/Extensions/Paths/pathstruct.h"
+
+// What the rest of the engine would otherwise provide; nothing is drawn.
+const int variant::default_type = 0;
+std::string toString(long x) { return std::to_string(x); }
+std::string toString(double x) { return std::to_string(x); }
+namespace enigma {
+  size_t path_idmax = 0;
+  void register_callback_before_collision_event(void (*)()) {}
+}
+namespace enigma_user {
+  int collision_rectangle(cs_scalar, cs_scalar, cs_scalar, cs_scalar, int, bool, bool) { return -4; }
+  void draw_text(gs_scalar, gs_scalar, variant) {}
+  int merge_color(int c1, int, double) { return c1; }
+  int draw_primitive_begin(int) { return 0; }
+  int draw_vertex_color(gs_scalar, gs_scalar, int, float) { return 0; }
+  int draw_primitive_end() { return 0; }
+  int draw_set_color_rgba(unsigned char, unsigned char, unsigned char, float) { return 0; }
+  int draw_get_color() { return 0; }
+  int draw_set_color(int) { return 0; }
+
+  // As in path_functions.cpp
+  int path_add()
+  {
+    enigma::pathstructarray_reallocate();
+    return (new enigma::path(enigma::path_idmax, false, false, 8, 0))->id;
+  }
+}
+
+using namespace enigma_user;
+
+static double now()
+{
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+static const int cells = 512;
+static int runs = 11;
+
+// The same walls on every platform and in every version, unlike rand().
+static unsigned seed;
+static int next_random(int n)
+{
+  seed = seed*1103515245 + 12345;
+  return (seed >> 16) % n;
+}
+
+// Scatters wall segments of 4 to 63 cells over a tenth of the grid, keeping the corners clear.
+static void add_walls(unsigned grid)
+{
+  seed = 12345;
+  for (int i = 0; i < cells*cells/10/32; i++) {
+    const int h = next_random(cells), v = next_random(cells), length = 4 + next_random(60);
+    const bool across = next_random(2);
+    for (int j = 0; j < length; j++) {
+      const int ch = across ? h + j : h, cv = across ? v : v + j;
+      if (ch < cells && cv < cells && (ch >= 16 || cv >= 16) && (ch < cells - 16 || cv < cells - 16))
+        mp_grid_add_cell(grid, ch, cv);
+    }
+  }
+}
+
+// The median milliseconds to find a path from one corner to the other, and the path's length.
+// Where the goal cannot be reached, the path leads as close to it as the search got.
+static double time_path(unsigned grid, unsigned path, bool allowdiag, bool reachable, double &length)
+{
+  std::vector<double> times;
+  for (int r = 0; r < runs; r++) {
+    const double t = now();
+    mp_grid_path(grid, path, 0.5, 0.5, cells - 0.5, cells - 0.5, allowdiag);
+    times.push_back((now() - t)*1000);
+  }
+  const enigma::path *const p = enigma::pathstructarray[path];
+  const bool reached = p->pointarray.back().x == cells - 0.5 && p->pointarray.back().y == cells - 0.5;
+  if (reached != reachable)
+    printf("warning: the goal was %s\n", reached ? "reached" : "not reached");
+  length = p->total_length;
+  std::sort(times.begin(), times.end());
+  return times[runs/2];
+}
+
+// The number of runs to take the median of can be given, as the slower versions take a while.
+int main(int argc, char **argv)
+{
+  if (argc > 1)
+    runs = std::max(1, atoi(argv[1]));
+  const unsigned open = mp_grid_create(0, 0, cells, cells, 1, 1);
+  mp_grid_set_threshold(open, 50000); // As adding walls does for the others
+  const unsigned walled = mp_grid_create(0, 0, cells, cells, 1, 1);
+  add_walls(walled);
+  // The same walls with the goal's corner closed off, so that every cell the start can reach is searched.
+  const unsigned closed = mp_grid_create(0, 0, cells, cells, 1, 1);
+  add_walls(closed);
+  mp_grid_add_rectangle(closed, cells - 8, cells - 8, cells - 7, cells);
+  mp_grid_add_rectangle(closed, cells - 8, cells - 8, cells, cells - 7);
+  const unsigned path = path_add();
+
+  static const char *const names[] = {"open", "walled", "closed"};
+  const unsigned grids[] = {open, walled, closed};
+  for (int g = 0; g < 3; g++)
+    for (int diag = 0; diag < 2; diag++) {
+      double length;
+      const double ms = time_path(grids[g], path, diag, grids[g] != closed, length);
+      printf("%-6s %-11s %8.3f ms  path length %.1f\n", names[g], diag ? "diagonal" : "orthogonal", ms, length);
+    }
+}
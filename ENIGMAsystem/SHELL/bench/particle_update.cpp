@@ -0,0 +1,155 @@
+/** Copyright (C) 2026 The ENIGMA Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+// Times part_system_update on 200000 particles, with no effectors and with one changer,
+// attractor, destroyer or deflector added, and reports particles/ms for each pass. An effector's
+// pass is timed as the difference from the update without it. Nothing is drawn, so the sprite,
+// quad and draw files are left out. Build from ENIGMAsystem/SHELL:
+//   g++ -std=c++11 -O2 -I. -IUniversal_System/Info bench/particle_update.cpp
+//       $(ls Universal_System/Extensions/ParticleSystems/PS_particle_*.cpp
+//         | grep -v -e sprites -e quads -e updatedraw) -lpthread -o particle_update
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+#include "Universal_System/Extensions/ParticleSystems/PS_particle.h"
+#include "Universal_System/Extensions/ParticleSystems/PS_particle_system.h"
+#include "Universal_System/Extensions/ParticleSystems/PS_particle_sprites.h"
+#include "Universal_System/spritestruct.h"
+
+// What the graphics system would otherwise provide; nothing is drawn.
+namespace enigma {
+  sprite** spritestructarray = NULL;
+  particle_sprite* get_particle_sprite(pt_shape particle_shape) {
+    static particle_sprite ps = {0, 32, 32, pt_sh_pixel};
+    return &ps;
+  }
+  void initialize_particle_systems_drawing() {}
+  namespace particle_bridge {
+    void draw_particles(particle_store&, bool, double, int, double, double) {}
+  }
+}
+namespace enigma_user {
+  int color_get_red(int color) { return color & 0xFF; }
+  int color_get_green(int color) { return (color >> 8) & 0xFF; }
+  int color_get_blue(int color) { return (color >> 16) & 0xFF; }
+  int make_color_rgb(unsigned char r, unsigned char g, unsigned char b) { return r | g << 8 | b << 16; }
+  int make_color_hsv(int hue, int saturation, int value) { return make_color_rgb(hue, saturation, value); }
+}
+
+using namespace enigma_user;
+
+static double now()
+{
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+static const int particles = 200000;
+static const int steps = 31;
+
+enum effector { none, changer, attractor, destroyer, deflector };
+
+// A system of moving, coloured, growing particles that live through the whole run, so the count
+// stays the same from step to step, with one effector of the given kind.
+static int create_system(int pt, effector kind)
+{
+  const int ps = part_system_create();
+  for (int i = 0; i < particles; i++)
+    part_particles_create(ps, i % 1000, i / 1000*5, pt, 1);
+
+  // Each effector's region covers every particle but leaves them all alive and of the same type;
+  // the destroyer's region is next to them instead, so that it has to test each one.
+  if (kind == changer) {
+    const int unused1 = part_type_create(), unused2 = part_type_create();
+    const int ch = part_changer_create(ps);
+    part_changer_region(ps, ch, -1000, 2000, -1000, 2000, ps_shape_rectangle);
+    part_changer_types(ps, ch, unused1, unused2);
+    part_changer_kind(ps, ch, ps_change_all);
+  } else if (kind == attractor) {
+    const int at = part_attractor_create(ps);
+    part_attractor_position(ps, at, 500, 500);
+    part_attractor_force(ps, at, 0.01, 2000, ps_force_linear, true);
+  } else if (kind == destroyer) {
+    const int ds = part_destroyer_create(ps);
+    part_destroyer_region(ps, ds, -3000, -2000, -3000, -2000, ps_shape_ellipse);
+  } else if (kind == deflector) {
+    const int df = part_deflector_create(ps);
+    part_deflector_region(ps, df, -1000, 2000, -1000, 2000);
+    part_deflector_kind(ps, df, ps_deflect_horizontal);
+    part_deflector_friction(ps, df, 0);
+  }
+  part_system_update(ps); // Warm up
+  return ps;
+}
+
+static double median(std::vector<double> &times)
+{
+  std::sort(times.begin(), times.end());
+  return times[times.size()/2];
+}
+
+// The median milliseconds per part_system_update with no effectors and with one of the given
+// kind. The two systems are updated in turn, so that both see the same machine load.
+static void time_update(int pt, effector kind, double &base_ms, double &with_ms)
+{
+  const int base = create_system(pt, none), with = create_system(pt, kind);
+  std::vector<double> base_times, with_times;
+  for (int s = 0; s < steps; s++) {
+    double t = now();
+    part_system_update(base);
+    base_times.push_back((now() - t)*1000);
+    t = now();
+    part_system_update(with);
+    with_times.push_back((now() - t)*1000);
+  }
+  if (part_particles_count(with) != particles)
+    printf("warning: %d particles left\n", part_particles_count(with));
+  part_system_destroy(base);
+  part_system_destroy(with);
+  base_ms = median(base_times);
+  with_ms = median(with_times);
+}
+
+int main()
+{
+  const int pt = part_type_create();
+  part_type_shape(pt, pt_shape_disk);
+  part_type_size(pt, 0.5, 1.0, 0.001, 0.1);
+  part_type_orientation(pt, 0, 360, 1, 0, false);
+  part_type_color2(pt, 0xFF0000, 0x00FF00);
+  part_type_alpha2(pt, 1, 0.5);
+  part_type_life(pt, 1000000, 1000000);
+  part_type_speed(pt, 1, 2, 0, 0);
+  part_type_direction(pt, 0, 360, 0.5, 0);
+  part_type_gravity(pt, 0.01, 270);
+
+  static const char *const names[] = {"life, shape, color and motion", "changer", "attractor", "destroyer", "deflector"};
+  std::vector<double> bases, passes;
+  for (int kind = changer; kind <= deflector; kind++) {
+    double base, with;
+    time_update(pt, effector(kind), base, with);
+    bases.push_back(base);
+    passes.push_back(with - base);
+  }
+  passes.insert(passes.begin(), median(bases));
+  for (int kind = none; kind <= deflector; kind++)
+    printf("%-30s %8.3f ms %10.0f particles/ms\n", names[kind], passes[kind], passes[kind] > 0 ? particles/passes[kind] : 0.0);
+}
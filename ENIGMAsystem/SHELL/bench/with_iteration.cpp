@@ -0,0 +1,117 @@
+/** Copyright (C) 2026 The ENIGMA Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+// Times with(obj) over 10000 instances, many short with blocks, and destroying instances while
+// iterators are live, against the engine's own instance system. Build from ENIGMAsystem/SHELL:
+//   g++ -std=c++11 -O2 -I. -IUniversal_System/Info bench/with_iteration.cpp
+//       Universal_System/instance_system.cpp Universal_System/object.cpp
+//       Universal_System/var4.cpp Universal_System/var4_lua.cpp -o with_iteration
+
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "Universal_System/object.h"
+#include "Universal_System/instance_system.h"
+#include "Universal_System/instance_system_frontend.h"
+#include "Universal_System/with.h"
+
+// What the rest of the engine and the compiled game would otherwise provide
+std::deque<int> instance_id;
+const int variant::default_type = 0;
+std::string toString(long x) { return std::to_string(x); }
+std::string toString(double x) { return std::to_string(x); }
+namespace enigma {
+  object_basic *ENIGMA_global_instance;
+  int maxid = 100001;
+  size_t object_idmax = 1;
+  int obj_idmax = 1, objectcount = 1;
+  objectstruct objs[1];
+}
+
+// Links itself in the same lists a compiled object does, and unlinks from them the same way.
+struct bench_object: enigma::object_basic {
+  enigma::pinstance_list_iterator me;
+  enigma::inst_iter *me_obj;
+  double value;
+  bench_object(): object_basic(enigma::maxid++, 0), value(1) {
+    me = enigma::link_instance(this);
+    me_obj = enigma::link_obj_instance(this, 0);
+  }
+  void unlink() {
+    enigma::instance_iter_queue_for_destroy(this);
+    enigma::unlink_main(me);
+    enigma::unlink_object_id_iter(me_obj, 0);
+  }
+};
+
+static double now() {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static const int instance_count = 10000;
+
+int main()
+{
+  enigma::objects = new enigma::objectid_base[1];
+  enigma::inst_iter outside(NULL, NULL, NULL); // The code running the with blocks
+  enigma::instance_event_iterator = &outside;
+
+  std::vector<bench_object*> insts;
+  for (int i = 0; i < instance_count; i++)
+    insts.push_back(new bench_object());
+
+  double sum = 0;
+  const int loops = 500;
+  double t = now();
+  for (int l = 0; l < loops; l++)
+    with (0) sum += ((bench_object*) enigma::instance_event_iterator->inst)->value;
+  t = now() - t;
+  printf("with(obj) over %d instances: %.3f ms per loop\n", instance_count, t / loops * 1e3);
+
+  // A with block per instance, each over a single other instance, as bullets checking a target
+  const int rounds = 50;
+  t = now();
+  for (int r = 0; r < rounds; r++)
+    for (int i = 0; i < instance_count; i++)
+      with (insts[(i * 7) % instance_count]->id) sum += ((bench_object*) enigma::instance_event_iterator->inst)->value;
+  t = now() - t;
+  printf("with(id) over one instance: %.1f ns per block\n", t / (rounds * instance_count) * 1e9);
+
+  // Destroying every instance from inside nested with blocks, 64 deep
+  t = now();
+  struct nest {
+    static void run(int depth, std::vector<bench_object*> &insts, double &sum) {
+      if (depth) {
+        with (insts[depth]->id) run(depth - 1, insts, sum);
+        return;
+      }
+      for (int i = 0; i < instance_count; i++)
+        insts[i]->unlink();
+    }
+  };
+  nest::run(64, insts, sum);
+  t = now() - t;
+  printf("destroying with 64 with blocks open: %.1f ns per instance\n", t / instance_count * 1e9);
+  enigma::dispose_destroyed_instances();
+
+  return sum < 0;
+}